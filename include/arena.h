@@ -0,0 +1,35 @@
+#ifndef SYNTHRAVE_ARENA_H
+#define SYNTHRAVE_ARENA_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ARENA_ALIGN 32u
+
+typedef struct ArenaChunk ArenaChunk;
+
+/**
+ * Bump allocator for memory that shares one lifetime (e.g. all voices of a
+ * render). Allocations are zeroed, ARENA_ALIGN-aligned and released together
+ * by arena_free.
+ */
+typedef struct {
+    ArenaChunk *head;
+    size_t chunk_size;
+    size_t chunk_count; /* one heap allocation each */
+} Arena;
+
+void arena_init(Arena *arena, size_t chunk_size);
+void *arena_alloc(Arena *arena, size_t size);
+/** Bytes held by the arena's chunks. */
+size_t arena_bytes(const Arena *arena);
+void arena_free(Arena *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYNTHRAVE_ARENA_H */
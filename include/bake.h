@@ -0,0 +1,57 @@
+#ifndef SYNTHRAVE_BAKE_H
+#define SYNTHRAVE_BAKE_H
+
+#include "mix_kernels.h"
+#include "resampler.h"
+#include "sequence.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Baked instruments: CHOIR, STRPAD, BELL and EGTR keep the same timbre across
+ * pitches, so instead of running their kernels per voice they can be rendered
+ * once per semitone of the session into a wavetable and played back through a
+ * linear Resampler. Tables are built on first use and kept until
+ * bake_tables_clear(). The pads settle and then loop a crossfaded section of
+ * whole periods; the bell and guitar are one-shots rendered until they have
+ * decayed by 60 dB. None of the four depends on note length, so one table per
+ * pitch covers every duration.
+ */
+typedef struct {
+    float *data;
+    size_t length;     /* frames, including the guard past loop_end */
+    size_t loop_start; /* loop_end == 0: one-shot, silent after the end */
+    size_t loop_end;
+    float frequency;   /* pitch the table was rendered at */
+} BakedTable;
+
+typedef struct {
+    Resampler rs;
+} BakedVoice;
+
+/** Bit for `type` in SequenceOptions.bake_mask. */
+#define BAKE_BIT(type) (1u << (unsigned)(type))
+
+bool bake_supported(SeqSpecType type);
+/** Table for the semitone nearest `frequency`; NULL when out of range. */
+const BakedTable *bake_table_get(SeqSpecType type, float frequency, int sample_rate);
+void bake_tables_clear(void);
+
+/** Returns false (and leaves the voice unset) when no table fits. */
+bool baked_voice_init(BakedVoice *voice, SeqSpecType type, float frequency, int sample_rate);
+void baked_voice_process_mix(BakedVoice *voice, const MixTarget *mix, size_t frames);
+
+/** Parses a comma-separated list such as "choir,bell" or "all". */
+bool bake_parse_list(const char *list, uint32_t *mask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYNTHRAVE_BAKE_H */
@@ -0,0 +1,46 @@
+#ifndef SYNTHRAVE_CONTROL_RATE_H
+#define SYNTHRAVE_CONTROL_RATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Glides, pitch sweeps and amplitude envelopes are evaluated once per control
+ * block and ramped linearly across it, so the audio loops in between only add
+ * a constant step to their phase increments and gains.
+ */
+#define CONTROL_BLOCK_DEFAULT 32u
+#define CONTROL_BLOCK_MAX 4096u
+
+/** Maps a requested control block size (0 = default) into the valid range. */
+static inline size_t control_block_size(size_t requested) {
+    if (requested == 0u) {
+        return CONTROL_BLOCK_DEFAULT;
+    }
+    return requested > CONTROL_BLOCK_MAX ? CONTROL_BLOCK_MAX : requested;
+}
+
+/** Length of the next sub-block when `remaining` frames are left. */
+static inline size_t control_span(size_t block, size_t remaining) {
+    return remaining < block ? remaining : block;
+}
+
+/** Per-sample step that ramps a phase increment from `from` to `to` over n samples. */
+static inline int32_t control_inc_step(uint32_t from, uint32_t to, size_t n) {
+    return (int32_t)(to - from) / (int32_t)n;
+}
+
+/** Per-sample step that ramps a gain from `from` to `to` over n samples. */
+static inline float control_ramp_step(float from, float to, size_t n) {
+    return (to - from) / (float)n;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYNTHRAVE_CONTROL_RATE_H */
@@ -0,0 +1,43 @@
+#ifndef SYNTHRAVE_CPU_DISPATCH_H
+#define SYNTHRAVE_CPU_DISPATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Hot kernels have a portable baseline plus AVX2/AVX-512 versions picked at
+ * runtime, so one binary still uses wide vectors where the host has them.
+ * Simple loops are compiled once per level from a shared always-inline
+ * body; kernels GCC does not vectorize on its own (gathers, lane sums) have
+ * hand-written AVX2 bodies. Set SYNTHRAVE_CPU to baseline, avx2 or avx512
+ * to cap the level (e.g. for testing).
+ */
+typedef enum {
+    CPU_LEVEL_BASELINE = 0,
+    CPU_LEVEL_AVX2,
+    CPU_LEVEL_AVX512
+} CpuLevel;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CPU_MULTIVERSION 1
+#define CPU_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define CPU_TARGET_AVX512 __attribute__((target("avx512f,avx512vl,avx2,fma")))
+#define CPU_INLINE static inline __attribute__((always_inline))
+#else
+#define CPU_MULTIVERSION 0
+#define CPU_INLINE static inline
+#endif
+
+/** Loops in kernel bodies run in multiples of this so -O2 can vectorize them. */
+#define CPU_VECTOR_BLOCK 16u
+
+/** Detected (and possibly capped) level; evaluated once, safe from any thread. */
+CpuLevel cpu_dispatch_level(void);
+const char *cpu_level_name(CpuLevel level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYNTHRAVE_CPU_DISPATCH_H */
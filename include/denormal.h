@@ -0,0 +1,55 @@
+#ifndef SYNTHRAVE_DENORMAL_H
+#define SYNTHRAVE_DENORMAL_H
+
+#include <math.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Decaying envelopes and feedback lines drift into subnormal floats, which
+ * run up to ~100x slower on x86. Render threads enable FTZ/DAZ where the
+ * hardware has it; feedback paths additionally flush tiny values in software
+ * on targets without it, and envelopes are flushed once per block everywhere.
+ */
+#if defined(__SSE__) || defined(__x86_64__) || defined(_M_X64)
+#define DENORMAL_HW_FTZ 1
+#else
+#define DENORMAL_HW_FTZ 0
+#endif
+
+/** Magnitudes below this are inaudible and are treated as zero. */
+#define DENORMAL_THRESHOLD 1e-20f
+
+typedef struct {
+    unsigned int saved;
+} DenormalMode;
+
+/** Enables FTZ/DAZ on the calling thread and remembers the previous mode. */
+void denormal_protect_begin(DenormalMode *mode);
+/** Restores the mode saved by denormal_protect_begin. */
+void denormal_protect_end(const DenormalMode *mode);
+
+/** Software flushing switch; only benchmarks turn it off. */
+extern bool denormal_flush_enabled;
+
+static inline float denormal_flush(float value) {
+    return denormal_flush_enabled && fabsf(value) < DENORMAL_THRESHOLD ? 0.0f : value;
+}
+
+/** Per-sample flush for feedback paths; free where FTZ/DAZ covers it. */
+static inline float denormal_flush_feedback(float value) {
+#if DENORMAL_HW_FTZ
+    return value;
+#else
+    return denormal_flush(value);
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYNTHRAVE_DENORMAL_H */
@@ -0,0 +1,137 @@
+#ifndef SYNTHRAVE_FAST_MATH_H
+#define SYNTHRAVE_FAST_MATH_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Branch-free polynomial approximations of the transcendentals used in
+ * per-sample and per-block loops. Conditionals are bit selects rather than
+ * ?: on floats, which GCC would keep as branches under -ftrapping-math, so
+ * loops calling them vectorize. Max errors against double libm (see
+ * `make mathcheck`):
+ *   fast_sinf   2e-7 absolute for |x| < 1000
+ *   fast_exp2f  3e-7 relative, |x| <= 126
+ *   fast_log2f  1 ulp of the result, normal x > 0
+ *   fast_tanhf  2e-7 absolute
+ *   fast_powf   exp2 error times |y * log2(x)|, x > 0
+ *
+ * The dsp_* wrappers pick the approximation or libm per build:
+ * `make FAST_MATH=0` defines SYNTHRAVE_FAST_MATH=0 and restores libm.
+ * Coefficients computed at init time keep using libm either way.
+ */
+#ifndef SYNTHRAVE_FAST_MATH
+#define SYNTHRAVE_FAST_MATH 1
+#endif
+
+static inline float fast_bits_to_float(uint32_t bits) {
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static inline uint32_t fast_float_to_bits(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+/** cond ? a : b without a branch; cond must be 0 or 1. */
+static inline float fast_select(int32_t cond, float a, float b) {
+    const uint32_t mask = (uint32_t)-cond;
+    return fast_bits_to_float((fast_float_to_bits(a) & mask) | (fast_float_to_bits(b) & ~mask));
+}
+
+/** Nearest integer, for |x| < 2^31. */
+static inline int32_t fast_round_i32(float x) {
+    return (int32_t)(x + copysignf(0.5f, x));
+}
+
+/** sin(x) for |x| < ~1e8: reduced to [-pi/2, pi/2], odd Taylor series to x^11. */
+static inline float fast_sinf(float x) {
+    const float inv_two_pi = 0.159154943f;
+    const float two_pi_hi = 6.28125f;
+    const float two_pi_lo = 1.93530717958e-3f;
+    const float half_pi = 1.57079633f;
+    const float k = (float)fast_round_i32(x * inv_two_pi);
+    float r = (x - k * two_pi_hi) - k * two_pi_lo;
+    /* sin(r) = sin(pi - r): fold |r| above pi/2 back below it */
+    r = copysignf(half_pi - fabsf(half_pi - fabsf(r)), r);
+    const float r2 = r * r;
+    float p = -2.50521084e-8f;
+    p = p * r2 + 2.75573192e-6f;
+    p = p * r2 - 1.98412698e-4f;
+    p = p * r2 + 8.33333333e-3f;
+    p = p * r2 - 1.66666667e-1f;
+    return r + r * r2 * p;
+}
+
+/** 2^x: integer part goes into the exponent, e^(f ln 2) on [-0.5, 0.5] by Taylor to f^6. */
+static inline float fast_exp2f(float x) {
+    x = fast_select(x < -126.0f, -126.0f, x);
+    x = fast_select(x > 126.0f, 126.0f, x);
+    const int32_t i = fast_round_i32(x);
+    const float f = (x - (float)i) * 0.693147181f;
+    float p = 1.38888889e-3f;
+    p = p * f + 8.33333333e-3f;
+    p = p * f + 4.16666667e-2f;
+    p = p * f + 1.66666667e-1f;
+    p = p * f + 0.5f;
+    p = p * f + 1.0f;
+    p = p * f + 1.0f;
+    return p * fast_bits_to_float((uint32_t)(i + 127) << 23);
+}
+
+/** log2(x) for normal x > 0: mantissa in [sqrt(1/2), sqrt(2)), atanh series to t^9. */
+static inline float fast_log2f(float x) {
+    const uint32_t bits = fast_float_to_bits(x);
+    int32_t e = (int32_t)((bits >> 23) & 0xffu) - 127;
+    float m = fast_bits_to_float((bits & 0x007fffffu) | 0x3f800000u);
+    const int32_t high = m > 1.41421356f;
+    m = fast_select(high, m * 0.5f, m);
+    e += high;
+    const float t = (m - 1.0f) / (m + 1.0f);
+    const float t2 = t * t;
+    float p = 0.111111111f;
+    p = p * t2 + 0.142857143f;
+    p = p * t2 + 0.2f;
+    p = p * t2 + 0.333333333f;
+    p = p * t2 + 1.0f;
+    return (float)e + 2.88539008f * t * p;
+}
+
+/** x^y for x > 0. */
+static inline float fast_powf(float x, float y) {
+    return fast_exp2f(y * fast_log2f(x));
+}
+
+/** tanh(x) = (e - 1) / (e + 1) with e = 2^(2x log2 e); saturates beyond |x| = 9. */
+static inline float fast_tanhf(float x) {
+    x = fast_select(x < -9.0f, -9.0f, x);
+    x = fast_select(x > 9.0f, 9.0f, x);
+    const float e = fast_exp2f(x * 2.88539008f);
+    return (e - 1.0f) / (e + 1.0f);
+}
+
+#if SYNTHRAVE_FAST_MATH
+#define dsp_sinf(x) fast_sinf(x)
+#define dsp_exp2f(x) fast_exp2f(x)
+#define dsp_powf(x, y) fast_powf((x), (y))
+#define dsp_tanhf(x) fast_tanhf(x)
+#else
+#define dsp_sinf(x) sinf(x)
+#define dsp_exp2f(x) exp2f(x)
+#define dsp_powf(x, y) powf((x), (y))
+#define dsp_tanhf(x) tanhf(x)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYNTHRAVE_FAST_MATH_H */
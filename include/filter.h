@@ -0,0 +1,191 @@
+#ifndef SYNTHRAVE_FILTER_H
+#define SYNTHRAVE_FILTER_H
+
+#include "cpu_dispatch.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Shared filters for instruments and the mix buses: a transposed direct
+ * form II biquad and a trapezoidal state-variable filter. Coefficients can
+ * glide linearly to a new design over a number of samples, so sweeps do not
+ * need a redesign per sample and do not click. Each type has an inline
+ * per-sample tick for voice kernels, a block call, and a lane form that runs
+ * up to FILTER_LANES voices' filters side by side in SIMD registers.
+ */
+#define FILTER_LANES 8
+
+typedef enum {
+    FILTER_LOWPASS = 0,
+    FILTER_HIGHPASS,
+    FILTER_BANDPASS,
+    FILTER_NOTCH
+} FilterMode;
+
+typedef struct {
+    float b0, b1, b2, a1, a2;
+} BiquadCoeffs;
+
+typedef struct {
+    BiquadCoeffs c;
+    BiquadCoeffs step; /* added to c per sample while ramp > 0 */
+    uint32_t ramp;
+    float z1, z2;
+} Biquad;
+
+/** RBJ cookbook design; q of 0.7071 gives a Butterworth response. */
+BiquadCoeffs biquad_design(FilterMode mode, float cutoff, float q, float sample_rate);
+void biquad_init(Biquad *f, BiquadCoeffs c);
+/** Glides to `target` over the next `frames` samples; 0 jumps at once. */
+void biquad_ramp_to(Biquad *f, BiquadCoeffs target, uint32_t frames);
+void biquad_process(Biquad *f, float *buf, size_t frames);
+
+static inline float biquad_tick(Biquad *f, float x) {
+    if (f->ramp != 0u) {
+        f->c.b0 += f->step.b0;
+        f->c.b1 += f->step.b1;
+        f->c.b2 += f->step.b2;
+        f->c.a1 += f->step.a1;
+        f->c.a2 += f->step.a2;
+        --f->ramp;
+    }
+    const float y = f->c.b0 * x + f->z1;
+    f->z1 = f->c.b1 * x - f->c.a1 * y + f->z2;
+    f->z2 = f->c.b2 * x - f->c.a2 * y;
+    return y;
+}
+
+/**
+ * Integer biquad for Q20 (QMIX_BITS) mix buses in fixed-point builds: the
+ * same transposed form with Q28 coefficients and 64-bit state, so filtering
+ * needs no FPU. Only the design is float.
+ */
+typedef struct {
+    int32_t b0, b1, b2, a1, a2;
+    int64_t z1, z2;
+} BiquadQ;
+
+void biquad_q_init(BiquadQ *f, BiquadCoeffs c);
+void biquad_q_process(BiquadQ *f, int32_t *buf, size_t frames);
+
+/* Simper's trapezoidal SVF: g = tan(pi fc / fs), k = 1 / q. */
+typedef struct {
+    float a1, a2, a3; /* integrator coefficients */
+    float m0, m1, m2; /* output mix of input, band and low */
+} SvfCoeffs;
+
+typedef struct {
+    SvfCoeffs c;
+    SvfCoeffs step;
+    uint32_t ramp;
+    float ic1, ic2;
+} Svf;
+
+SvfCoeffs svf_design(FilterMode mode, float cutoff, float q, float sample_rate);
+void svf_init(Svf *f, SvfCoeffs c);
+void svf_ramp_to(Svf *f, SvfCoeffs target, uint32_t frames);
+void svf_process(Svf *f, float *buf, size_t frames);
+
+static inline float svf_tick(Svf *f, float x) {
+    if (f->ramp != 0u) {
+        f->c.a1 += f->step.a1;
+        f->c.a2 += f->step.a2;
+        f->c.a3 += f->step.a3;
+        f->c.m0 += f->step.m0;
+        f->c.m1 += f->step.m1;
+        f->c.m2 += f->step.m2;
+        --f->ramp;
+    }
+    const float v3 = x - f->ic2;
+    const float v1 = f->c.a1 * f->ic1 + f->c.a2 * v3;
+    const float v2 = f->ic2 + f->c.a2 * f->ic1 + f->c.a3 * v3;
+    f->ic1 = 2.0f * v1 - f->ic1;
+    f->ic2 = 2.0f * v2 - f->ic2;
+    return f->c.m0 * x + f->c.m1 * v1 + f->c.m2 * v2;
+}
+
+/*
+ * Lane form: lane k holds one voice's filter. Ramps count down per lane and
+ * multiply the step by 0 or 1 instead of branching, so the tick stays a
+ * straight-line loop over FILTER_LANES that the compiler vectorizes. Idle
+ * lanes load with zero coefficients and output silence. Ramps longer than
+ * 2^24 samples are cut short there.
+ */
+typedef struct {
+    float b0[FILTER_LANES], b1[FILTER_LANES], b2[FILTER_LANES];
+    float a1[FILTER_LANES], a2[FILTER_LANES];
+    float sb0[FILTER_LANES], sb1[FILTER_LANES], sb2[FILTER_LANES];
+    float sa1[FILTER_LANES], sa2[FILTER_LANES];
+    float ramp[FILTER_LANES];
+    float z1[FILTER_LANES], z2[FILTER_LANES];
+} BiquadLanes;
+
+typedef struct {
+    float a1[FILTER_LANES], a2[FILTER_LANES], a3[FILTER_LANES];
+    float m0[FILTER_LANES], m1[FILTER_LANES], m2[FILTER_LANES];
+    float sa1[FILTER_LANES], sa2[FILTER_LANES], sa3[FILTER_LANES];
+    float sm0[FILTER_LANES], sm1[FILTER_LANES], sm2[FILTER_LANES];
+    float ramp[FILTER_LANES];
+    float ic1[FILTER_LANES], ic2[FILTER_LANES];
+} SvfLanes;
+
+void biquad_lanes_load(BiquadLanes *l, Biquad *const *filters, size_t count);
+void biquad_lanes_store(const BiquadLanes *l, Biquad *const *filters, size_t count);
+void svf_lanes_load(SvfLanes *l, Svf *const *filters, size_t count);
+void svf_lanes_store(const SvfLanes *l, Svf *const *filters, size_t count);
+
+/** Filters one sample per lane in place. */
+CPU_INLINE void biquad_lanes_tick(BiquadLanes *l, float *x) {
+    for (size_t k = 0; k < FILTER_LANES; ++k) {
+        const float on = l->ramp[k] < 1.0f ? l->ramp[k] : 1.0f;
+        l->b0[k] += l->sb0[k] * on;
+        l->b1[k] += l->sb1[k] * on;
+        l->b2[k] += l->sb2[k] * on;
+        l->a1[k] += l->sa1[k] * on;
+        l->a2[k] += l->sa2[k] * on;
+        l->ramp[k] -= on;
+        const float in = x[k];
+        const float y = l->b0[k] * in + l->z1[k];
+        l->z1[k] = l->b1[k] * in - l->a1[k] * y + l->z2[k];
+        l->z2[k] = l->b2[k] * in - l->a2[k] * y;
+        x[k] = y;
+    }
+}
+
+CPU_INLINE void svf_lanes_tick(SvfLanes *l, float *x) {
+    for (size_t k = 0; k < FILTER_LANES; ++k) {
+        const float on = l->ramp[k] < 1.0f ? l->ramp[k] : 1.0f;
+        l->a1[k] += l->sa1[k] * on;
+        l->a2[k] += l->sa2[k] * on;
+        l->a3[k] += l->sa3[k] * on;
+        l->m0[k] += l->sm0[k] * on;
+        l->m1[k] += l->sm1[k] * on;
+        l->m2[k] += l->sm2[k] * on;
+        l->ramp[k] -= on;
+        const float in = x[k];
+        const float v3 = in - l->ic2[k];
+        const float v1 = l->a1[k] * l->ic1[k] + l->a2[k] * v3;
+        const float v2 = l->ic2[k] + l->a2[k] * l->ic1[k] + l->a3[k] * v3;
+        l->ic1[k] = 2.0f * v1 - l->ic1[k];
+        l->ic2[k] = 2.0f * v2 - l->ic2[k];
+        x[k] = l->m0[k] * in + l->m1[k] * v1 + l->m2[k] * v2;
+    }
+}
+
+/**
+ * Runs filters[v] over bufs[v] in place for `count` voices, FILTER_LANES at
+ * a time. Runtime-dispatched per CPU level.
+ */
+void biquad_bank_process(Biquad *const *filters, float *const *bufs, size_t count, size_t frames);
+void svf_bank_process(Svf *const *filters, float *const *bufs, size_t count, size_t frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYNTHRAVE_FILTER_H */
@@ -0,0 +1,97 @@
+#ifndef SYNTHRAVE_FIXED_POINT_H
+#define SYNTHRAVE_FIXED_POINT_H
+
+#include <stdint.h>
+
+#include "oscillator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Q15/Q31 helpers for the integer render path of the SynthEngine (voices,
+ * envelopes, track mix, soft clip and s16 interleave), meant for targets
+ * without a fast FPU. Floats only appear when a note starts (stage lengths,
+ * pitch) and when tables are built. `make FIXED_POINT=1` defines
+ * SYNTHRAVE_FIXED_POINT=1, which makes synth_engine_render_s16() take this
+ * path and synthrave playback mix through scheduler_render_document_q();
+ * `make fixedcheck` reports both against the float path.
+ *
+ * Formats: waveforms and gains are Q15 in int32_t, envelopes Q31, and
+ * voice/track/mix samples Q20 (QMIX_BITS), which leaves 11 bits of
+ * headroom above full scale for summing voices.
+ */
+#ifndef SYNTHRAVE_FIXED_POINT
+#define SYNTHRAVE_FIXED_POINT 0
+#endif
+
+#define Q15_ONE 32767
+#define Q31_ONE INT32_MAX
+#define QMIX_BITS 20
+
+/** Q15 sine table matching osc_sine_table; filled by osc_tables_init(). */
+extern int16_t osc_sine_table_q15[OSC_TABLE_SIZE + 1];
+
+/** tanh over 0..Q_TANH_RANGE in Q15, Q_TANH_STEPS entries per unit. */
+#define Q_TANH_STEPS 128
+#define Q_TANH_RANGE 8
+extern int16_t q_tanh_table[Q_TANH_STEPS * Q_TANH_RANGE + 1];
+
+/** Fills the soft-clip table; safe to call repeatedly. */
+void fixed_tables_init(void);
+
+static inline int32_t q_from_float(float x, int bits) {
+    const float scaled = x * (float)(1u << bits);
+    if (scaled >= 2147483647.0f) {
+        return INT32_MAX;
+    }
+    if (scaled <= -2147483648.0f) {
+        return INT32_MIN;
+    }
+    return (int32_t)(scaled < 0.0f ? scaled - 0.5f : scaled + 0.5f);
+}
+
+/** (a * b) >> shift with a 64-bit product (one long multiply on 32-bit ARM). */
+static inline int32_t q_mul(int32_t a, int32_t b, int shift) {
+    return (int32_t)(((int64_t)a * (int64_t)b) >> shift);
+}
+
+static inline int16_t q15_saturate(int32_t x) {
+    return (int16_t)(x > 32767 ? 32767 : (x < -32768 ? -32768 : x));
+}
+
+/** Interpolated Q15 sine of a 32-bit phase, like osc_sine(). */
+static inline int32_t osc_sine_q15(uint32_t phase) {
+    const uint32_t idx = phase >> OSC_FRAC_BITS;
+    const int32_t frac = (int32_t)((phase >> (OSC_FRAC_BITS - 15)) & 0x7fffu);
+    const int32_t a = osc_sine_table_q15[idx];
+    const int32_t b = osc_sine_table_q15[idx + 1u];
+    return a + (((b - a) * frac) >> 15);
+}
+
+/** Rising Q15 saw, like osc_saw(). */
+static inline int32_t osc_saw_q15(uint32_t phase) {
+    return (int32_t)(phase ^ OSC_HALF_CYCLE) >> 16;
+}
+
+/** tanh soft clip of a Q20 sample to Q15, interpolating q_tanh_table. */
+static inline int32_t q_soft_clip(int32_t x) {
+    const int shift = QMIX_BITS - 7; /* 2^7 == Q_TANH_STEPS */
+    const int32_t limit = (int32_t)Q_TANH_RANGE << QMIX_BITS;
+    const int32_t ax = x < 0 ? (x <= -limit ? limit : -x) : (x >= limit ? limit : x);
+    int32_t y = Q15_ONE;
+    if (ax < limit) {
+        const int32_t idx = ax >> shift;
+        const int32_t frac = ax & ((1 << shift) - 1);
+        const int32_t a = q_tanh_table[idx];
+        y = a + (((q_tanh_table[idx + 1] - a) * frac) >> shift);
+    }
+    return x < 0 ? -y : y;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYNTHRAVE_FIXED_POINT_H */
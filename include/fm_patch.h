@@ -0,0 +1,19 @@
+#ifndef SYNTHRAVE_FM_PATCH_H
+#define SYNTHRAVE_FM_PATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Patches for the FM voice; SeqSpec.patch selects one. */
+typedef enum {
+    FM_PATCH_EPIANO = 0,
+    FM_PATCH_BASS,
+    FM_PATCH_COUNT
+} FmPatch;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYNTHRAVE_FM_PATCH_H */
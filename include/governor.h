@@ -0,0 +1,62 @@
+#ifndef SYNTHRAVE_GOVERNOR_H
+#define SYNTHRAVE_GOVERNOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Quality governor for the block mixer. It times every block against the
+ * audio it produced and, while the smoothed load stays above the budget,
+ * steps one level down per GOVERNOR_HOLD_BLOCKS; once the load falls below
+ * half the budget it steps back up, more slowly so it does not oscillate.
+ * Levels are cumulative, and all but GOVERNOR_SLOW_CONTROL only affect
+ * voices that start afterwards, so no running note changes timbre mid-way.
+ */
+typedef enum {
+    GOVERNOR_FULL = 0,
+    GOVERNOR_FEWER_PARTIALS,  /* partial banks drop half their lane groups */
+    GOVERNOR_LINEAR_RESAMPLE, /* samples read linearly instead of through sinc */
+    GOVERNOR_SLOW_CONTROL,    /* control blocks GOVERNOR_CONTROL_FACTOR times longer */
+    GOVERNOR_CULL,            /* quiet voices are not started */
+    GOVERNOR_LEVEL_COUNT
+} GovernorLevel;
+
+#define GOVERNOR_HOLD_BLOCKS 8u
+#define GOVERNOR_RECOVER_BLOCKS 64u
+#define GOVERNOR_CONTROL_FACTOR 4u
+/** At GOVERNOR_CULL, voices below this fraction of the loudest one are dropped. */
+#define GOVERNOR_CULL_RATIO 0.25f
+
+typedef struct {
+    float budget; /* render seconds allowed per audio second; 0 = off */
+    float load;   /* smoothed render seconds per audio second */
+    GovernorLevel level;
+    unsigned int hold; /* blocks before the level may change again */
+    int sample_rate;
+    size_t frames; /* audio rendered so far, for the log */
+    size_t culled;
+    struct timespec block_start;
+} QualityGovernor;
+
+void governor_init(QualityGovernor *g, float budget, int sample_rate);
+void governor_block_begin(QualityGovernor *g);
+/** Folds the block's render time into the load; logs and returns true on a level change. */
+bool governor_block_end(QualityGovernor *g, size_t frames);
+/** Prints the final level and the number of culled voices if the governor acted. */
+void governor_report(const QualityGovernor *g);
+const char *governor_level_name(GovernorLevel level);
+
+static inline bool governor_at(const QualityGovernor *g, GovernorLevel level) {
+    return g != NULL && g->level >= level;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYNTHRAVE_GOVERNOR_H */
@@ -1,7 +1,9 @@
 #ifndef SYNTHRAVE_INSTRUMENT_H
 #define SYNTHRAVE_INSTRUMENT_H
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -29,6 +31,55 @@ float synth_instrument_sample(const SynthInstrument *instrument,
                               float time_since_start,
                               float note_duration);
 
+typedef enum {
+    SYNTH_ENV_ATTACK = 0,
+    SYNTH_ENV_DECAY,
+    SYNTH_ENV_SUSTAIN,
+    SYNTH_ENV_RELEASE,
+    SYNTH_ENV_DONE
+} SynthEnvStage;
+
+/**
+ * Block-rendered note of a SynthInstrument. The ADSR is a stage machine
+ * that adds a fixed step per sample within each stage, and the waveform
+ * runs from a 32-bit phase accumulator, so neither cost nor precision
+ * depends on how far into the note or the song a sample lies. The *_q
+ * fields carry the same envelope in Q31 for synth_voice_render_q(); a voice
+ * is rendered through one of the two paths only.
+ */
+typedef struct {
+    SynthInstrumentKind kind;
+    uint32_t phase;
+    uint32_t inc;
+    SynthEnvStage stage;
+    uint32_t stage_left;                  /* samples until the next stage */
+    uint32_t stage_len[SYNTH_ENV_DONE];   /* samples per stage from the start offset on */
+    float env;
+    float step;                           /* env change per sample in this stage */
+    float sustain;
+    float gain;                           /* note velocity */
+    int32_t env_q;                        /* Q31 */
+    int32_t step_q;
+    int32_t sustain_q;
+    int32_t gain_q;                       /* Q15 */
+} SynthVoice;
+
+/**
+ * Starts a note `start_offset` seconds after its onset (0 for a fresh note,
+ * more when rendering begins mid-note), sampled at `sample_rate`.
+ */
+void synth_voice_init(SynthVoice *voice,
+                      const SynthInstrument *instrument,
+                      float frequency,
+                      float note_duration,
+                      float velocity,
+                      float start_offset,
+                      float sample_rate);
+/** Adds `frames` samples to `out`; returns false once the release has ended. */
+bool synth_voice_render(SynthVoice *voice, float *out, size_t frames);
+/** Integer-only twin of synth_voice_render: adds Q20 samples (see fixed_point.h). */
+bool synth_voice_render_q(SynthVoice *voice, int32_t *out, size_t frames);
+
 #ifdef __cplusplus
 }
 #endif
@@ -2,6 +2,12 @@
 #define SYNTHRAVE_INSTRUMENTS_EXT_H
 
 #include <stddef.h>
+#include <stdint.h>
+
+#include "filter.h"
+#include "fm_patch.h"
+#include "mix_kernels.h"
+#include "partial_bank.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -11,83 +17,218 @@ extern "C" {
 typedef struct {
     float sample_rate;
     float block_duration;
+    size_t control_block; /* samples per parameter update, 0 = default */
 } SynthBlockConfig;
 
+/**
+ * Lane count of the oscillator *_bank_process kernels. They render many
+ * voices of one type per call: states are gathered into structure-of-arrays
+ * lanes, idle lanes are padded, and outs[v] receives voice v.
+ */
+#define VOICE_BANK_WIDTH 8
+
+/*
+ * Every *_process kernel overwrites `out`. Its *_process_mix twin runs the
+ * same loop but adds each sample into the MixTarget's buses (with the
+ * target's gain, pan and ramp), so a voice mixes without a scratch buffer.
+ * The bank kernels have *_bank_process_mix twins taking one target per voice.
+ *
+ * The *_init functions take the sample rate and every per-voice parameter
+ * up front and precompute phase increments, decay multipliers and detune
+ * ratios, so the *_process loops only multiply and add.
+ */
+
 /** Laser-style FX sweep. */
 typedef struct {
     float base_frequency;
     float target_frequency;
-    float phase;
+    uint32_t phase;
+    uint32_t resonant_phase;
+    uint32_t inc;
+    uint32_t resonant_inc;
     float sweep_pos;
+    float sweep_rate;
     float resonance;
+    float base_inc;
+    float target_inc;
 } LaserSynthState;
 
-void laser_synth_init(LaserSynthState *state, float start_freq, float end_freq, float resonance);
+void laser_synth_init(LaserSynthState *state,
+                      float sample_rate,
+                      float start_freq,
+                      float end_freq,
+                      float resonance,
+                      float duration_s);
 void laser_synth_process(LaserSynthState *state,
                          const SynthBlockConfig *cfg,
                          float *out,
                          size_t frames);
+void laser_synth_process_mix(LaserSynthState *state,
+                             const SynthBlockConfig *cfg,
+                             const MixTarget *mix,
+                             size_t frames);
 
 /** Choir pad built from multiple detuned sines. */
 typedef struct {
     float root_frequency;
     float detune_cents[3];
-    float phases[4];
+    PartialBank partials;
     float envelope;
+    float env_attack;
+    float env_release;
 } ChoirSynthState;
 
-void choir_synth_init(ChoirSynthState *state, float root_frequency);
+void choir_synth_init(ChoirSynthState *state,
+                      float sample_rate,
+                      float root_frequency,
+                      float softness);
 void choir_synth_process(ChoirSynthState *state,
                          const SynthBlockConfig *cfg,
-                         float softness,
                          float *out,
                          size_t frames);
+void choir_synth_process_mix(ChoirSynthState *state,
+                             const SynthBlockConfig *cfg,
+                             const MixTarget *mix,
+                             size_t frames);
 
 /** Analog-style lead with mild portamento between targets. */
 typedef struct {
     float current_frequency;
     float target_frequency;
     float glide_rate;
-    float phase;
+    uint32_t phase;
+    uint32_t inc;
+    float inc_scale;
 } AnalogLeadState;
 
-void analog_lead_init(AnalogLeadState *state, float start_frequency, float glide_rate);
+void analog_lead_init(AnalogLeadState *state,
+                      float sample_rate,
+                      float start_frequency,
+                      float glide_rate);
 void analog_lead_set_target(AnalogLeadState *state, float target_frequency);
 void analog_lead_process(AnalogLeadState *state,
                          const SynthBlockConfig *cfg,
                          float *out,
                          size_t frames);
+void analog_lead_process_mix(AnalogLeadState *state,
+                             const SynthBlockConfig *cfg,
+                             const MixTarget *mix,
+                             size_t frames);
+void analog_lead_bank_process(AnalogLeadState *const *states,
+                              size_t count,
+                              const SynthBlockConfig *cfg,
+                              float *const *outs,
+                              size_t frames);
+void analog_lead_bank_process_mix(AnalogLeadState *const *states,
+                                  size_t count,
+                                  const SynthBlockConfig *cfg,
+                                  const MixTarget *mixes,
+                                  size_t frames);
 
 /** SID-inspired bass with stepped volume envelope. */
 typedef struct {
     float frequency;
-    float phase;
+    uint32_t phase;
+    uint32_t phase_inc;
     float step_duration;
     float time_in_step;
+    float time_step;
+    float step_gain;
     int step_index;
 } SidBassState;
 
-void sid_bass_init(SidBassState *state, float frequency, float step_duration_ms);
+void sid_bass_init(SidBassState *state,
+                   float sample_rate,
+                   float frequency,
+                   float step_duration_ms);
 void sid_bass_process(SidBassState *state,
                       const SynthBlockConfig *cfg,
                       float *out,
                       size_t frames);
+void sid_bass_process_mix(SidBassState *state,
+                          const SynthBlockConfig *cfg,
+                          const MixTarget *mix,
+                          size_t frames);
+void sid_bass_bank_process(SidBassState *const *states,
+                           size_t count,
+                           const SynthBlockConfig *cfg,
+                           float *const *outs,
+                           size_t frames);
+void sid_bass_bank_process_mix(SidBassState *const *states,
+                               size_t count,
+                               const SynthBlockConfig *cfg,
+                               const MixTarget *mixes,
+                               size_t frames);
 
 /** Chip-arp generator that rotates up to four notes. */
 typedef struct {
     float notes_hz[4];
+    uint32_t note_incs[4];
     size_t note_count;
     size_t current_note;
-    float phase;
+    uint32_t phase;
     float tick_duration;
     float tick_time;
+    float time_step;
 } ChipArpState;
 
-void chip_arp_init(ChipArpState *state, const float *notes_hz, size_t note_count, float tick_ms);
+void chip_arp_init(ChipArpState *state,
+                   float sample_rate,
+                   const float *notes_hz,
+                   size_t note_count,
+                   float tick_ms);
 void chip_arp_process(ChipArpState *state,
                       const SynthBlockConfig *cfg,
                       float *out,
                       size_t frames);
+void chip_arp_process_mix(ChipArpState *state,
+                          const SynthBlockConfig *cfg,
+                          const MixTarget *mix,
+                          size_t frames);
+
+#define FM_OPERATORS 4
+/* Modulation routes j -> k for j > k, stored (0,1) (0,2) (0,3) (1,2) (1,3) (2,3). */
+#define FM_ROUTES 6
+
+/**
+ * Four sine operators with table lookups. Operator 3 feeds back into
+ * itself, and every operator's phase is pushed by the weighted outputs of
+ * the operators above it (in cycles). Each operator level glides
+ * exponentially from its peak to a sustain level, and the carrier weights
+ * mix the operators to the output. The patch decides ratios, routes and
+ * envelopes.
+ */
+typedef struct {
+    uint32_t phase[FM_OPERATORS];
+    uint32_t inc[FM_OPERATORS];
+    float level[FM_OPERATORS];
+    float sustain[FM_OPERATORS];
+    float decay[FM_OPERATORS];
+    float carrier[FM_OPERATORS];
+    float route[FM_ROUTES];
+    float feedback;
+    float last; /* operator 3's previous output */
+} FmState;
+
+void fm_state_init(FmState *state, float sample_rate, float frequency, int patch);
+void fm_process(FmState *state,
+                const SynthBlockConfig *cfg,
+                float *out,
+                size_t frames);
+void fm_process_mix(FmState *state,
+                    const SynthBlockConfig *cfg,
+                    const MixTarget *mix,
+                    size_t frames);
+void fm_bank_process(FmState *const *states,
+                     size_t count,
+                     const SynthBlockConfig *cfg,
+                     float *const *outs,
+                     size_t frames);
+void fm_bank_process_mix(FmState *const *states,
+                         size_t count,
+                         const SynthBlockConfig *cfg,
+                         const MixTarget *mixes,
+                         size_t frames);
 
 #ifdef __cplusplus
 }
@@ -97,170 +238,306 @@ void chip_arp_process(ChipArpState *state,
 
 /** Legacy percussion and melodic instrument states. */
 typedef struct {
-    float phase;
+    uint32_t phase;
+    uint32_t inc;
     float sweep_pos;
-    float body_phase;
+    float sweep_rate;
+    float start_inc;
+    float end_inc;
+    float body_env;
+    float body_decay;
+    float body_floor;
     float click_env;
+    float attack;
+    float attack_step;
 } KickState;
 
-void kick_state_init(KickState *state);
+void kick_state_init(KickState *state,
+                     float sample_rate,
+                     float start_freq,
+                     float end_freq,
+                     float duration_s);
 void kick_process(KickState *state,
                   const SynthBlockConfig *cfg,
-                  float start_freq,
-                  float end_freq,
-                  float duration_s,
                   float *out,
                   size_t frames);
+void kick_process_mix(KickState *state,
+                      const SynthBlockConfig *cfg,
+                      const MixTarget *mix,
+                      size_t frames);
 
 typedef struct {
-    float noise_seed;
-    float body_phase;
+    Biquad noise_hp;
+    uint32_t body_phase;
+    uint32_t body_inc;
     float env_noise;
     float env_body;
+    float noise_decay;
+    float body_decay;
 } SnareState;
 
-void snare_state_init(SnareState *state);
+void snare_state_init(SnareState *state,
+                      float sample_rate,
+                      float body_freq,
+                      float duration_s);
 void snare_process(SnareState *state,
                    const SynthBlockConfig *cfg,
-                   float body_freq,
-                   float duration_s,
                    float *out,
                    size_t frames);
+void snare_process_mix(SnareState *state,
+                       const SynthBlockConfig *cfg,
+                       const MixTarget *mix,
+                       size_t frames);
 
 typedef struct {
-    float noise_seed;
-    float metallic_phase;
+    Biquad noise_hp;
+    uint32_t metallic_phase;
+    uint32_t metallic_inc;
     float env;
+    float decay;
 } HatState;
 
-void hat_state_init(HatState *state);
+void hat_state_init(HatState *state, float sample_rate);
 void hat_process(HatState *state,
                  const SynthBlockConfig *cfg,
                  float *out,
                  size_t frames);
+void hat_process_mix(HatState *state,
+                     const SynthBlockConfig *cfg,
+                     const MixTarget *mix,
+                     size_t frames);
 
 typedef struct {
-    float phase_main;
-    float phase_sub;
-    float filter_state;
+    uint32_t phase_main;
+    uint32_t phase_sub;
+    uint32_t main_inc;
+    uint32_t sub_inc;
+    Biquad filter;
 } BassState;
 
-void bass_state_init(BassState *state);
+void bass_state_init(BassState *state, float sample_rate, float frequency);
 void bass_process(BassState *state,
                   const SynthBlockConfig *cfg,
-                  float frequency,
                   float *out,
                   size_t frames);
+void bass_process_mix(BassState *state,
+                      const SynthBlockConfig *cfg,
+                      const MixTarget *mix,
+                      size_t frames);
+void bass_bank_process(BassState *const *states,
+                       size_t count,
+                       const SynthBlockConfig *cfg,
+                       float *const *outs,
+                       size_t frames);
+void bass_bank_process_mix(BassState *const *states,
+                           size_t count,
+                           const SynthBlockConfig *cfg,
+                           const MixTarget *mixes,
+                           size_t frames);
 
 typedef struct {
-    float phase_fund;
-    float phase_detune;
+    uint32_t phase_fund;
+    uint32_t phase_detune;
+    uint32_t fund_inc;
+    uint32_t detune_inc;
     float breath_env;
 } FluteState;
 
-void flute_state_init(FluteState *state);
+void flute_state_init(FluteState *state, float sample_rate, float frequency);
 void flute_process(FluteState *state,
                    const SynthBlockConfig *cfg,
-                   float frequency,
                    float *out,
                    size_t frames);
+void flute_process_mix(FluteState *state,
+                       const SynthBlockConfig *cfg,
+                       const MixTarget *mix,
+                       size_t frames);
+void flute_bank_process(FluteState *const *states,
+                        size_t count,
+                        const SynthBlockConfig *cfg,
+                        float *const *outs,
+                        size_t frames);
+void flute_bank_process_mix(FluteState *const *states,
+                            size_t count,
+                            const SynthBlockConfig *cfg,
+                            const MixTarget *mixes,
+                            size_t frames);
 
 typedef struct {
-    float overtone_envs[4];
-    float phases[4];
+    PartialBank partials;
 } PianoState;
 
-void piano_state_init(PianoState *state);
+void piano_state_init(PianoState *state, float sample_rate, float base_frequency);
 void piano_process(PianoState *state,
                    const SynthBlockConfig *cfg,
-                   float base_frequency,
                    float *out,
                    size_t frames);
-
+void piano_process_mix(PianoState *state,
+                       const SynthBlockConfig *cfg,
+                       const MixTarget *mix,
+                       size_t frames);
+
+/**
+ * Karplus-Strong string. The delay line is caller-provided with a
+ * power-of-two length (see ks_delay_length) so indices wrap with a mask;
+ * a first-order allpass supplies the fractional part of the loop delay.
+ */
 typedef struct {
-    float last_output;
-    float delay_line[128];
-    size_t delay_index;
+    float *delay_line;
+    uint32_t mask;
+    uint32_t write_pos;
+    uint32_t delay;
+    float allpass_coeff;
+    float allpass_in;
+    float allpass_out;
     float damping;
 } KarplusStrongState;
 
-void ks_state_init(KarplusStrongState *state, float damping, size_t delay_samples);
+#define KS_BANK_WIDTH 4
+
+/** Delay line length (a power of two) needed for a pluck at this frequency. */
+size_t ks_delay_length(float sample_rate, float frequency);
+/**
+ * Fills the delay line with noise from `seed`'s own generator rather than
+ * rand(), so a pluck sounds the same whenever its voice is created.
+ */
+void ks_state_init(KarplusStrongState *state,
+                   float *delay_line,
+                   size_t line_length,
+                   float sample_rate,
+                   float frequency,
+                   float damping,
+                   uint32_t seed);
 void ks_process(KarplusStrongState *state,
                 const SynthBlockConfig *cfg,
                 float excitation_noise,
                 float *out,
                 size_t frames);
+void ks_process_mix(KarplusStrongState *state,
+                    const SynthBlockConfig *cfg,
+                    float excitation_noise,
+                    const MixTarget *mix,
+                    size_t frames);
+/** Renders count plucks side by side, KS_BANK_WIDTH lanes at a time. */
+void ks_bank_process(KarplusStrongState *const *states,
+                     size_t count,
+                     const SynthBlockConfig *cfg,
+                     float excitation_noise,
+                     float *const *outs,
+                     size_t frames);
+void ks_bank_process_mix(KarplusStrongState *const *states,
+                         size_t count,
+                         const SynthBlockConfig *cfg,
+                         float excitation_noise,
+                         const MixTarget *mixes,
+                         size_t frames);
 
 typedef struct {
-    float phase;
-    float vibrato_phase;
+    uint32_t phase;
+    uint32_t vibrato_phase;
+    uint32_t inc;
+    uint32_t vibrato_inc;
     float env;
+    float decay;
+    float drive;
 } EgtrState;
 
-void egtr_state_init(EgtrState *state);
+void egtr_state_init(EgtrState *state, float sample_rate, float frequency, float drive);
 void egtr_process(EgtrState *state,
                   const SynthBlockConfig *cfg,
-                  float frequency,
-                  float drive,
                   float *out,
                   size_t frames);
+void egtr_process_mix(EgtrState *state,
+                      const SynthBlockConfig *cfg,
+                      const MixTarget *mix,
+                      size_t frames);
 
 typedef struct {
     float noise_seed;
-    float chirp_phase;
+    uint32_t chirp_phase;
+    float chirp_base;
+    float chirp_spread;
     float env;
+    float decay;
 } BirdsState;
 
-void birds_state_init(BirdsState *state);
+void birds_state_init(BirdsState *state, float sample_rate);
 void birds_process(BirdsState *state,
                    const SynthBlockConfig *cfg,
                    float *out,
                    size_t frames);
+void birds_process_mix(BirdsState *state,
+                       const SynthBlockConfig *cfg,
+                       const MixTarget *mix,
+                       size_t frames);
 
 typedef struct {
-    float phases[3];
+    PartialBank partials;
     float env;
+    float attack;
+    float release;
 } StrPadState;
 
-void strpad_state_init(StrPadState *state);
+void strpad_state_init(StrPadState *state, float sample_rate, float base_frequency);
 void strpad_process(StrPadState *state,
                     const SynthBlockConfig *cfg,
-                    float base_frequency,
                     float *out,
                     size_t frames);
+void strpad_process_mix(StrPadState *state,
+                        const SynthBlockConfig *cfg,
+                        const MixTarget *mix,
+                        size_t frames);
 
 typedef struct {
-    float phases[4];
-    float env;
+    PartialBank partials;
 } BellState;
 
-void bell_state_init(BellState *state);
+void bell_state_init(BellState *state, float sample_rate, float base_frequency);
 void bell_process(BellState *state,
                   const SynthBlockConfig *cfg,
-                  float base_frequency,
                   float *out,
                   size_t frames);
+void bell_process_mix(BellState *state,
+                      const SynthBlockConfig *cfg,
+                      const MixTarget *mix,
+                      size_t frames);
 
 typedef struct {
-    float phase;
-    float lip_filter;
+    uint32_t phase;
+    uint32_t inc;
+    Biquad lip_filter;
     float env;
+    float attack;
+    float release;
 } BrassState;
 
-void brass_state_init(BrassState *state);
+void brass_state_init(BrassState *state, float sample_rate, float frequency);
 void brass_process(BrassState *state,
                    const SynthBlockConfig *cfg,
-                   float frequency,
                    float *out,
                    size_t frames);
+void brass_process_mix(BrassState *state,
+                       const SynthBlockConfig *cfg,
+                       const MixTarget *mix,
+                       size_t frames);
 
 typedef struct {
     KarplusStrongState ks;
 } KalimbaState;
 
-void kalimba_state_init(KalimbaState *state, size_t delay_samples);
+void kalimba_state_init(KalimbaState *state,
+                        float *delay_line,
+                        size_t line_length,
+                        float sample_rate,
+                        float frequency,
+                        uint32_t seed);
 void kalimba_process(KalimbaState *state,
                      const SynthBlockConfig *cfg,
                      float excitation,
                      float *out,
                      size_t frames);
+void kalimba_process_mix(KalimbaState *state,
+                         const SynthBlockConfig *cfg,
+                         float excitation,
+                         const MixTarget *mix,
+                         size_t frames);
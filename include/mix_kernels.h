@@ -0,0 +1,73 @@
+#ifndef SYNTHRAVE_MIX_KERNELS_H
+#define SYNTHRAVE_MIX_KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Where an accumulating kernel (the *_mix APIs) adds its output. Sample i of
+ * a call lands in bus[c][i] scaled by gain[c] + i * step[c], so a non-zero
+ * step ramps the gain across the call for fades. bus[1] may be NULL for a
+ * voice that feeds a single channel; bus[0] is always set.
+ */
+typedef struct {
+    float *bus[2];
+    float gain[2];
+    float step[2];
+} MixTarget;
+
+/** Constant gain into one bus. */
+MixTarget mix_target_mono(float *bus, float gain);
+/** Constant gains into a stereo pair; a bus whose gain is 0 is left out. */
+MixTarget mix_target_stereo(float *left, float *right, const float gains[2]);
+/**
+ * Left/right gains for a mono source at pan in [-1, 1]. Linear law: the
+ * centre keeps unity on both sides and a hard pan silences the far one.
+ */
+void mix_pan_gains(float gain, float pan, float gains[2]);
+
+/** The same target for a call that starts `frames` samples later. */
+MixTarget mix_target_advance(const MixTarget *t, size_t frames);
+
+/** Adds sample i of a call through the target. */
+static inline void mix_target_add(const MixTarget *t, size_t i, float v) {
+    const float x = (float)(int32_t)i;
+    t->bus[0][i] += v * (t->gain[0] + t->step[0] * x);
+    if (t->bus[1] != NULL) {
+        t->bus[1][i] += v * (t->gain[1] + t->step[1] * x);
+    }
+}
+
+/** dst[i] += src[i] (voice accumulate into a mix bus). */
+void mix_accumulate(float *dst, const float *src, size_t n);
+/** Mono source into a stereo pair: left += src * gain_l, right += src * gain_r. */
+void mix_accumulate_pan(float *left,
+                        float *right,
+                        const float *src,
+                        float gain_l,
+                        float gain_r,
+                        size_t n);
+/** Adds src[0..n) through the target. */
+void mix_accumulate_target(const MixTarget *t, const float *src, size_t n);
+/** Applies gain, clamps to [-1, 1] and writes interleaved 16-bit stereo. */
+void mix_interleave_s16(int16_t *dst,
+                        const float *left,
+                        const float *right,
+                        size_t n,
+                        float gain);
+/** Integer twin for Q15 buses: gain is Q15 (32768 = unity), output saturates. */
+void mix_interleave_q15(int16_t *dst,
+                        const int32_t *left,
+                        const int32_t *right,
+                        size_t n,
+                        int32_t gain);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYNTHRAVE_MIX_KERNELS_H */
@@ -0,0 +1,85 @@
+#ifndef SYNTHRAVE_OSCILLATOR_H
+#define SYNTHRAVE_OSCILLATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mix_kernels.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Oscillator phase is a 32-bit unsigned accumulator covering one full cycle,
+ * so wrap-around is free and precision does not degrade on long notes. The
+ * top OSC_TABLE_BITS bits index the sine table, the remaining bits are used
+ * as the interpolation fraction.
+ */
+#define OSC_TABLE_BITS 11
+#define OSC_TABLE_SIZE (1u << OSC_TABLE_BITS)
+#define OSC_FRAC_BITS (32 - OSC_TABLE_BITS)
+#define OSC_HALF_CYCLE 0x80000000u
+
+/** One sine cycle plus a guard point for interpolation. */
+extern float osc_sine_table[OSC_TABLE_SIZE + 1];
+
+/** Fills the shared tables; safe to call repeatedly. */
+void osc_tables_init(void);
+
+/**
+ * Renders `count` independent sine voices: outs[v] receives voice v and
+ * phases[v] advances by incs[v] per sample. Runtime-dispatched per CPU level.
+ */
+void osc_sine_bank(uint32_t *phases,
+                   const uint32_t *incs,
+                   float *const *outs,
+                   size_t count,
+                   size_t frames);
+/** As osc_sine_bank, adding voice v through mixes[v]. */
+void osc_sine_bank_mix(uint32_t *phases,
+                       const uint32_t *incs,
+                       const MixTarget *mixes,
+                       size_t count,
+                       size_t frames);
+
+/** Per-sample phase increment for a frequency in Hz. */
+static inline uint32_t osc_phase_inc(float frequency, float sample_rate) {
+    const double cycles = (double)frequency / (double)sample_rate;
+    return (uint32_t)(int64_t)(cycles * 4294967296.0);
+}
+
+/** Hz-to-increment factor for kernels whose frequency moves every sample. */
+static inline float osc_inc_scale(float sample_rate) {
+    return 4294967296.0f / sample_rate;
+}
+
+/** Converts a frequency already multiplied by osc_inc_scale() to an increment. */
+static inline uint32_t osc_scaled_inc(float scaled_frequency) {
+    return (uint32_t)(int64_t)scaled_frequency;
+}
+
+static inline float osc_sine(uint32_t phase) {
+    const uint32_t idx = phase >> OSC_FRAC_BITS;
+    const float frac = (float)(int32_t)(phase & ((1u << OSC_FRAC_BITS) - 1u)) *
+                       (1.0f / (float)(1u << OSC_FRAC_BITS));
+    const float a = osc_sine_table[idx];
+    const float b = osc_sine_table[idx + 1u];
+    return a + (b - a) * frac;
+}
+
+/** Rising saw in [-1, 1). */
+static inline float osc_saw(uint32_t phase) {
+    return (float)(int32_t)(phase ^ OSC_HALF_CYCLE) * (1.0f / 2147483648.0f);
+}
+
+/** +1 for the first half cycle, -1 for the second. */
+static inline float osc_square(uint32_t phase) {
+    return phase < OSC_HALF_CYCLE ? 1.0f : -1.0f;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYNTHRAVE_OSCILLATOR_H */
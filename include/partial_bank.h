@@ -0,0 +1,70 @@
+#ifndef SYNTHRAVE_PARTIAL_BANK_H
+#define SYNTHRAVE_PARTIAL_BANK_H
+
+#include <stddef.h>
+
+#include "mix_kernels.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PARTIAL_BANK_MAX 16
+#define PARTIAL_BANK_WIDTH 4
+
+/**
+ * Sum of decaying sine partials kept in structure-of-arrays lanes.
+ * Each partial is a rotating phasor (re, im) advanced by a complex multiply,
+ * so the inner loop is pure multiply-adds across PARTIAL_BANK_WIDTH lanes.
+ * Unused lanes up to the next multiple of the width stay silent.
+ * Decays are evaluated once per control block and ramped linearly across it.
+ */
+typedef struct {
+    float re[PARTIAL_BANK_MAX];
+    float im[PARTIAL_BANK_MAX];
+    float rot_re[PARTIAL_BANK_MAX];
+    float rot_im[PARTIAL_BANK_MAX];
+    float amp[PARTIAL_BANK_MAX];
+    float decay[PARTIAL_BANK_MAX];
+    float block_decay[PARTIAL_BANK_MAX]; /* decay^control_block */
+    size_t control_block;
+    size_t count;
+} PartialBank;
+
+void partial_bank_init(PartialBank *bank);
+/** Adds a partial starting at phase 0; decay is a per-sample amplitude multiplier. */
+int partial_bank_add(PartialBank *bank,
+                     float frequency,
+                     float sample_rate,
+                     float amplitude,
+                     float decay);
+/** Sets the control block the decays are ramped over (0 = default). */
+void partial_bank_set_control_block(PartialBank *bank, size_t block);
+/**
+ * Silences all but the first `keep` partials. Instruments add their
+ * strongest partials first, so this is the cheap variant of a voice.
+ */
+void partial_bank_truncate(PartialBank *bank, size_t keep);
+/** Writes the sum of all partials into out. */
+void partial_bank_process(PartialBank *bank, float *out, size_t frames);
+/** Adds the sum of all partials into the mix target. */
+void partial_bank_process_mix(PartialBank *bank, const MixTarget *mix, size_t frames);
+/**
+ * Renders several banks at once, packing their lanes side by side so small
+ * banks (e.g. three-note chords) share one vector pass. outs[v] receives bank v.
+ */
+void partial_bank_process_multi(PartialBank *const *banks,
+                                size_t count,
+                                float *const *outs,
+                                size_t frames);
+/** As partial_bank_process_multi, adding bank v through mixes[v]. */
+void partial_bank_process_multi_mix(PartialBank *const *banks,
+                                    size_t count,
+                                    const MixTarget *mixes,
+                                    size_t frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYNTHRAVE_PARTIAL_BANK_H */
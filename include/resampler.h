@@ -0,0 +1,68 @@
+#ifndef SYNTHRAVE_RESAMPLER_H
+#define SYNTHRAVE_RESAMPLER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Reads a mono float buffer at a fractional rate. The read position is
+ * 32.32 fixed point; positions past the last source frame hold it, so a
+ * one-shot that runs out keeps its final value like the old per-voice code.
+ *
+ * RESAMPLE_SINC (the default) interpolates a Kaiser-windowed sinc from a
+ * polyphase table of RESAMPLE_SINC_PHASES rows. Reading faster than 1:1
+ * picks a table (in 1/8 steps up to 4x) with a proportionally lower cutoff
+ * and more taps so the result does not alias. RESAMPLE_LINEAR is two taps
+ * and much cheaper. At exactly 1:1 on a whole source frame either quality
+ * copies the source unfiltered.
+ *
+ * With a loop set, positions that reach loop_end jump back by the loop
+ * length. The source must stay readable a few frames past loop_end (half the
+ * sinc taps) and hold there what follows loop_start.
+ */
+typedef enum {
+    RESAMPLE_SINC = 0,
+    RESAMPLE_LINEAR
+} ResampleQuality;
+
+#define RESAMPLE_SINC_TAPS 16u
+#define RESAMPLE_SINC_PHASES 256u
+
+typedef struct {
+    const float *src;
+    size_t length;
+    uint64_t pos;  /* source frame << 32 */
+    uint64_t step; /* source frames per output frame << 32 */
+    ResampleQuality quality;
+    const float *table; /* sinc rows of `taps` coefficients, NULL for linear */
+    uint32_t taps;
+    uint64_t loop_start; /* source frame << 32 */
+    uint64_t loop_end;   /* zero: no loop */
+} Resampler;
+
+/** step = source frames per output frame; builds the sinc table on first use. */
+void resampler_init(Resampler *rs,
+                    const float *src,
+                    size_t length,
+                    double step,
+                    ResampleQuality quality);
+void resampler_process(Resampler *rs, float *out, size_t frames);
+/** Switches quality, keeping the read position and loop. */
+void resampler_set_quality(Resampler *rs, ResampleQuality quality);
+/** Loops source frames [start, end); end <= start clears the loop. */
+void resampler_set_loop(Resampler *rs, size_t start, size_t end);
+
+/** Parses "linear" or "sinc". */
+bool resampler_parse_quality(const char *name, ResampleQuality *out);
+const char *resampler_quality_name(ResampleQuality quality);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYNTHRAVE_RESAMPLER_H */
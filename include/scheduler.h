@@ -7,6 +7,30 @@
 extern "C" {
 #endif
 
+/**
+ * Renders all tone events offline into newly allocated left/right buffers.
+ * Returns the frame count, or 0 (with NULL buffers) when nothing is audible.
+ */
+size_t scheduler_render_document(const SequenceDocument *doc,
+                                 const SequenceOptions *opts,
+                                 float **out_left,
+                                 float **out_right);
+/**
+ * Integer render for FIXED_POINT playback: like scheduler_render_document,
+ * but the buses are Q20 (QMIX_BITS). Oscillator voices, fades, mix and bus
+ * filters run in Q15/Q31/Q20; the instrument kernels stay float and are
+ * folded into the buses once per mix block.
+ */
+size_t scheduler_render_document_q(const SequenceDocument *doc,
+                                   const SequenceOptions *opts,
+                                   int32_t **out_left,
+                                   int32_t **out_right);
+/** Applies gain to Q20 buses and writes interleaved, saturated 16-bit stereo. */
+void scheduler_interleave_q15(int16_t *pcm,
+                              const int32_t *left,
+                              const int32_t *right,
+                              size_t frames,
+                              float gain);
 int scheduler_play_document(const SequenceDocument *doc,
                             const SequenceOptions *opts,
                             float gain,
@@ -5,6 +5,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "resampler.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -32,7 +34,8 @@ typedef enum {
     SEQ_SPEC_CHOIR,
     SEQ_SPEC_ANALOGLEAD,
     SEQ_SPEC_SIDBASS,
-    SEQ_SPEC_CHIPARP
+    SEQ_SPEC_CHIPARP,
+    SEQ_SPEC_FM
 } SeqSpecType;
 
 typedef struct SampleData SampleData;
@@ -42,6 +45,10 @@ struct SampleData {
     int channels;
     int length;
     int sample_rate;
+    /* converted once to the session rate at load; may alias chan */
+    float *rate_chan[2];
+    int rate_length;
+    int rate;
 };
 
 typedef struct {
@@ -53,6 +60,7 @@ typedef struct {
     int chord_count;
     SampleData *sample;
     int sample_channel;
+    int patch; /* SEQ_SPEC_FM: FmPatch */
 } SeqSpec;
 
 typedef struct {
@@ -81,18 +89,28 @@ typedef struct {
     int arg_count;
 } SeqSpeechEvent;
 
+/* Folded .aox timeline: rows parsed once, macros and loops kept as references. */
+typedef struct SequenceTimeline SequenceTimeline;
+
 typedef struct {
-    SeqToneEvent *tones;
-    size_t tone_count;
+    SeqToneEvent *tones; /* NULL when the tones come from `timeline` */
+    size_t tone_count;   /* includes the tones a timeline unrolls to */
     SeqSpeechEvent *speech;
     size_t speech_count;
     size_t total_samples;
+    SequenceTimeline *timeline; /* .aox documents; walk it with a SequenceCursor */
 } SequenceDocument;
 
 typedef struct {
     int sample_rate;
     int default_duration_ms;
     int fade_ms;
+    int control_block; /* samples per glide/sweep update, 0 = default */
+    ResampleQuality resample_quality; /* sample voices; zero = sinc */
+    uint32_t bake_mask; /* BAKE_BIT per instrument played from baked tables */
+    float bus_highpass_hz; /* filters on the mixed buses, 0 = off */
+    float bus_lowpass_hz;
+    float governor_budget; /* render time per audio second before quality steps down, 0 = off */
 } SequenceOptions;
 
 bool sequence_load_file(const char *path,
@@ -105,6 +123,39 @@ bool sequence_build_from_tokens(const char *const *tokens,
 
 void sequence_document_free(SequenceDocument *doc);
 
+/** Cost of the most recent sequence_load_file() call. */
+typedef struct {
+    double load_ms;     /* wall time, file open to document */
+    size_t bytes;       /* size of the mapped file */
+    size_t rows;        /* source rows tokenized, macro bodies included */
+    size_t allocations; /* heap allocations made by the loader, arena chunks included */
+    size_t arena_bytes; /* scratch arena (rows, macros) released at the end of the load */
+    size_t timeline_bytes; /* folded timeline kept with the document */
+} SequenceLoadStats;
+
+void sequence_load_stats(SequenceLoadStats *out);
+
+/*
+ * Walks a document's tones in timeline order. Timeline documents are
+ * unrolled here one tone per call, so loops and macro calls are never
+ * materialized; the returned event borrows its strings from the document.
+ */
+typedef struct SequenceCursorFrame SequenceCursorFrame;
+
+typedef struct {
+    const SequenceDocument *doc;
+    size_t next;     /* tone array: index of the next tone */
+    size_t position; /* timeline: sample the next row starts at */
+    SequenceCursorFrame *stack;
+    size_t depth;
+    size_t cap;
+    bool ordered; /* tones arrive with nondecreasing start_sample */
+} SequenceCursor;
+
+void sequence_cursor_init(SequenceCursor *cur, const SequenceDocument *doc);
+bool sequence_cursor_next(SequenceCursor *cur, SeqToneEvent *out);
+void sequence_cursor_free(SequenceCursor *cur);
+
 void sample_cache_clear(void);
 
 #ifdef __cplusplus
@@ -2,8 +2,10 @@
 #define SYNTHRAVE_SYNTH_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include "instrument.h"
+#include "thread_pool.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -33,8 +35,75 @@ typedef struct {
 typedef struct {
     unsigned int sample_rate;
     unsigned int channels; /* 1 or 2 */
+    unsigned int threads;  /* tracks rendered in parallel; 0 or 1 = on the caller */
 } SynthEngine;
 
+typedef struct {
+    float start_time;
+    size_t index; /* into SynthTrack.events */
+} SynthEventKey;
+
+typedef struct {
+    size_t index; /* into SynthTrack.events */
+    size_t skip;  /* frames of the current block before the note starts */
+    SynthVoice voice;
+} SynthActiveNote;
+
+/**
+ * Per-track render cursor: events sorted by start time, the next one that
+ * has not started yet, and a voice for each event currently sounding (kept
+ * in event order so they always mix in the same order).
+ */
+typedef struct {
+    SynthEventKey *order;
+    size_t next;
+    SynthActiveNote *active;
+    size_t active_count;
+} SynthTrackCursor;
+
+/**
+ * Incremental render state for a song. Consecutive
+ * synth_engine_render_next() calls continue where the previous block ended,
+ * and only the voices of sounding events are rendered, a block at a time.
+ * Each track renders into its own buffer, on a thread pool when the engine
+ * asks for threads, before one pass pans, sums and soft-clips them.
+ * The song's events must not change while the state is in use.
+ */
+typedef struct {
+    const SynthSong *song;
+    SynthTrackCursor *tracks;
+    size_t track_count;
+    float start_time; /* seconds at frame 0 */
+    size_t frame;     /* frames rendered so far */
+    float *track_blocks; /* track_count spans of SYNTH_ENGINE_SPAN frames */
+    int32_t *track_blocks_q; /* Q20 twin, allocated by the first fixed-point render */
+    ThreadPool *pool;    /* created on the first threaded render */
+} SynthRenderState;
+
+/** Frames each track renders per parallel step. */
+#define SYNTH_ENGINE_SPAN 1024u
+
+void synth_render_state_init(SynthRenderState *state, const SynthSong *song, float start_time);
+void synth_render_state_free(SynthRenderState *state);
+void synth_engine_render_next(const SynthEngine *engine,
+                              SynthRenderState *state,
+                              float *buffer,
+                              size_t frame_count);
+/**
+ * Integer-only twin of synth_engine_render_next (see fixed_point.h): Q15
+ * voices, Q20 mix and a table soft clip, written as interleaved s16. A state
+ * must stay on one of the two paths.
+ */
+void synth_engine_render_fixed(const SynthEngine *engine,
+                               SynthRenderState *state,
+                               int16_t *buffer,
+                               size_t frame_count);
+/** s16 output through the fixed path when built with FIXED_POINT=1, else the float one. */
+void synth_engine_render_s16(const SynthEngine *engine,
+                             SynthRenderState *state,
+                             int16_t *buffer,
+                             size_t frame_count);
+
 size_t synth_engine_frames_for_song(const SynthEngine *engine, const SynthSong *song);
 float synth_song_estimate_length(const SynthSong *song);
 void synth_engine_render(const SynthEngine *engine,
@@ -0,0 +1,31 @@
+#ifndef SYNTHRAVE_THREAD_POOL_H
+#define SYNTHRAVE_THREAD_POOL_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fixed set of worker threads for parallel loops: thread_pool_run() hands
+ * out the indices 0..count-1 to the workers and the calling thread, and
+ * returns once every task has finished.
+ */
+typedef struct ThreadPool ThreadPool;
+
+typedef void (*ThreadPoolTask)(void *ctx, size_t index);
+
+/** Pool that runs tasks on `threads` threads including the caller; NULL on failure. */
+ThreadPool *thread_pool_create(unsigned int threads);
+void thread_pool_destroy(ThreadPool *pool);
+void thread_pool_run(ThreadPool *pool, size_t count, ThreadPoolTask task, void *ctx);
+
+/** Online CPU count, at least 1. */
+unsigned int thread_pool_cpu_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYNTHRAVE_THREAD_POOL_H */
@@ -0,0 +1,83 @@
+#include "arena.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+struct ArenaChunk {
+    ArenaChunk *next;
+    size_t used;
+    size_t size;
+    unsigned char *data;
+};
+
+static void *xcalloc(size_t n, size_t sz) {
+    void *ptr = calloc(n, sz);
+    if (!ptr) {
+        fprintf(stderr, "synthrave: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    return ptr;
+}
+
+static size_t align_up(size_t value) {
+    return (value + ARENA_ALIGN - 1u) & ~(size_t)(ARENA_ALIGN - 1u);
+}
+
+/* Header and data share one allocation. */
+static ArenaChunk *chunk_new(size_t size) {
+    ArenaChunk *chunk = xcalloc(1, sizeof(*chunk) + size + ARENA_ALIGN);
+    unsigned char *raw = (unsigned char *)(chunk + 1);
+    chunk->data = raw;
+    /* start the usable region on an aligned address */
+    chunk->used = align_up((uintptr_t)raw) - (uintptr_t)raw;
+    chunk->size = size + ARENA_ALIGN;
+    return chunk;
+}
+
+void arena_init(Arena *arena, size_t chunk_size) {
+    if (arena == NULL) {
+        return;
+    }
+    arena->head = NULL;
+    arena->chunk_size = chunk_size ? chunk_size : 64u * 1024u;
+    arena->chunk_count = 0;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    if (arena == NULL) {
+        return NULL;
+    }
+    size = align_up(size ? size : 1u);
+    ArenaChunk *chunk = arena->head;
+    if (chunk == NULL || chunk->size - chunk->used < size) {
+        chunk = chunk_new(size > arena->chunk_size ? size : arena->chunk_size);
+        chunk->next = arena->head;
+        arena->head = chunk;
+        ++arena->chunk_count;
+    }
+    void *ptr = chunk->data + chunk->used;
+    chunk->used += size;
+    return ptr;
+}
+
+size_t arena_bytes(const Arena *arena) {
+    size_t total = 0;
+    for (const ArenaChunk *chunk = arena ? arena->head : NULL; chunk; chunk = chunk->next) {
+        total += chunk->size;
+    }
+    return total;
+}
+
+void arena_free(Arena *arena) {
+    if (arena == NULL) {
+        return;
+    }
+    ArenaChunk *chunk = arena->head;
+    while (chunk) {
+        ArenaChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena->head = NULL;
+}
@@ -0,0 +1,273 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "bake.h"
+
+#include "instruments_ext.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/* One table per semitone from C0 to C9. */
+#define BAKE_NOTE_MIN 12
+#define BAKE_NOTE_MAX 120
+#define BAKE_NOTES (BAKE_NOTE_MAX - BAKE_NOTE_MIN + 1)
+/* Readable frames past the end: the loop continuation or trailing silence. */
+#define BAKE_GUARD 64u
+#define BAKE_XFADE_S 0.05f
+/* One-shots end once they stay 60 dB below their peak. */
+#define BAKE_FLOOR 1e-3f
+#define BAKE_FADE 256u
+/* Tables are rendered, and baked voices read back, in chunks this long. */
+#define BAKE_MIX_CHUNK 64u
+
+typedef struct {
+    SeqSpecType type;
+    const char *name;
+    float settle_s; /* sustained: time before the loop starts */
+    float loop_s;   /* sustained: loop length, zero for one-shots */
+    float tail_s;   /* one-shots: longest render */
+} BakeSpec;
+
+static const BakeSpec bake_specs[] = {
+    {SEQ_SPEC_CHOIR, "choir", 1.0f, 2.0f, 0.0f},
+    {SEQ_SPEC_STRPAD, "strpad", 5.0f, 2.0f, 0.0f},
+    {SEQ_SPEC_BELL, "bell", 0.0f, 0.0f, 14.0f},
+    {SEQ_SPEC_EGTR, "egtr", 0.0f, 0.0f, 4.0f},
+};
+
+#define BAKE_SPEC_COUNT (sizeof(bake_specs) / sizeof(bake_specs[0]))
+
+static BakedTable *bake_cache[BAKE_SPEC_COUNT][BAKE_NOTES];
+static int bake_rate;
+
+typedef union {
+    ChoirSynthState choir;
+    StrPadState strpad;
+    BellState bell;
+    EgtrState egtr;
+} BakeState;
+
+static void *xcalloc(size_t n, size_t sz) {
+    void *ptr = calloc(n, sz);
+    if (!ptr) {
+        fprintf(stderr, "synthrave: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    return ptr;
+}
+
+static int bake_spec_index(SeqSpecType type) {
+    for (size_t s = 0; s < BAKE_SPEC_COUNT; ++s) {
+        if (bake_specs[s].type == type) {
+            return (int)s;
+        }
+    }
+    return -1;
+}
+
+/* Same parameters as the live voices in the scheduler. */
+static void bake_render(SeqSpecType type, float frequency, float sample_rate, float *out,
+                        size_t frames) {
+    BakeState state;
+    const SynthBlockConfig cfg = {
+        .sample_rate = sample_rate,
+        .block_duration = (float)BAKE_MIX_CHUNK / sample_rate,
+        .control_block = 0,
+    };
+    switch (type) {
+        case SEQ_SPEC_CHOIR:
+            choir_synth_init(&state.choir, sample_rate, frequency, 0.4f);
+            break;
+        case SEQ_SPEC_STRPAD:
+            strpad_state_init(&state.strpad, sample_rate, frequency);
+            break;
+        case SEQ_SPEC_BELL:
+            bell_state_init(&state.bell, sample_rate, frequency);
+            break;
+        case SEQ_SPEC_EGTR:
+            egtr_state_init(&state.egtr, sample_rate, frequency, 3.0f);
+            break;
+        default:
+            return;
+    }
+    for (size_t i = 0; i < frames; i += BAKE_MIX_CHUNK) {
+        const size_t n = frames - i < BAKE_MIX_CHUNK ? frames - i : BAKE_MIX_CHUNK;
+        switch (type) {
+            case SEQ_SPEC_CHOIR:
+                choir_synth_process(&state.choir, &cfg, out + i, n);
+                break;
+            case SEQ_SPEC_STRPAD:
+                strpad_process(&state.strpad, &cfg, out + i, n);
+                break;
+            case SEQ_SPEC_BELL:
+                bell_process(&state.bell, &cfg, out + i, n);
+                break;
+            default:
+                egtr_process(&state.egtr, &cfg, out + i, n);
+                break;
+        }
+    }
+}
+
+/*
+ * Blends the end of the loop into the frames before loop_start, so playback
+ * that jumps from loop_end back to loop_start continues seamlessly, then
+ * copies the loop head into the guard for the interpolator to read.
+ */
+static void bake_close_loop(float *data, size_t loop_start, size_t loop_end, float sample_rate) {
+    const size_t loop_len = loop_end - loop_start;
+    size_t xfade = (size_t)(BAKE_XFADE_S * sample_rate);
+    xfade = xfade < loop_len / 2u ? xfade : loop_len / 2u;
+    xfade = xfade < loop_start ? xfade : loop_start;
+    for (size_t k = 0; k < xfade; ++k) {
+        const float w = ((float)k + 0.5f) / (float)xfade;
+        float *dst = data + loop_end - xfade + k;
+        *dst = *dst * (1.0f - w) + data[loop_start - xfade + k] * w;
+    }
+    memcpy(data + loop_end, data + loop_start, BAKE_GUARD * sizeof(float));
+}
+
+/* Cuts a one-shot where it stays below the floor and fades the last frames out. */
+static size_t bake_trim_tail(float *data, size_t frames) {
+    float peak = 0.0f;
+    for (size_t i = 0; i < frames; ++i) {
+        peak = fmaxf(peak, fabsf(data[i]));
+    }
+    const float floor_level = peak * BAKE_FLOOR;
+    size_t end = frames;
+    while (end > 0u && fabsf(data[end - 1u]) < floor_level) {
+        --end;
+    }
+    const size_t fade = end < BAKE_FADE ? end : BAKE_FADE;
+    for (size_t i = 0; i < fade; ++i) {
+        data[end - fade + i] *= 1.0f - (float)(i + 1u) / (float)fade;
+    }
+    memset(data + end, 0, (frames + BAKE_GUARD - end) * sizeof(float));
+    return end;
+}
+
+static BakedTable *bake_table_build(const BakeSpec *spec, int note, int sample_rate) {
+    const float sr = (float)sample_rate;
+    const float frequency = 440.0f * powf(2.0f, (float)(note - 69) / 12.0f);
+    BakedTable *table = xcalloc(1, sizeof(*table));
+    table->frequency = frequency;
+    size_t frames = 0;
+    if (spec->loop_s > 0.0f) {
+        /* whole periods of the root so the crossfade joins in phase */
+        const float periods = fmaxf(1.0f, roundf(spec->loop_s * frequency));
+        table->loop_start = (size_t)(spec->settle_s * sr);
+        table->loop_end = table->loop_start + (size_t)lroundf(periods * sr / frequency);
+        frames = table->loop_end;
+    } else {
+        frames = (size_t)(spec->tail_s * sr);
+    }
+    table->data = xcalloc(frames + BAKE_GUARD, sizeof(float));
+    bake_render(spec->type, frequency, sr, table->data, frames);
+    if (table->loop_end != 0u) {
+        bake_close_loop(table->data, table->loop_start, table->loop_end, sr);
+        table->length = frames + BAKE_GUARD;
+    } else {
+        table->length = bake_trim_tail(table->data, frames) + BAKE_GUARD;
+    }
+    return table;
+}
+
+bool bake_supported(SeqSpecType type) {
+    return bake_spec_index(type) >= 0;
+}
+
+const BakedTable *bake_table_get(SeqSpecType type, float frequency, int sample_rate) {
+    const int s = bake_spec_index(type);
+    if (s < 0 || frequency <= 0.0f || sample_rate <= 0) {
+        return NULL;
+    }
+    const long note = lroundf(69.0f + 12.0f * log2f(frequency / 440.0f));
+    if (note < BAKE_NOTE_MIN || note > BAKE_NOTE_MAX) {
+        return NULL;
+    }
+    if (sample_rate != bake_rate) {
+        bake_tables_clear();
+        bake_rate = sample_rate;
+    }
+    BakedTable **slot = &bake_cache[s][note - BAKE_NOTE_MIN];
+    if (*slot == NULL) {
+        *slot = bake_table_build(&bake_specs[s], (int)note, sample_rate);
+    }
+    return *slot;
+}
+
+void bake_tables_clear(void) {
+    for (size_t s = 0; s < BAKE_SPEC_COUNT; ++s) {
+        for (size_t n = 0; n < BAKE_NOTES; ++n) {
+            if (bake_cache[s][n] != NULL) {
+                free(bake_cache[s][n]->data);
+                free(bake_cache[s][n]);
+                bake_cache[s][n] = NULL;
+            }
+        }
+    }
+    bake_rate = 0;
+}
+
+bool baked_voice_init(BakedVoice *voice, SeqSpecType type, float frequency, int sample_rate) {
+    if (voice == NULL) {
+        return false;
+    }
+    const BakedTable *table = bake_table_get(type, frequency, sample_rate);
+    if (table == NULL) {
+        return false;
+    }
+    resampler_init(&voice->rs, table->data, table->length,
+                   (double)frequency / (double)table->frequency, RESAMPLE_LINEAR);
+    if (table->loop_end != 0u) {
+        resampler_set_loop(&voice->rs, table->loop_start, table->loop_end);
+    }
+    return true;
+}
+
+void baked_voice_process_mix(BakedVoice *voice, const MixTarget *mix, size_t frames) {
+    if (voice == NULL || mix == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < frames; i += BAKE_MIX_CHUNK) {
+        float chunk[BAKE_MIX_CHUNK];
+        const size_t n = frames - i < BAKE_MIX_CHUNK ? frames - i : BAKE_MIX_CHUNK;
+        const MixTarget part = mix_target_advance(mix, i);
+        resampler_process(&voice->rs, chunk, n);
+        mix_accumulate_target(&part, chunk, n);
+    }
+}
+
+bool bake_parse_list(const char *list, uint32_t *mask) {
+    if (list == NULL || mask == NULL) {
+        return false;
+    }
+    uint32_t bits = 0;
+    char name[32];
+    for (const char *p = list; *p != '\0';) {
+        const char *end = strchr(p, ',');
+        const size_t len = end ? (size_t)(end - p) : strlen(p);
+        if (len == 0u || len >= sizeof(name)) {
+            return false;
+        }
+        memcpy(name, p, len);
+        name[len] = '\0';
+        const bool all = strcasecmp(name, "all") == 0;
+        bool found = false;
+        for (size_t s = 0; s < BAKE_SPEC_COUNT; ++s) {
+            if (all || strcasecmp(name, bake_specs[s].name) == 0) {
+                bits |= BAKE_BIT(bake_specs[s].type);
+                found = true;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+        p += len + (end ? 1u : 0u);
+    }
+    *mask = bits;
+    return bits != 0u;
+}
@@ -0,0 +1,61 @@
+#include "cpu_dispatch.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static CpuLevel detect_level(void) {
+#if CPU_MULTIVERSION
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl")) {
+        return CPU_LEVEL_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return CPU_LEVEL_AVX2;
+    }
+#endif
+    return CPU_LEVEL_BASELINE;
+}
+
+static CpuLevel resolved_level = CPU_LEVEL_BASELINE;
+static pthread_once_t level_once = PTHREAD_ONCE_INIT;
+
+static void resolve_level(void) {
+    resolved_level = detect_level();
+    const char *force = getenv("SYNTHRAVE_CPU");
+    if (force && *force) {
+        CpuLevel wanted = resolved_level;
+        if (strcmp(force, "baseline") == 0) {
+            wanted = CPU_LEVEL_BASELINE;
+        } else if (strcmp(force, "avx2") == 0) {
+            wanted = CPU_LEVEL_AVX2;
+        } else if (strcmp(force, "avx512") == 0) {
+            wanted = CPU_LEVEL_AVX512;
+        } else {
+            fprintf(stderr, "synthrave: unknown SYNTHRAVE_CPU level '%s'\n", force);
+        }
+        if (wanted > resolved_level) {
+            fprintf(stderr, "synthrave: %s not supported, using %s\n",
+                    cpu_level_name(wanted), cpu_level_name(resolved_level));
+        } else {
+            resolved_level = wanted;
+        }
+    }
+}
+
+CpuLevel cpu_dispatch_level(void) {
+    pthread_once(&level_once, resolve_level);
+    return resolved_level;
+}
+
+const char *cpu_level_name(CpuLevel level) {
+    switch (level) {
+        case CPU_LEVEL_AVX2:
+            return "avx2";
+        case CPU_LEVEL_AVX512:
+            return "avx512";
+        default:
+            return "baseline";
+    }
+}
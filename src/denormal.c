@@ -0,0 +1,33 @@
+#include "denormal.h"
+
+#include <stddef.h>
+
+#if DENORMAL_HW_FTZ
+#include <xmmintrin.h>
+
+#define CSR_FTZ 0x8000u
+#define CSR_DAZ 0x0040u
+#endif
+
+bool denormal_flush_enabled = true;
+
+void denormal_protect_begin(DenormalMode *mode) {
+    if (mode == NULL) {
+        return;
+    }
+#if DENORMAL_HW_FTZ
+    mode->saved = _mm_getcsr();
+    _mm_setcsr(mode->saved | CSR_FTZ | CSR_DAZ);
+#else
+    mode->saved = 0u;
+#endif
+}
+
+void denormal_protect_end(const DenormalMode *mode) {
+    if (mode == NULL) {
+        return;
+    }
+#if DENORMAL_HW_FTZ
+    _mm_setcsr(mode->saved);
+#endif
+}
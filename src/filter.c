@@ -0,0 +1,389 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "filter.h"
+
+#include "cpu_dispatch.h"
+#include "fixed_point.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Bank kernels transpose this many frames per lane group through the stack. */
+#define FILTER_CHUNK 64u
+/* Largest ramp a float lane counter still counts exactly. */
+#define FILTER_LANE_RAMP_MAX 16777216u
+
+static float filter_warp(float cutoff, float sample_rate) {
+    const float nyquist = 0.49f * sample_rate;
+    const float fc = cutoff < 1.0f ? 1.0f : (cutoff > nyquist ? nyquist : cutoff);
+    return (float)M_PI * fc / sample_rate;
+}
+
+BiquadCoeffs biquad_design(FilterMode mode, float cutoff, float q, float sample_rate) {
+    const float w0 = 2.0f * filter_warp(cutoff, sample_rate);
+    const float cw = cosf(w0);
+    const float alpha = sinf(w0) / (2.0f * (q > 0.01f ? q : 0.01f));
+    const float inv_a0 = 1.0f / (1.0f + alpha);
+    BiquadCoeffs c = {0.0f, 0.0f, 0.0f, -2.0f * cw * inv_a0, (1.0f - alpha) * inv_a0};
+    switch (mode) {
+        case FILTER_HIGHPASS:
+            c.b0 = 0.5f * (1.0f + cw) * inv_a0;
+            c.b1 = -(1.0f + cw) * inv_a0;
+            c.b2 = c.b0;
+            break;
+        case FILTER_BANDPASS:
+            c.b0 = alpha * inv_a0;
+            c.b2 = -c.b0;
+            break;
+        case FILTER_NOTCH:
+            c.b0 = inv_a0;
+            c.b1 = c.a1;
+            c.b2 = inv_a0;
+            break;
+        default:
+            c.b0 = 0.5f * (1.0f - cw) * inv_a0;
+            c.b1 = (1.0f - cw) * inv_a0;
+            c.b2 = c.b0;
+            break;
+    }
+    return c;
+}
+
+void biquad_init(Biquad *f, BiquadCoeffs c) {
+    if (f == NULL) {
+        return;
+    }
+    memset(f, 0, sizeof(*f));
+    f->c = c;
+}
+
+void biquad_ramp_to(Biquad *f, BiquadCoeffs target, uint32_t frames) {
+    if (f == NULL) {
+        return;
+    }
+    if (frames == 0u) {
+        f->c = target;
+        f->ramp = 0u;
+        return;
+    }
+    const float inv = 1.0f / (float)frames;
+    f->step.b0 = (target.b0 - f->c.b0) * inv;
+    f->step.b1 = (target.b1 - f->c.b1) * inv;
+    f->step.b2 = (target.b2 - f->c.b2) * inv;
+    f->step.a1 = (target.a1 - f->c.a1) * inv;
+    f->step.a2 = (target.a2 - f->c.a2) * inv;
+    f->ramp = frames;
+}
+
+void biquad_process(Biquad *f, float *buf, size_t frames) {
+    if (f == NULL || buf == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < frames; ++i) {
+        buf[i] = biquad_tick(f, buf[i]);
+    }
+}
+
+/* Coefficient format of BiquadQ: |c| < 8 fits, and 2^-28 keeps low cutoffs stable. */
+#define BIQUAD_Q_BITS 28
+
+void biquad_q_init(BiquadQ *f, BiquadCoeffs c) {
+    if (f == NULL) {
+        return;
+    }
+    f->b0 = q_from_float(c.b0, BIQUAD_Q_BITS);
+    f->b1 = q_from_float(c.b1, BIQUAD_Q_BITS);
+    f->b2 = q_from_float(c.b2, BIQUAD_Q_BITS);
+    f->a1 = q_from_float(c.a1, BIQUAD_Q_BITS);
+    f->a2 = q_from_float(c.a2, BIQUAD_Q_BITS);
+    f->z1 = 0;
+    f->z2 = 0;
+}
+
+void biquad_q_process(BiquadQ *f, int32_t *buf, size_t frames) {
+    if (f == NULL || buf == NULL) {
+        return;
+    }
+    int64_t z1 = f->z1;
+    int64_t z2 = f->z2;
+    const int64_t frac_mask = ((int64_t)1 << BIQUAD_Q_BITS) - 1;
+    for (size_t i = 0; i < frames; ++i) {
+        const int64_t x = buf[i];
+        const int64_t acc = (int64_t)f->b0 * x + z1;
+        const int64_t y = acc >> BIQUAD_Q_BITS;
+        /*
+         * The feedback also takes the fraction dropped from y; near-unity
+         * poles (low high-pass cutoffs) would otherwise amplify the rounding.
+         */
+        const int64_t frac = acc & frac_mask;
+        z1 = (int64_t)f->b1 * x - (int64_t)f->a1 * y - (((int64_t)f->a1 * frac) >> BIQUAD_Q_BITS) +
+             z2;
+        z2 = (int64_t)f->b2 * x - (int64_t)f->a2 * y - (((int64_t)f->a2 * frac) >> BIQUAD_Q_BITS);
+        buf[i] = (int32_t)y;
+    }
+    f->z1 = z1;
+    f->z2 = z2;
+}
+
+SvfCoeffs svf_design(FilterMode mode, float cutoff, float q, float sample_rate) {
+    const float g = tanf(filter_warp(cutoff, sample_rate));
+    const float k = 1.0f / (q > 0.01f ? q : 0.01f);
+    SvfCoeffs c;
+    c.a1 = 1.0f / (1.0f + g * (g + k));
+    c.a2 = g * c.a1;
+    c.a3 = g * c.a2;
+    switch (mode) {
+        case FILTER_HIGHPASS:
+            c.m0 = 1.0f;
+            c.m1 = -k;
+            c.m2 = -1.0f;
+            break;
+        case FILTER_BANDPASS:
+            /* scaled by k for a 0 dB peak like the biquad */
+            c.m0 = 0.0f;
+            c.m1 = k;
+            c.m2 = 0.0f;
+            break;
+        case FILTER_NOTCH:
+            c.m0 = 1.0f;
+            c.m1 = -k;
+            c.m2 = 0.0f;
+            break;
+        default:
+            c.m0 = 0.0f;
+            c.m1 = 0.0f;
+            c.m2 = 1.0f;
+            break;
+    }
+    return c;
+}
+
+void svf_init(Svf *f, SvfCoeffs c) {
+    if (f == NULL) {
+        return;
+    }
+    memset(f, 0, sizeof(*f));
+    f->c = c;
+}
+
+void svf_ramp_to(Svf *f, SvfCoeffs target, uint32_t frames) {
+    if (f == NULL) {
+        return;
+    }
+    if (frames == 0u) {
+        f->c = target;
+        f->ramp = 0u;
+        return;
+    }
+    const float inv = 1.0f / (float)frames;
+    f->step.a1 = (target.a1 - f->c.a1) * inv;
+    f->step.a2 = (target.a2 - f->c.a2) * inv;
+    f->step.a3 = (target.a3 - f->c.a3) * inv;
+    f->step.m0 = (target.m0 - f->c.m0) * inv;
+    f->step.m1 = (target.m1 - f->c.m1) * inv;
+    f->step.m2 = (target.m2 - f->c.m2) * inv;
+    f->ramp = frames;
+}
+
+void svf_process(Svf *f, float *buf, size_t frames) {
+    if (f == NULL || buf == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < frames; ++i) {
+        buf[i] = svf_tick(f, buf[i]);
+    }
+}
+
+static float lane_ramp(uint32_t ramp) {
+    return (float)(ramp < FILTER_LANE_RAMP_MAX ? ramp : FILTER_LANE_RAMP_MAX);
+}
+
+void biquad_lanes_load(BiquadLanes *l, Biquad *const *filters, size_t count) {
+    if (l == NULL) {
+        return;
+    }
+    memset(l, 0, sizeof(*l));
+    for (size_t k = 0; k < count && k < FILTER_LANES; ++k) {
+        const Biquad *f = filters[k];
+        l->b0[k] = f->c.b0;
+        l->b1[k] = f->c.b1;
+        l->b2[k] = f->c.b2;
+        l->a1[k] = f->c.a1;
+        l->a2[k] = f->c.a2;
+        if (f->ramp != 0u) {
+            l->sb0[k] = f->step.b0;
+            l->sb1[k] = f->step.b1;
+            l->sb2[k] = f->step.b2;
+            l->sa1[k] = f->step.a1;
+            l->sa2[k] = f->step.a2;
+            l->ramp[k] = lane_ramp(f->ramp);
+        }
+        l->z1[k] = f->z1;
+        l->z2[k] = f->z2;
+    }
+}
+
+void biquad_lanes_store(const BiquadLanes *l, Biquad *const *filters, size_t count) {
+    if (l == NULL) {
+        return;
+    }
+    for (size_t k = 0; k < count && k < FILTER_LANES; ++k) {
+        Biquad *f = filters[k];
+        f->c.b0 = l->b0[k];
+        f->c.b1 = l->b1[k];
+        f->c.b2 = l->b2[k];
+        f->c.a1 = l->a1[k];
+        f->c.a2 = l->a2[k];
+        f->ramp = (uint32_t)l->ramp[k];
+        f->z1 = l->z1[k];
+        f->z2 = l->z2[k];
+    }
+}
+
+void svf_lanes_load(SvfLanes *l, Svf *const *filters, size_t count) {
+    if (l == NULL) {
+        return;
+    }
+    memset(l, 0, sizeof(*l));
+    for (size_t k = 0; k < count && k < FILTER_LANES; ++k) {
+        const Svf *f = filters[k];
+        l->a1[k] = f->c.a1;
+        l->a2[k] = f->c.a2;
+        l->a3[k] = f->c.a3;
+        l->m0[k] = f->c.m0;
+        l->m1[k] = f->c.m1;
+        l->m2[k] = f->c.m2;
+        if (f->ramp != 0u) {
+            l->sa1[k] = f->step.a1;
+            l->sa2[k] = f->step.a2;
+            l->sa3[k] = f->step.a3;
+            l->sm0[k] = f->step.m0;
+            l->sm1[k] = f->step.m1;
+            l->sm2[k] = f->step.m2;
+            l->ramp[k] = lane_ramp(f->ramp);
+        }
+        l->ic1[k] = f->ic1;
+        l->ic2[k] = f->ic2;
+    }
+}
+
+void svf_lanes_store(const SvfLanes *l, Svf *const *filters, size_t count) {
+    if (l == NULL) {
+        return;
+    }
+    for (size_t k = 0; k < count && k < FILTER_LANES; ++k) {
+        Svf *f = filters[k];
+        f->c.a1 = l->a1[k];
+        f->c.a2 = l->a2[k];
+        f->c.a3 = l->a3[k];
+        f->c.m0 = l->m0[k];
+        f->c.m1 = l->m1[k];
+        f->c.m2 = l->m2[k];
+        f->ramp = (uint32_t)l->ramp[k];
+        f->ic1 = l->ic1[k];
+        f->ic2 = l->ic2[k];
+    }
+}
+
+/*
+ * Each lane group reads its buffers into a frame-major block, so one tick
+ * filters a sample of every lane, and writes the block back afterwards.
+ */
+#define DEFINE_FILTER_BANK_BODY(name, Filter, Lanes)                                   \
+    CPU_INLINE void name##_bank_body(Filter *const *filters, float *const *bufs,      \
+                                     size_t count, size_t frames) {                   \
+        for (size_t g = 0; g < count; g += FILTER_LANES) {                            \
+            const size_t lanes = count - g < FILTER_LANES ? count - g : FILTER_LANES; \
+            Lanes state;                                                              \
+            name##_lanes_load(&state, filters + g, lanes);                            \
+            for (size_t i = 0; i < frames; i += FILTER_CHUNK) {                       \
+                const size_t n = frames - i < FILTER_CHUNK ? frames - i : FILTER_CHUNK; \
+                float block[FILTER_CHUNK][FILTER_LANES] = {{0.0f}};                   \
+                for (size_t k = 0; k < lanes; ++k) {                                  \
+                    const float *src = bufs[g + k] + i;                               \
+                    for (size_t j = 0; j < n; ++j) {                                  \
+                        block[j][k] = src[j];                                         \
+                    }                                                                 \
+                }                                                                     \
+                for (size_t j = 0; j < n; ++j) {                                      \
+                    name##_lanes_tick(&state, block[j]);                              \
+                }                                                                     \
+                for (size_t k = 0; k < lanes; ++k) {                                  \
+                    float *dst = bufs[g + k] + i;                                     \
+                    for (size_t j = 0; j < n; ++j) {                                  \
+                        dst[j] = block[j][k];                                         \
+                    }                                                                 \
+                }                                                                     \
+            }                                                                         \
+            name##_lanes_store(&state, filters + g, lanes);                           \
+        }                                                                             \
+    }
+
+DEFINE_FILTER_BANK_BODY(biquad, Biquad, BiquadLanes)
+DEFINE_FILTER_BANK_BODY(svf, Svf, SvfLanes)
+
+typedef struct {
+    void (*biquad)(Biquad *const *, float *const *, size_t, size_t);
+    void (*svf)(Svf *const *, float *const *, size_t, size_t);
+} FilterKernels;
+
+#define DEFINE_FILTER_KERNELS(suffix, attr)                                            \
+    attr static void biquad_bank_##suffix(Biquad *const *filters, float *const *bufs, \
+                                          size_t count, size_t frames) {              \
+        biquad_bank_body(filters, bufs, count, frames);                               \
+    }                                                                                 \
+    attr static void svf_bank_##suffix(Svf *const *filters, float *const *bufs,       \
+                                       size_t count, size_t frames) {                 \
+        svf_bank_body(filters, bufs, count, frames);                                  \
+    }                                                                                 \
+    static const FilterKernels filter_kernels_##suffix = {                           \
+        biquad_bank_##suffix, svf_bank_##suffix,                                      \
+    };
+
+DEFINE_FILTER_KERNELS(baseline, )
+#if CPU_MULTIVERSION
+DEFINE_FILTER_KERNELS(avx2, CPU_TARGET_AVX2)
+DEFINE_FILTER_KERNELS(avx512, CPU_TARGET_AVX512)
+#endif
+
+static const FilterKernels *filter_kernels_selected = &filter_kernels_baseline;
+static pthread_once_t filter_kernels_once = PTHREAD_ONCE_INIT;
+
+static void filter_kernels_resolve(void) {
+    switch (cpu_dispatch_level()) {
+#if CPU_MULTIVERSION
+        case CPU_LEVEL_AVX512:
+            filter_kernels_selected = &filter_kernels_avx512;
+            break;
+        case CPU_LEVEL_AVX2:
+            filter_kernels_selected = &filter_kernels_avx2;
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+static const FilterKernels *filter_kernels(void) {
+    pthread_once(&filter_kernels_once, filter_kernels_resolve);
+    return filter_kernels_selected;
+}
+
+void biquad_bank_process(Biquad *const *filters, float *const *bufs, size_t count, size_t frames) {
+    if (filters == NULL || bufs == NULL) {
+        return;
+    }
+    filter_kernels()->biquad(filters, bufs, count, frames);
+}
+
+void svf_bank_process(Svf *const *filters, float *const *bufs, size_t count, size_t frames) {
+    if (filters == NULL || bufs == NULL) {
+        return;
+    }
+    filter_kernels()->svf(filters, bufs, count, frames);
+}
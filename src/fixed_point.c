@@ -0,0 +1,18 @@
+#include "fixed_point.h"
+
+#include <math.h>
+#include <stdbool.h>
+
+int16_t q_tanh_table[Q_TANH_STEPS * Q_TANH_RANGE + 1];
+
+static bool tables_ready = false;
+
+void fixed_tables_init(void) {
+    if (tables_ready) {
+        return;
+    }
+    for (int i = 0; i <= Q_TANH_STEPS * Q_TANH_RANGE; ++i) {
+        q_tanh_table[i] = (int16_t)lrint(tanh((double)i / Q_TANH_STEPS) * Q15_ONE);
+    }
+    tables_ready = true;
+}
@@ -0,0 +1,87 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "governor.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* Weight of the newest block in the smoothed load. */
+#define GOVERNOR_SMOOTHING 0.2f
+
+void governor_init(QualityGovernor *g, float budget, int sample_rate) {
+    if (g == NULL) {
+        return;
+    }
+    memset(g, 0, sizeof(*g));
+    g->budget = budget > 0.0f ? budget : 0.0f;
+    g->sample_rate = sample_rate > 0 ? sample_rate : 44100;
+}
+
+void governor_block_begin(QualityGovernor *g) {
+    if (g == NULL || g->budget <= 0.0f) {
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &g->block_start);
+}
+
+static void governor_log(const QualityGovernor *g, const char *direction) {
+    fprintf(stderr, "synthrave: governor %s to %s at %.2fs (load %.3g, budget %.3g)\n",
+            direction, governor_level_name(g->level),
+            (double)g->frames / (double)g->sample_rate, (double)g->load, (double)g->budget);
+}
+
+bool governor_block_end(QualityGovernor *g, size_t frames) {
+    if (g == NULL || g->budget <= 0.0f || frames == 0) {
+        return false;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const double spent = (double)(now.tv_sec - g->block_start.tv_sec) +
+                         (double)(now.tv_nsec - g->block_start.tv_nsec) * 1e-9;
+    const double audio = (double)frames / (double)g->sample_rate;
+    g->load += GOVERNOR_SMOOTHING * ((float)(spent / audio) - g->load);
+    g->frames += frames;
+
+    if (g->hold > 0u) {
+        --g->hold;
+        return false;
+    }
+    if (g->load > g->budget && g->level + 1 < GOVERNOR_LEVEL_COUNT) {
+        g->level = (GovernorLevel)(g->level + 1);
+        g->hold = GOVERNOR_HOLD_BLOCKS;
+        governor_log(g, "down");
+        return true;
+    }
+    if (g->load < 0.5f * g->budget && g->level > GOVERNOR_FULL) {
+        g->level = (GovernorLevel)(g->level - 1);
+        g->hold = GOVERNOR_RECOVER_BLOCKS;
+        governor_log(g, "up");
+        return true;
+    }
+    return false;
+}
+
+void governor_report(const QualityGovernor *g) {
+    if (g == NULL || g->budget <= 0.0f || (g->level == GOVERNOR_FULL && g->culled == 0)) {
+        return;
+    }
+    fprintf(stderr, "synthrave: governor ended at %s, %zu quiet voice(s) culled\n",
+            governor_level_name(g->level), g->culled);
+}
+
+const char *governor_level_name(GovernorLevel level) {
+    switch (level) {
+        case GOVERNOR_FULL:
+            return "full quality";
+        case GOVERNOR_FEWER_PARTIALS:
+            return "fewer partials";
+        case GOVERNOR_LINEAR_RESAMPLE:
+            return "linear resampling";
+        case GOVERNOR_SLOW_CONTROL:
+            return "slow control rate";
+        case GOVERNOR_CULL:
+            return "voice culling";
+        default:
+            return "?";
+    }
+}
@@ -1,6 +1,12 @@
 #include "instrument.h"
 
+#include "fast_math.h"
+#include "fixed_point.h"
+#include "oscillator.h"
+
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -19,9 +25,9 @@ static float clampf(float value, float min, float max) {
 static float waveform(SynthInstrumentKind kind, float phase) {
     switch (kind) {
     case SYNTH_INSTRUMENT_SINE:
-        return sinf(phase);
+        return dsp_sinf(phase);
     case SYNTH_INSTRUMENT_SQUARE:
-        return sinf(phase) >= 0.0f ? 0.8f : -0.8f;
+        return dsp_sinf(phase) >= 0.0f ? 0.8f : -0.8f;
     case SYNTH_INSTRUMENT_SAW: {
         float normalized = phase / (2.0f * (float)M_PI);
         normalized -= floorf(normalized);
@@ -95,3 +101,206 @@ float synth_instrument_sample(const SynthInstrument *instrument,
     const float phase = 2.0f * (float)M_PI * frequency * time_since_start;
     return env * waveform(instrument ? instrument->kind : SYNTH_INSTRUMENT_SINE, phase);
 }
+
+/* Samples rendered from `offset` on before time `end`. */
+static uint32_t samples_until(float end, float offset, float sample_rate) {
+    const double n = ceil(((double)end - (double)offset) * (double)sample_rate);
+    if (n <= 0.0) {
+        return 0u;
+    }
+    return n < 4294967295.0 ? (uint32_t)n : UINT32_MAX;
+}
+
+/* Level an envelope stage ends on. */
+static float stage_target(const SynthVoice *voice, SynthEnvStage stage) {
+    switch (stage) {
+    case SYNTH_ENV_ATTACK:
+        return 1.0f;
+    case SYNTH_ENV_DECAY:
+    case SYNTH_ENV_SUSTAIN:
+        return voice->sustain;
+    default:
+        return 0.0f;
+    }
+}
+
+static int32_t stage_target_q(const SynthVoice *voice, SynthEnvStage stage) {
+    switch (stage) {
+    case SYNTH_ENV_ATTACK:
+        return Q31_ONE;
+    case SYNTH_ENV_DECAY:
+    case SYNTH_ENV_SUSTAIN:
+        return voice->sustain_q;
+    default:
+        return 0;
+    }
+}
+
+/* Enters `stage` (or the first non-empty one after it) at level `env` (`env_q` in Q31). */
+static void voice_enter(SynthVoice *voice, SynthEnvStage stage, float env, int32_t env_q) {
+    while (stage < SYNTH_ENV_DONE && voice->stage_len[stage] == 0u) {
+        ++stage;
+    }
+    voice->stage = stage;
+    if (stage == SYNTH_ENV_DONE) {
+        voice->stage_left = 0u;
+        voice->env = 0.0f;
+        voice->step = 0.0f;
+        voice->env_q = 0;
+        voice->step_q = 0;
+        return;
+    }
+    voice->stage_left = voice->stage_len[stage];
+    voice->env = env;
+    voice->step = (stage_target(voice, stage) - env) / (float)voice->stage_left;
+    voice->env_q = env_q;
+    voice->step_q =
+        (int32_t)(((int64_t)stage_target_q(voice, stage) - env_q) / (int64_t)voice->stage_left);
+}
+
+void synth_voice_init(SynthVoice *voice,
+                      const SynthInstrument *instrument,
+                      float frequency,
+                      float note_duration,
+                      float velocity,
+                      float start_offset,
+                      float sample_rate) {
+    if (voice == NULL) {
+        return;
+    }
+    memset(voice, 0, sizeof(*voice));
+    voice->stage = SYNTH_ENV_DONE;
+    if (instrument == NULL || sample_rate <= 0.0f) {
+        return;
+    }
+    osc_tables_init();
+
+    const float attack = fmaxf(instrument->attack, 1.0e-4f);
+    const float decay_end = attack + fmaxf(instrument->decay, 1.0e-4f);
+    const float sustain_end = note_duration > decay_end ? note_duration : decay_end;
+    const float ends[SYNTH_ENV_DONE] = {
+        attack, decay_end, sustain_end, sustain_end + fmaxf(instrument->release, 1.0e-4f),
+    };
+    const float offset = start_offset > 0.0f ? start_offset : 0.0f;
+    uint32_t done = 0u;
+    for (int s = 0; s < SYNTH_ENV_DONE; ++s) {
+        const uint32_t until = samples_until(ends[s], offset, sample_rate);
+        voice->stage_len[s] = until > done ? until - done : 0u;
+        done = until > done ? until : done;
+    }
+
+    voice->kind = instrument->kind;
+    voice->sustain = clampf(instrument->sustain, 0.0f, 1.0f);
+    voice->gain = clampf(velocity, 0.0f, 1.0f);
+    voice->sustain_q = q_from_float(voice->sustain, 31);
+    voice->gain_q = q_from_float(voice->gain, 15);
+    voice->inc = osc_phase_inc(frequency, sample_rate);
+    const double cycles = (double)frequency * (double)offset;
+    voice->phase = (uint32_t)(int64_t)((cycles - floor(cycles)) * 4294967296.0);
+    const float env = adsr(instrument, offset, note_duration);
+    voice_enter(voice, SYNTH_ENV_ATTACK, env, q_from_float(env, 31));
+}
+
+#define VOICE_RUN(wave)                                   \
+    for (size_t i = 0; i < frames; ++i) {                 \
+        out[i] += env * (wave) * gain;                    \
+        env += step;                                      \
+        phase += inc;                                     \
+    }
+
+/* One stretch within a stage: constant step, one waveform. */
+static void voice_run(SynthVoice *voice, float *out, size_t frames) {
+    float env = voice->env;
+    const float step = voice->step;
+    const float gain = voice->gain;
+    uint32_t phase = voice->phase;
+    const uint32_t inc = voice->inc;
+    switch (voice->kind) {
+    case SYNTH_INSTRUMENT_SQUARE:
+        VOICE_RUN(phase < OSC_HALF_CYCLE ? 0.8f : -0.8f)
+        break;
+    case SYNTH_INSTRUMENT_SAW:
+        VOICE_RUN(osc_saw(phase))
+        break;
+    case SYNTH_INSTRUMENT_TRIANGLE:
+        VOICE_RUN(2.0f * fabsf(osc_saw(phase)) - 1.0f)
+        break;
+    default:
+        VOICE_RUN(osc_sine(phase))
+        break;
+    }
+    voice->env = env;
+    voice->phase = phase;
+}
+
+bool synth_voice_render(SynthVoice *voice, float *out, size_t frames) {
+    if (voice == NULL || out == NULL) {
+        return false;
+    }
+    size_t done = 0;
+    while (done < frames && voice->stage != SYNTH_ENV_DONE) {
+        const size_t left = frames - done;
+        const size_t n = left < voice->stage_left ? left : voice->stage_left;
+        voice_run(voice, out + done, n);
+        done += n;
+        voice->stage_left -= (uint32_t)n;
+        if (voice->stage_left == 0u) {
+            const SynthEnvStage next = (SynthEnvStage)(voice->stage + 1);
+            voice_enter(voice, next, stage_target(voice, voice->stage),
+                        stage_target_q(voice, voice->stage));
+        }
+    }
+    return voice->stage != SYNTH_ENV_DONE;
+}
+
+/* Q15 wave times Q15 gain, scaled by the Q31 envelope down to Q20. */
+#define VOICE_RUN_Q(wave)                                                          \
+    for (size_t i = 0; i < frames; ++i) {                                          \
+        out[i] += q_mul(env, ((wave) * gain) >> 15, 31 + 15 - QMIX_BITS);          \
+        env += step;                                                               \
+        phase += inc;                                                              \
+    }
+
+static void voice_run_q(SynthVoice *voice, int32_t *out, size_t frames) {
+    int32_t env = voice->env_q;
+    const int32_t step = voice->step_q;
+    const int32_t gain = voice->gain_q;
+    uint32_t phase = voice->phase;
+    const uint32_t inc = voice->inc;
+    switch (voice->kind) {
+    case SYNTH_INSTRUMENT_SQUARE:
+        VOICE_RUN_Q(phase < OSC_HALF_CYCLE ? 26214 : -26214)
+        break;
+    case SYNTH_INSTRUMENT_SAW:
+        VOICE_RUN_Q(osc_saw_q15(phase))
+        break;
+    case SYNTH_INSTRUMENT_TRIANGLE:
+        VOICE_RUN_Q(2 * abs(osc_saw_q15(phase)) - 32768)
+        break;
+    default:
+        VOICE_RUN_Q(osc_sine_q15(phase))
+        break;
+    }
+    voice->env_q = env;
+    voice->phase = phase;
+}
+
+bool synth_voice_render_q(SynthVoice *voice, int32_t *out, size_t frames) {
+    if (voice == NULL || out == NULL) {
+        return false;
+    }
+    size_t done = 0;
+    while (done < frames && voice->stage != SYNTH_ENV_DONE) {
+        const size_t left = frames - done;
+        const size_t n = left < voice->stage_left ? left : voice->stage_left;
+        voice_run_q(voice, out + done, n);
+        done += n;
+        voice->stage_left -= (uint32_t)n;
+        if (voice->stage_left == 0u) {
+            const SynthEnvStage next = (SynthEnvStage)(voice->stage + 1);
+            voice_enter(voice, next, stage_target(voice, voice->stage),
+                        stage_target_q(voice, voice->stage));
+        }
+    }
+    return voice->stage != SYNTH_ENV_DONE;
+}
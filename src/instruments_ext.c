@@ -1,6 +1,14 @@
 #include "instruments_ext.h"
 
+#include "control_rate.h"
+#include "cpu_dispatch.h"
+#include "denormal.h"
+#include "fast_math.h"
+#include "mix_kernels.h"
+#include "oscillator.h"
+
 #include <math.h>
+#include <pthread.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
@@ -23,42 +31,178 @@ static float clampf(float value, float min, float max) {
     return value;
 }
 
+/* y = 0.9 y[-1] + 0.1 x: the gentle low-pass the subtractive voices share. */
+static const BiquadCoeffs soft_lowpass = {0.1f, 0.0f, 0.0f, -0.9f, 0.0f};
+
+/* Per-sample multiplier that decays by 1/e over time_s seconds. */
+static float decay_coeff(float sample_rate, float time_s) {
+    return expf(-1.0f / (sample_rate * time_s));
+}
+
+/* decay^n for a per-sample multiplier, reusing decay^block for full control blocks. */
+static float decay_over(float decay, float block_decay, size_t n, size_t block) {
+    return n == block ? block_decay : powf(decay, (float)n);
+}
+
+/*
+ * Kernel bodies write through a sink so the overwriting *_process API and the
+ * accumulating *_process_mix API share one loop: with mix NULL sample i is
+ * stored to out[i], otherwise it is added to the buses through the target.
+ */
+typedef struct {
+    float *out;
+    const MixTarget *mix;
+} SynthSink;
+
+/* Choir and strpad scale a partial bank's output, so when mixing they render it in stack chunks. */
+#define SYNTH_MIX_CHUNK 64u
+
+static inline void sink_put(SynthSink sink, size_t i, float v) {
+    if (sink.mix != NULL) {
+        mix_target_add(sink.mix, i, v);
+    } else {
+        sink.out[i] = v;
+    }
+}
+
+/* Frames per partial-bank call: all of them when storing, a chunk when mixing. */
+static size_t sink_chunk_frames(SynthSink sink, size_t remaining) {
+    if (sink.mix == NULL || remaining < SYNTH_MIX_CHUNK) {
+        return remaining;
+    }
+    return SYNTH_MIX_CHUNK;
+}
+
+static void partials_put(PartialBank *bank, SynthSink sink, size_t frames) {
+    if (sink.mix != NULL) {
+        partial_bank_process_mix(bank, sink.mix, frames);
+    } else {
+        partial_bank_process(bank, sink.out, frames);
+    }
+}
+
+/* Bank counterpart of sink_put: lane v goes to outs[v] or through mixes[v]. */
+static inline void lane_put(float *const *outs,
+                            const MixTarget *mixes,
+                            size_t v,
+                            size_t i,
+                            float y) {
+    if (mixes != NULL) {
+        mix_target_add(&mixes[v], i, y);
+    } else {
+        outs[v][i] = y;
+    }
+}
+
+#define SYNTH_PROCESS_API(name, State)                                                 \
+    void name##_process(State *state, const SynthBlockConfig *cfg, float *out,          \
+                        size_t frames) {                                                \
+        if (state == NULL || cfg == NULL || out == NULL || frames == 0u) {              \
+            return;                                                                     \
+        }                                                                               \
+        const SynthSink sink = {out, NULL};                                             \
+        name##_render(state, cfg, sink, frames);                                        \
+    }                                                                                   \
+    void name##_process_mix(State *state, const SynthBlockConfig *cfg,                  \
+                            const MixTarget *mix, size_t frames) {                      \
+        if (state == NULL || cfg == NULL || mix == NULL || frames == 0u) {              \
+            return;                                                                     \
+        }                                                                               \
+        const SynthSink sink = {NULL, mix};                                             \
+        name##_render(state, cfg, sink, frames);                                        \
+    }
+
+#define SYNTH_BANK_API(name, State)                                                    \
+    void name##_bank_process(State *const *states, size_t count,                        \
+                             const SynthBlockConfig *cfg, float *const *outs,           \
+                             size_t frames) {                                           \
+        if (states == NULL || cfg == NULL || outs == NULL) {                            \
+            return;                                                                     \
+        }                                                                               \
+        name##_bank_render(states, count, cfg, outs, NULL, frames);                     \
+    }                                                                                   \
+    void name##_bank_process_mix(State *const *states, size_t count,                    \
+                                 const SynthBlockConfig *cfg, const MixTarget *mixes,   \
+                                 size_t frames) {                                       \
+        if (states == NULL || cfg == NULL || mixes == NULL) {                           \
+            return;                                                                     \
+        }                                                                               \
+        name##_bank_render(states, count, cfg, NULL, mixes, frames);                    \
+    }
+
 /* LASER ------------------------------------------------------------------- */
-void laser_synth_init(LaserSynthState *state, float start_freq, float end_freq, float resonance) {
+void laser_synth_init(LaserSynthState *state,
+                      float sample_rate,
+                      float start_freq,
+                      float end_freq,
+                      float resonance,
+                      float duration_s) {
     if (state == NULL) {
         return;
     }
+    osc_tables_init();
+    const float inc_scale = osc_inc_scale(sample_rate);
     state->base_frequency = start_freq;
     state->target_frequency = end_freq;
-    state->phase = 0.0f;
+    state->phase = 0u;
+    state->resonant_phase = 0u;
     state->sweep_pos = 0.0f;
+    state->sweep_rate = 1.0f / fmaxf(duration_s * sample_rate, 1.0f);
     state->resonance = resonance;
+    state->base_inc = start_freq * inc_scale;
+    state->target_inc = end_freq * inc_scale;
+    state->inc = osc_scaled_inc(state->base_inc);
+    state->resonant_inc = osc_scaled_inc(state->base_inc * resonance);
 }
 
-void laser_synth_process(LaserSynthState *state,
-                         const SynthBlockConfig *cfg,
-                         float *out,
-                         size_t frames) {
-    if (state == NULL || cfg == NULL || out == NULL || frames == 0u) {
-        return;
-    }
-
-    const float sample_rate = cfg->sample_rate;
-    const float sweep_speed = 1.0f / fmaxf(cfg->block_duration, 0.001f);
-    for (size_t i = 0; i < frames; ++i) {
-        state->sweep_pos = fminf(1.0f, state->sweep_pos + sweep_speed / (float)frames);
-        const float freq = lerp(state->base_frequency, state->target_frequency, state->sweep_pos);
-        state->phase += 2.0f * (float)M_PI * freq / sample_rate;
-        if (state->phase > 2.0f * (float)M_PI) {
-            state->phase -= 2.0f * (float)M_PI;
+static void laser_synth_render(LaserSynthState *state,
+                               const SynthBlockConfig *cfg,
+                               SynthSink sink,
+                               size_t frames) {
+    const size_t block = control_block_size(cfg->control_block);
+    uint32_t phase = state->phase;
+    uint32_t resonant_phase = state->resonant_phase;
+    float pos = state->sweep_pos;
+    for (size_t i = 0; i < frames;) {
+        const size_t n = control_span(block, frames - i);
+        const float pos_end = fminf(1.0f, pos + state->sweep_rate * (float)n);
+        const float pos_step = (pos_end - pos) / (float)n;
+        const float inc_end = lerp(state->base_inc, state->target_inc, pos_end);
+        const uint32_t next_inc = osc_scaled_inc(inc_end);
+        const uint32_t next_resonant = osc_scaled_inc(inc_end * state->resonance);
+        const int32_t inc_step = control_inc_step(state->inc, next_inc, n);
+        const int32_t resonant_step = control_inc_step(state->resonant_inc, next_resonant, n);
+        uint32_t inc = state->inc;
+        uint32_t resonant_inc = state->resonant_inc;
+        for (size_t k = 0; k < n; ++k, ++i) {
+            pos += pos_step;
+            inc += (uint32_t)inc_step;
+            resonant_inc += (uint32_t)resonant_step;
+            phase += inc;
+            resonant_phase += resonant_inc;
+            const float resonant = osc_sine(phase) * (0.7f + 0.3f * osc_sine(resonant_phase));
+            sink_put(sink, i, resonant * (1.0f - pos) + osc_sine(phase >> 2) * pos);
         }
-        const float resonant = sinf(state->phase) * (0.7f + 0.3f * sinf(state->phase * state->resonance));
-        out[i] = resonant * (1.0f - state->sweep_pos) + sinf(state->phase * 0.25f) * state->sweep_pos;
+        pos = pos_end;
+        state->inc = next_inc;
+        state->resonant_inc = next_resonant;
     }
+    state->phase = phase;
+    state->resonant_phase = resonant_phase;
+    state->sweep_pos = pos;
 }
 
+SYNTH_PROCESS_API(laser_synth, LaserSynthState)
+
 /* CHOIR ------------------------------------------------------------------- */
-void choir_synth_init(ChoirSynthState *state, float root_frequency) {
+static float cents_to_ratio(float cents) {
+    return powf(2.0f, cents / 1200.0f);
+}
+
+void choir_synth_init(ChoirSynthState *state,
+                      float sample_rate,
+                      float root_frequency,
+                      float softness) {
     if (state == NULL) {
         return;
     }
@@ -66,63 +210,69 @@ void choir_synth_init(ChoirSynthState *state, float root_frequency) {
     state->detune_cents[0] = -6.0f;
     state->detune_cents[1] = 3.0f;
     state->detune_cents[2] = 7.0f;
-    memset(state->phases, 0, sizeof(state->phases));
     state->envelope = 0.0f;
-}
-
-static float cents_to_ratio(float cents) {
-    return powf(2.0f, cents / 1200.0f);
-}
-
-void choir_synth_process(ChoirSynthState *state,
-                         const SynthBlockConfig *cfg,
-                         float softness,
-                         float *out,
-                         size_t frames) {
-    if (state == NULL || cfg == NULL || out == NULL || frames == 0u) {
-        return;
-    }
 
-    const float sample_rate = cfg->sample_rate;
     const float attack = fmaxf(0.02f, softness);
     const float release = fmaxf(0.5f, softness * 4.0f);
-    const float env_delta = 1.0f / (attack * sample_rate);
-    const float env_rel = 1.0f / (release * sample_rate);
+    state->env_attack = 1.0f / (attack * sample_rate);
+    state->env_release = 0.1f / (release * sample_rate);
 
-    for (size_t i = 0; i < frames; ++i) {
-        if (state->envelope < 1.0f) {
-            state->envelope = fminf(1.0f, state->envelope + env_delta);
-        } else {
-            state->envelope = fmaxf(0.6f, state->envelope - env_rel * 0.1f);
-        }
+    partial_bank_init(&state->partials);
+    partial_bank_add(&state->partials, root_frequency, sample_rate, 0.4f, 1.0f);
+    for (size_t v = 0; v < 3; ++v) {
+        const float freq = root_frequency * cents_to_ratio(state->detune_cents[v]);
+        partial_bank_add(&state->partials, freq, sample_rate, 0.2f, 1.0f);
+    }
+    /* formant an octave and a fifth above the root */
+    partial_bank_add(&state->partials, root_frequency * 3.0f, sample_rate, 0.15f, 1.0f);
+}
 
-        float acc = 0.0f;
-        for (size_t v = 0; v < 4; ++v) {
-            float ratio = 1.0f;
-            if (v > 0) {
-                ratio = cents_to_ratio(state->detune_cents[(v - 1) % 3]);
-            }
-            const float freq = state->root_frequency * ratio;
-            state->phases[v] += 2.0f * (float)M_PI * freq / sample_rate;
-            if (state->phases[v] > 2.0f * (float)M_PI) {
-                state->phases[v] -= 2.0f * (float)M_PI;
+static void choir_synth_render(ChoirSynthState *state,
+                               const SynthBlockConfig *cfg,
+                               SynthSink sink,
+                               size_t frames) {
+    const size_t block = control_block_size(cfg->control_block);
+    float chunk[SYNTH_MIX_CHUNK];
+    for (size_t base = 0; base < frames;) {
+        const size_t n = sink_chunk_frames(sink, frames - base);
+        float *buf = sink.mix != NULL ? chunk : sink.out;
+        partial_bank_process(&state->partials, buf, n);
+        for (size_t i = 0; i < n;) {
+            /* attack to 1, then release towards 0.6; the turn lands on a block edge */
+            const size_t span = control_span(block, n - i);
+            const float env = state->envelope;
+            const float env_end = env < 1.0f
+                                      ? fminf(1.0f, env + state->env_attack * (float)span)
+                                      : fmaxf(0.6f, env - state->env_release * (float)span);
+            float gain = 0.4f + 0.6f * env;
+            const float gain_step = control_ramp_step(gain, 0.4f + 0.6f * env_end, span);
+            for (size_t k = 0; k < span; ++k, ++i) {
+                gain += gain_step;
+                sink_put(sink, base + i, buf[i] * gain);
             }
-            acc += sinf(state->phases[v]) * (v == 0 ? 0.4f : 0.2f);
+            state->envelope = env_end;
         }
-        const float formant = sinf(state->phases[0] * 3.0f) * 0.15f;
-        out[i] = (acc + formant) * (0.4f + 0.6f * state->envelope);
+        base += n;
     }
 }
 
+SYNTH_PROCESS_API(choir_synth, ChoirSynthState)
+
 /* ANALOG LEAD ------------------------------------------------------------- */
-void analog_lead_init(AnalogLeadState *state, float start_frequency, float glide_rate) {
+void analog_lead_init(AnalogLeadState *state,
+                      float sample_rate,
+                      float start_frequency,
+                      float glide_rate) {
     if (state == NULL) {
         return;
     }
     state->current_frequency = start_frequency;
     state->target_frequency = start_frequency;
-    state->glide_rate = glide_rate;
-    state->phase = 0.0f;
+    state->glide_rate = clampf(glide_rate, 0.0001f, 0.05f);
+    state->phase = 0u;
+    state->inc_scale = osc_inc_scale(sample_rate);
+    state->inc = osc_scaled_inc(start_frequency * state->inc_scale);
+    osc_tables_init();
 }
 
 void analog_lead_set_target(AnalogLeadState *state, float target_frequency) {
@@ -132,114 +282,216 @@ void analog_lead_set_target(AnalogLeadState *state, float target_frequency) {
     state->target_frequency = target_frequency;
 }
 
-void analog_lead_process(AnalogLeadState *state,
-                         const SynthBlockConfig *cfg,
-                         float *out,
-                         size_t frames) {
-    if (state == NULL || cfg == NULL || out == NULL || frames == 0u) {
-        return;
+static void analog_lead_render(AnalogLeadState *state,
+                               const SynthBlockConfig *cfg,
+                               SynthSink sink,
+                               size_t frames) {
+    const size_t block = control_block_size(cfg->control_block);
+    /* fraction of the remaining distance left after one full control block */
+    const float block_keep = dsp_powf(1.0f - state->glide_rate, (float)block);
+    uint32_t phase = state->phase;
+
+    for (size_t i = 0; i < frames;) {
+        const size_t n = control_span(block, frames - i);
+        const float keep = n == block ? block_keep : dsp_powf(1.0f - state->glide_rate, (float)n);
+        const float diff = state->target_frequency - state->current_frequency;
+        state->current_frequency = state->target_frequency - diff * keep;
+        const uint32_t next_inc = osc_scaled_inc(state->current_frequency * state->inc_scale);
+        const int32_t inc_step = control_inc_step(state->inc, next_inc, n);
+        uint32_t inc = state->inc;
+        for (size_t k = 0; k < n; ++k, ++i) {
+            inc += (uint32_t)inc_step;
+            phase += inc;
+            float saw = osc_saw(phase);
+            float pulse = 0.5f * osc_square(phase * 2u);
+            sink_put(sink, i, 0.7f * saw + 0.3f * pulse);
+        }
+        state->inc = next_inc;
     }
+    state->phase = phase;
+}
 
-    const float sample_rate = cfg->sample_rate;
-    const float glide = clampf(state->glide_rate, 0.0001f, 0.05f);
+SYNTH_PROCESS_API(analog_lead, AnalogLeadState)
 
-    for (size_t i = 0; i < frames; ++i) {
-        const float diff = state->target_frequency - state->current_frequency;
-        state->current_frequency += diff * glide;
-        state->phase += 2.0f * (float)M_PI * state->current_frequency / sample_rate;
-        if (state->phase > 2.0f * (float)M_PI) {
-            state->phase -= 2.0f * (float)M_PI;
+static void analog_lead_bank_render(AnalogLeadState *const *states,
+                                    size_t count,
+                                    const SynthBlockConfig *cfg,
+                                    float *const *outs,
+                                    const MixTarget *mixes,
+                                    size_t frames) {
+    const size_t block = control_block_size(cfg->control_block);
+    for (size_t g = 0; g < count; g += VOICE_BANK_WIDTH) {
+        const size_t lanes = count - g < VOICE_BANK_WIDTH ? count - g : VOICE_BANK_WIDTH;
+        uint32_t phase[VOICE_BANK_WIDTH] = {0}, inc[VOICE_BANK_WIDTH] = {0};
+        int32_t step[VOICE_BANK_WIDTH] = {0};
+        for (size_t k = 0; k < lanes; ++k) {
+            phase[k] = states[g + k]->phase;
+            inc[k] = states[g + k]->inc;
+        }
+        for (size_t i = 0; i < frames;) {
+            const size_t n = control_span(block, frames - i);
+            for (size_t k = 0; k < lanes; ++k) {
+                AnalogLeadState *st = states[g + k];
+                const float keep = dsp_powf(1.0f - st->glide_rate, (float)n);
+                st->current_frequency = st->target_frequency -
+                                        (st->target_frequency - st->current_frequency) * keep;
+                const uint32_t next_inc = osc_scaled_inc(st->current_frequency * st->inc_scale);
+                step[k] = control_inc_step(inc[k], next_inc, n);
+                st->inc = next_inc;
+            }
+            for (size_t j = 0; j < n; ++j, ++i) {
+                float y[VOICE_BANK_WIDTH];
+                for (size_t k = 0; k < VOICE_BANK_WIDTH; ++k) {
+                    inc[k] += (uint32_t)step[k];
+                    phase[k] += inc[k];
+                    y[k] = 0.7f * osc_saw(phase[k]) + 0.15f * osc_square(phase[k] * 2u);
+                }
+                for (size_t k = 0; k < lanes; ++k) {
+                    lane_put(outs, mixes, g + k, i, y[k]);
+                }
+            }
+            for (size_t k = 0; k < lanes; ++k) {
+                inc[k] = states[g + k]->inc;
+            }
+        }
+        for (size_t k = 0; k < lanes; ++k) {
+            states[g + k]->phase = phase[k];
         }
-        float saw = fmodf(state->phase / (2.0f * (float)M_PI), 1.0f) * 2.0f - 1.0f;
-        float pulse = (sinf(state->phase * 2.0f) > 0.0f) ? 0.5f : -0.5f;
-        out[i] = 0.7f * saw + 0.3f * pulse;
     }
 }
 
+SYNTH_BANK_API(analog_lead, AnalogLeadState)
+
 /* SID BASS ---------------------------------------------------------------- */
-void sid_bass_init(SidBassState *state, float frequency, float step_duration_ms) {
+static const float sid_step_gains[3] = {0.9f, 0.4f, 0.2f};
+
+void sid_bass_init(SidBassState *state,
+                   float sample_rate,
+                   float frequency,
+                   float step_duration_ms) {
     if (state == NULL) {
         return;
     }
     state->frequency = frequency;
-    state->phase = 0.0f;
-    state->step_duration = step_duration_ms / 1000.0f;
+    state->phase = 0u;
+    state->phase_inc = osc_phase_inc(frequency, sample_rate);
+    state->step_duration = fmaxf(step_duration_ms / 1000.0f, 0.01f);
     state->time_in_step = 0.0f;
+    state->time_step = 1.0f / sample_rate;
     state->step_index = 0;
+    state->step_gain = sid_step_gains[0];
 }
 
-void sid_bass_process(SidBassState *state,
-                      const SynthBlockConfig *cfg,
-                      float *out,
-                      size_t frames) {
-    if (state == NULL || cfg == NULL || out == NULL || frames == 0u) {
-        return;
+static void sid_bass_render(SidBassState *state,
+                            const SynthBlockConfig *cfg,
+                            SynthSink sink,
+                            size_t frames) {
+    (void)cfg;
+
+    for (size_t i = 0; i < frames; ++i) {
+        state->phase += state->phase_inc;
+        sink_put(sink, i, osc_square(state->phase) * state->step_gain);
+        state->time_in_step += state->time_step;
+        if (state->time_in_step >= state->step_duration) {
+            state->time_in_step -= state->step_duration;
+            state->step_index = (state->step_index + 1) % 3;
+            state->step_gain = sid_step_gains[state->step_index];
+        }
     }
+}
 
-    const float sample_rate = cfg->sample_rate;
-    const float step_length = fmaxf(state->step_duration, 0.01f);
+SYNTH_PROCESS_API(sid_bass, SidBassState)
 
-    for (size_t i = 0; i < frames; ++i) {
-        state->phase += 2.0f * (float)M_PI * state->frequency / sample_rate;
-        if (state->phase > 2.0f * (float)M_PI) {
-            state->phase -= 2.0f * (float)M_PI;
-        }
-        float square = sinf(state->phase) >= 0.0f ? 1.0f : -1.0f;
-        float step_gain = 0.0f;
-        switch (state->step_index % 3) {
-        case 0:
-            step_gain = 0.9f;
-            break;
-        case 1:
-            step_gain = 0.4f;
-            break;
-        default:
-            step_gain = 0.2f;
-            break;
+static void sid_bass_bank_render(SidBassState *const *states,
+                                 size_t count,
+                                 const SynthBlockConfig *cfg,
+                                 float *const *outs,
+                                 const MixTarget *mixes,
+                                 size_t frames) {
+    (void)cfg;
+    for (size_t g = 0; g < count; g += VOICE_BANK_WIDTH) {
+        const size_t lanes = count - g < VOICE_BANK_WIDTH ? count - g : VOICE_BANK_WIDTH;
+        uint32_t phase[VOICE_BANK_WIDTH] = {0}, inc[VOICE_BANK_WIDTH] = {0};
+        float gain[VOICE_BANK_WIDTH] = {0.0f}, t[VOICE_BANK_WIDTH] = {0.0f};
+        float dt[VOICE_BANK_WIDTH] = {0.0f}, len[VOICE_BANK_WIDTH];
+        int index[VOICE_BANK_WIDTH] = {0};
+        for (size_t k = 0; k < VOICE_BANK_WIDTH; ++k) {
+            len[k] = 1.0f;
         }
-        out[i] = square * step_gain;
-        state->time_in_step += 1.0f / sample_rate;
-        if (state->time_in_step >= step_length) {
-            state->time_in_step -= step_length;
-            state->step_index = (state->step_index + 1) % 3;
+        for (size_t k = 0; k < lanes; ++k) {
+            const SidBassState *st = states[g + k];
+            phase[k] = st->phase;
+            inc[k] = st->phase_inc;
+            gain[k] = st->step_gain;
+            t[k] = st->time_in_step;
+            dt[k] = st->time_step;
+            len[k] = st->step_duration;
+            index[k] = st->step_index;
+        }
+        for (size_t i = 0; i < frames; ++i) {
+            float y[VOICE_BANK_WIDTH];
+            for (size_t k = 0; k < VOICE_BANK_WIDTH; ++k) {
+                phase[k] += inc[k];
+                y[k] = osc_square(phase[k]) * gain[k];
+                t[k] += dt[k];
+            }
+            for (size_t k = 0; k < lanes; ++k) {
+                lane_put(outs, mixes, g + k, i, y[k]);
+                if (t[k] >= len[k]) {
+                    t[k] -= len[k];
+                    index[k] = (index[k] + 1) % 3;
+                    gain[k] = sid_step_gains[index[k]];
+                }
+            }
+        }
+        for (size_t k = 0; k < lanes; ++k) {
+            SidBassState *st = states[g + k];
+            st->phase = phase[k];
+            st->step_gain = gain[k];
+            st->time_in_step = t[k];
+            st->step_index = index[k];
         }
     }
 }
 
+SYNTH_BANK_API(sid_bass, SidBassState)
+
 /* CHIP ARP ---------------------------------------------------------------- */
-void chip_arp_init(ChipArpState *state, const float *notes_hz, size_t note_count, float tick_ms) {
+void chip_arp_init(ChipArpState *state,
+                   float sample_rate,
+                   const float *notes_hz,
+                   size_t note_count,
+                   float tick_ms) {
     if (state == NULL) {
         return;
     }
     state->note_count = note_count > 4 ? 4 : note_count;
     for (size_t i = 0; i < state->note_count; ++i) {
         state->notes_hz[i] = notes_hz ? notes_hz[i] : 440.0f;
+        state->note_incs[i] = osc_phase_inc(state->notes_hz[i], sample_rate);
     }
     state->current_note = 0;
-    state->phase = 0.0f;
+    state->phase = 0u;
+    osc_tables_init();
     state->tick_duration = fmaxf(tick_ms, 5.0f) / 1000.0f;
     state->tick_time = 0.0f;
+    state->time_step = 1.0f / sample_rate;
 }
 
-void chip_arp_process(ChipArpState *state,
-                      const SynthBlockConfig *cfg,
-                      float *out,
-                      size_t frames) {
-    if (state == NULL || cfg == NULL || out == NULL || frames == 0u || state->note_count == 0u) {
+static void chip_arp_render(ChipArpState *state,
+                            const SynthBlockConfig *cfg,
+                            SynthSink sink,
+                            size_t frames) {
+    (void)cfg;
+    if (state->note_count == 0u) {
         return;
     }
 
-    const float sample_rate = cfg->sample_rate;
-
     for (size_t i = 0; i < frames; ++i) {
-        const float freq = state->notes_hz[state->current_note];
-        state->phase += 2.0f * (float)M_PI * freq / sample_rate;
-        if (state->phase > 2.0f * (float)M_PI) {
-            state->phase -= 2.0f * (float)M_PI;
-        }
-        out[i] = sinf(state->phase) * 0.6f;
+        state->phase += state->note_incs[state->current_note];
+        sink_put(sink, i, osc_sine(state->phase) * 0.6f);
 
-        state->tick_time += 1.0f / sample_rate;
+        state->tick_time += state->time_step;
         if (state->tick_time >= state->tick_duration) {
             state->tick_time -= state->tick_duration;
             state->current_note = (state->current_note + 1u) % state->note_count;
@@ -247,232 +499,432 @@ void chip_arp_process(ChipArpState *state,
     }
 }
 
+SYNTH_PROCESS_API(chip_arp, ChipArpState)
+
 /* ------------------------------------------------------------------------- */
 static float frand(void) {
     return ((float)rand() / (float)RAND_MAX) * 2.0f - 1.0f;
 }
 
-void kick_state_init(KickState *state) {
+void kick_state_init(KickState *state,
+                     float sample_rate,
+                     float start_freq,
+                     float end_freq,
+                     float duration_s) {
     if (state == NULL) {
         return;
     }
     memset(state, 0, sizeof(*state));
+    osc_tables_init();
+    const float inc_scale = osc_inc_scale(sample_rate);
+    state->sweep_rate = 1.0f / fmaxf(duration_s * sample_rate, 1.0f);
+    state->start_inc = start_freq * inc_scale;
+    state->end_inc = end_freq * inc_scale;
+    state->inc = osc_scaled_inc(state->start_inc);
+    /* body follows exp(-4 * sweep_pos) until the sweep saturates */
+    state->body_env = 1.0f;
+    state->click_env = 1.0f;
+    state->body_decay = expf(-4.0f * state->sweep_rate);
+    state->body_floor = expf(-4.0f);
+    /* ~2.5 ms ramp to remove clicks */
+    state->attack_step = 1.0f / fmaxf(sample_rate * 0.0025f, 1.0f);
 }
 
-void kick_process(KickState *state,
-                  const SynthBlockConfig *cfg,
-                  float start_freq,
-                  float end_freq,
-                  float duration_s,
-                  float *out,
-                  size_t frames) {
-    if (state == NULL || cfg == NULL || out == NULL || frames == 0u) {
-        return;
-    }
-    const float sample_rate = cfg->sample_rate;
-    const float sweep_rate = frames > 0 ? 1.0f / fmaxf(duration_s * sample_rate, 1.0f) : 0.0f;
-    const float attack_samples = fmaxf(sample_rate * 0.0025f, 1.0f); /* ~2.5 ms ramp to remove clicks */
-    for (size_t i = 0; i < frames; ++i) {
-        state->sweep_pos = fminf(1.0f, state->sweep_pos + sweep_rate);
-        const float freq = lerp(start_freq, end_freq, state->sweep_pos);
-        state->phase += 2.0f * (float)M_PI * freq / sample_rate;
-        if (state->phase > 2.0f * (float)M_PI) {
-            state->phase -= 2.0f * (float)M_PI;
+static void kick_render(KickState *state,
+                        const SynthBlockConfig *cfg,
+                        SynthSink sink,
+                        size_t frames) {
+    const size_t block = control_block_size(cfg->control_block);
+    const float block_body_decay = powf(state->body_decay, (float)block);
+    for (size_t i = 0; i < frames;) {
+        size_t n = control_span(block, frames - i);
+        if (state->attack < 1.0f) {
+            /* end the block where the attack ramp tops out so it never overshoots */
+            const size_t rest = (size_t)ceilf((1.0f - state->attack) / state->attack_step);
+            n = rest > 0u && rest < n ? rest : n;
         }
-        const float body = sinf(state->phase) * expf(-4.0f * state->sweep_pos);
-        state->click_env = fmaxf(0.0f, 1.0f - state->sweep_pos * 8.0f);
-        const float click = state->click_env * (frand() * 0.4f + 0.6f);
-        float sample = body + click * 0.08f;
-        const float attack = fminf(((float)i) / attack_samples, 1.0f);
-        out[i] = sample * attack;
+        const float pos_end = fminf(1.0f, state->sweep_pos + state->sweep_rate * (float)n);
+        const uint32_t next_inc = osc_scaled_inc(lerp(state->start_inc, state->end_inc, pos_end));
+        const int32_t inc_step = control_inc_step(state->inc, next_inc, n);
+        const float body_keep = decay_over(state->body_decay, block_body_decay, n, block);
+        const float body_end = fmaxf(state->body_env * body_keep, state->body_floor);
+        const float click_end = fmaxf(0.0f, 1.0f - pos_end * 8.0f);
+        const float attack_end = fminf(state->attack + state->attack_step * (float)n, 1.0f);
+        const float body_step = control_ramp_step(state->body_env, body_end, n);
+        const float click_step = control_ramp_step(state->click_env, click_end, n);
+        const float attack_step = control_ramp_step(state->attack, attack_end, n);
+        float body_env = state->body_env;
+        float click_env = state->click_env;
+        float attack = state->attack;
+        for (size_t k = 0; k < n; ++k, ++i) {
+            state->inc += (uint32_t)inc_step;
+            state->phase += state->inc;
+            body_env += body_step;
+            click_env += click_step;
+            const float body = osc_sine(state->phase) * body_env;
+            const float click = click_env * (frand() * 0.4f + 0.6f);
+            float sample = body + click * 0.08f;
+            sink_put(sink, i, sample * attack);
+            attack += attack_step;
+        }
+        state->sweep_pos = pos_end;
+        state->inc = next_inc;
+        state->body_env = body_end;
+        state->click_env = click_end;
+        state->attack = attack_end;
     }
 }
 
-void snare_state_init(SnareState *state) {
+SYNTH_PROCESS_API(kick, KickState)
+
+void snare_state_init(SnareState *state,
+                      float sample_rate,
+                      float body_freq,
+                      float duration_s) {
     if (state == NULL) {
         return;
     }
     memset(state, 0, sizeof(*state));
-    state->noise_seed = 0.5f;
+    osc_tables_init();
+    /* first-order high-pass 0.5 (1 - z^-1) / (1 - 0.4 z^-1), as if the noise sat at 0.5 */
+    biquad_init(&state->noise_hp, (BiquadCoeffs){0.5f, -0.5f, 0.0f, -0.4f, 0.0f});
+    state->noise_hp.z1 = -0.25f;
     state->env_noise = 1.0f;
     state->env_body = 1.0f;
+    state->body_inc = osc_phase_inc(body_freq, sample_rate);
+    state->noise_decay = decay_coeff(sample_rate, fmaxf(duration_s * 0.6f, 0.01f));
+    state->body_decay = decay_coeff(sample_rate, fmaxf(duration_s * 0.3f, 0.01f));
 }
 
-void snare_process(SnareState *state,
-                   const SynthBlockConfig *cfg,
-                   float body_freq,
-                   float duration_s,
-                   float *out,
-                   size_t frames) {
-    if (state == NULL || cfg == NULL || out == NULL) {
-        return;
-    }
-    const float sample_rate = cfg->sample_rate;
-    const float noise_decay = expf(-1.0f / (sample_rate * fmaxf(duration_s * 0.6f, 0.01f)));
-    const float body_decay = expf(-1.0f / (sample_rate * fmaxf(duration_s * 0.3f, 0.01f)));
-    for (size_t i = 0; i < frames; ++i) {
-        float noise = frand();
-        float hp = noise - state->noise_seed;
-        state->noise_seed = noise * 0.6f + state->noise_seed * 0.4f;
-        float filtered = hp - 0.5f * (hp);
-        state->body_phase += 2.0f * (float)M_PI * body_freq / sample_rate;
-        if (state->body_phase > 2.0f * (float)M_PI) {
-            state->body_phase -= 2.0f * (float)M_PI;
+static void snare_render(SnareState *state,
+                         const SynthBlockConfig *cfg,
+                         SynthSink sink,
+                         size_t frames) {
+    const size_t block = control_block_size(cfg->control_block);
+    const float block_noise_decay = powf(state->noise_decay, (float)block);
+    const float block_body_decay = powf(state->body_decay, (float)block);
+    for (size_t i = 0; i < frames;) {
+        const size_t n = control_span(block, frames - i);
+        const float noise_end =
+            state->env_noise * decay_over(state->noise_decay, block_noise_decay, n, block);
+        const float body_end =
+            state->env_body * decay_over(state->body_decay, block_body_decay, n, block);
+        const float noise_step = control_ramp_step(state->env_noise, noise_end, n);
+        const float body_step = control_ramp_step(state->env_body, body_end, n);
+        float env_noise = state->env_noise;
+        float env_body = state->env_body;
+        for (size_t k = 0; k < n; ++k, ++i) {
+            const float filtered = biquad_tick(&state->noise_hp, frand());
+            state->body_phase += state->body_inc;
+            float body = osc_sine(state->body_phase);
+            sink_put(sink, i, filtered * env_noise * 0.8f + body * env_body * 0.4f);
+            env_noise += noise_step;
+            env_body += body_step;
         }
-        float body = sinf(state->body_phase);
-        out[i] = filtered * state->env_noise * 0.8f + body * state->env_body * 0.4f;
-        state->env_noise *= noise_decay;
-        state->env_body *= body_decay;
+        state->env_noise = noise_end;
+        state->env_body = body_end;
     }
+    state->env_noise = denormal_flush(state->env_noise);
+    state->env_body = denormal_flush(state->env_body);
 }
 
-void hat_state_init(HatState *state) {
+SYNTH_PROCESS_API(snare, SnareState)
+
+void hat_state_init(HatState *state, float sample_rate) {
     if (state == NULL) {
         return;
     }
     memset(state, 0, sizeof(*state));
+    osc_tables_init();
+    biquad_init(&state->noise_hp, (BiquadCoeffs){1.0f, -0.6f, 0.0f, 0.0f, 0.0f});
     state->env = 1.0f;
+    state->decay = decay_coeff(sample_rate, 0.02f);
+    state->metallic_inc = osc_phase_inc(8000.0f, sample_rate);
 }
 
-void hat_process(HatState *state,
-                 const SynthBlockConfig *cfg,
-                 float *out,
-                 size_t frames) {
-    if (state == NULL || cfg == NULL || out == NULL) {
-        return;
-    }
-    const float sample_rate = cfg->sample_rate;
-    const float decay = expf(-1.0f / (sample_rate * 0.02f));
-    for (size_t i = 0; i < frames; ++i) {
-        float noise = frand();
-        float hp = noise - 0.6f * state->noise_seed;
-        state->noise_seed = noise;
-        state->metallic_phase += 2.0f * (float)M_PI * 8000.0f / sample_rate;
-        if (state->metallic_phase > 2.0f * (float)M_PI) {
-            state->metallic_phase -= 2.0f * (float)M_PI;
+static void hat_render(HatState *state,
+                       const SynthBlockConfig *cfg,
+                       SynthSink sink,
+                       size_t frames) {
+    const size_t block = control_block_size(cfg->control_block);
+    const float block_decay = powf(state->decay, (float)block);
+    for (size_t i = 0; i < frames;) {
+        const size_t n = control_span(block, frames - i);
+        const float env_end = state->env * decay_over(state->decay, block_decay, n, block);
+        const float env_step = control_ramp_step(state->env, env_end, n);
+        float env = state->env;
+        for (size_t k = 0; k < n; ++k, ++i) {
+            const float hp = biquad_tick(&state->noise_hp, frand());
+            state->metallic_phase += state->metallic_inc;
+            const uint32_t overtone = state->metallic_phase + (state->metallic_phase >> 1);
+            float metallic = osc_sine(state->metallic_phase) * 0.3f + osc_sine(overtone) * 0.2f;
+            sink_put(sink, i, (hp * 0.7f + metallic) * env);
+            env += env_step;
         }
-        float metallic = sinf(state->metallic_phase) * 0.3f + sinf(state->metallic_phase * 1.5f) * 0.2f;
-        out[i] = (hp * 0.7f + metallic) * state->env;
-        state->env *= decay;
+        state->env = env_end;
     }
+    state->env = denormal_flush(state->env);
 }
 
-void bass_state_init(BassState *state) {
+SYNTH_PROCESS_API(hat, HatState)
+
+void bass_state_init(BassState *state, float sample_rate, float frequency) {
     if (state == NULL) {
         return;
     }
     memset(state, 0, sizeof(*state));
+    osc_tables_init();
+    state->main_inc = osc_phase_inc(frequency, sample_rate);
+    state->sub_inc = osc_phase_inc(frequency * 0.5f, sample_rate);
+    biquad_init(&state->filter, soft_lowpass);
 }
 
-void bass_process(BassState *state,
-                  const SynthBlockConfig *cfg,
-                  float frequency,
-                  float *out,
-                  size_t frames) {
-    if (state == NULL || cfg == NULL || out == NULL) {
-        return;
-    }
-    const float sample_rate = cfg->sample_rate;
-    const float sub_freq = frequency * 0.5f;
+static void bass_render(BassState *state,
+                        const SynthBlockConfig *cfg,
+                        SynthSink sink,
+                        size_t frames) {
+    (void)cfg;
     for (size_t i = 0; i < frames; ++i) {
-        state->phase_main += 2.0f * (float)M_PI * frequency / sample_rate;
-        state->phase_sub += 2.0f * (float)M_PI * sub_freq / sample_rate;
-        if (state->phase_main > 2.0f * (float)M_PI) {
-            state->phase_main -= 2.0f * (float)M_PI;
+        state->phase_main += state->main_inc;
+        state->phase_sub += state->sub_inc;
+        float saw = osc_saw(state->phase_main);
+        float sub = osc_sine(state->phase_sub);
+        float mixed = 0.6f * saw + 0.4f * sub;
+        sink_put(sink, i, biquad_tick(&state->filter, mixed));
+    }
+}
+
+SYNTH_PROCESS_API(bass, BassState)
+
+/* One bank group is one filter group; BiquadLanes is indexed by bank lane. */
+_Static_assert(VOICE_BANK_WIDTH == FILTER_LANES, "bass bank groups must match BiquadLanes");
+
+static void bass_bank_render(BassState *const *states,
+                             size_t count,
+                             const SynthBlockConfig *cfg,
+                             float *const *outs,
+                             const MixTarget *mixes,
+                             size_t frames) {
+    (void)cfg;
+    for (size_t g = 0; g < count; g += VOICE_BANK_WIDTH) {
+        const size_t lanes = count - g < VOICE_BANK_WIDTH ? count - g : VOICE_BANK_WIDTH;
+        uint32_t main_phase[VOICE_BANK_WIDTH] = {0}, sub_phase[VOICE_BANK_WIDTH] = {0};
+        uint32_t main_inc[VOICE_BANK_WIDTH] = {0}, sub_inc[VOICE_BANK_WIDTH] = {0};
+        Biquad *filters[VOICE_BANK_WIDTH];
+        BiquadLanes filter;
+        for (size_t k = 0; k < lanes; ++k) {
+            BassState *st = states[g + k];
+            main_phase[k] = st->phase_main;
+            sub_phase[k] = st->phase_sub;
+            main_inc[k] = st->main_inc;
+            sub_inc[k] = st->sub_inc;
+            filters[k] = &st->filter;
+        }
+        biquad_lanes_load(&filter, filters, lanes);
+        for (size_t i = 0; i < frames; ++i) {
+            float mixed[VOICE_BANK_WIDTH];
+            for (size_t k = 0; k < VOICE_BANK_WIDTH; ++k) {
+                main_phase[k] += main_inc[k];
+                sub_phase[k] += sub_inc[k];
+                mixed[k] = 0.6f * osc_saw(main_phase[k]) + 0.4f * osc_sine(sub_phase[k]);
+            }
+            biquad_lanes_tick(&filter, mixed);
+            for (size_t k = 0; k < lanes; ++k) {
+                lane_put(outs, mixes, g + k, i, mixed[k]);
+            }
         }
-        if (state->phase_sub > 2.0f * (float)M_PI) {
-            state->phase_sub -= 2.0f * (float)M_PI;
+        biquad_lanes_store(&filter, filters, lanes);
+        for (size_t k = 0; k < lanes; ++k) {
+            BassState *st = states[g + k];
+            st->phase_main = main_phase[k];
+            st->phase_sub = sub_phase[k];
         }
-        float saw = fmodf(state->phase_main / (2.0f * (float)M_PI), 1.0f) * 2.0f - 1.0f;
-        float sub = sinf(state->phase_sub);
-        float mixed = 0.6f * saw + 0.4f * sub;
-        state->filter_state = 0.9f * state->filter_state + 0.1f * mixed;
-        out[i] = state->filter_state;
     }
 }
 
-void flute_state_init(FluteState *state) {
+SYNTH_BANK_API(bass, BassState)
+
+void flute_state_init(FluteState *state, float sample_rate, float frequency) {
     if (state == NULL) {
         return;
     }
     memset(state, 0, sizeof(*state));
+    osc_tables_init();
+    state->fund_inc = osc_phase_inc(frequency, sample_rate);
+    state->detune_inc = osc_phase_inc(frequency * 1.01f, sample_rate);
 }
 
-void flute_process(FluteState *state,
-                   const SynthBlockConfig *cfg,
-                   float frequency,
-                   float *out,
-                   size_t frames) {
-    if (state == NULL || cfg == NULL || out == NULL) {
-        return;
-    }
-    const float sample_rate = cfg->sample_rate;
-    const float detune = frequency * 1.01f;
+static void flute_render(FluteState *state,
+                         const SynthBlockConfig *cfg,
+                         SynthSink sink,
+                         size_t frames) {
+    (void)cfg;
     for (size_t i = 0; i < frames; ++i) {
-        state->phase_fund += 2.0f * (float)M_PI * frequency / sample_rate;
-        state->phase_detune += 2.0f * (float)M_PI * detune / sample_rate;
-        if (state->phase_fund > 2.0f * (float)M_PI) {
-            state->phase_fund -= 2.0f * (float)M_PI;
+        state->phase_fund += state->fund_inc;
+        state->phase_detune += state->detune_inc;
+        float fundamental = osc_sine(state->phase_fund);
+        float overtone = 0.3f * osc_sine(state->phase_detune * 2u);
+        float breath = frand() * 0.1f;
+        sink_put(sink, i, (fundamental + overtone + breath) * 0.6f);
+    }
+}
+
+SYNTH_PROCESS_API(flute, FluteState)
+
+static void flute_bank_render(FluteState *const *states,
+                              size_t count,
+                              const SynthBlockConfig *cfg,
+                              float *const *outs,
+                              const MixTarget *mixes,
+                              size_t frames) {
+    (void)cfg;
+    for (size_t g = 0; g < count; g += VOICE_BANK_WIDTH) {
+        const size_t lanes = count - g < VOICE_BANK_WIDTH ? count - g : VOICE_BANK_WIDTH;
+        uint32_t fund_phase[VOICE_BANK_WIDTH] = {0}, detune_phase[VOICE_BANK_WIDTH] = {0};
+        uint32_t fund_inc[VOICE_BANK_WIDTH] = {0}, detune_inc[VOICE_BANK_WIDTH] = {0};
+        for (size_t k = 0; k < lanes; ++k) {
+            const FluteState *st = states[g + k];
+            fund_phase[k] = st->phase_fund;
+            detune_phase[k] = st->phase_detune;
+            fund_inc[k] = st->fund_inc;
+            detune_inc[k] = st->detune_inc;
         }
-        if (state->phase_detune > 2.0f * (float)M_PI) {
-            state->phase_detune -= 2.0f * (float)M_PI;
+        for (size_t i = 0; i < frames; ++i) {
+            float breath[VOICE_BANK_WIDTH] = {0.0f};
+            for (size_t k = 0; k < lanes; ++k) {
+                breath[k] = frand() * 0.1f;
+            }
+            float y[VOICE_BANK_WIDTH];
+            for (size_t k = 0; k < VOICE_BANK_WIDTH; ++k) {
+                fund_phase[k] += fund_inc[k];
+                detune_phase[k] += detune_inc[k];
+                const float overtone = 0.3f * osc_sine(detune_phase[k] * 2u);
+                y[k] = (osc_sine(fund_phase[k]) + overtone + breath[k]) * 0.6f;
+            }
+            for (size_t k = 0; k < lanes; ++k) {
+                lane_put(outs, mixes, g + k, i, y[k]);
+            }
+        }
+        for (size_t k = 0; k < lanes; ++k) {
+            FluteState *st = states[g + k];
+            st->phase_fund = fund_phase[k];
+            st->phase_detune = detune_phase[k];
         }
-        float fundamental = sinf(state->phase_fund);
-        float overtone = 0.3f * sinf(state->phase_detune * 2.0f);
-        float breath = frand() * 0.1f;
-        out[i] = (fundamental + overtone + breath) * 0.6f;
     }
 }
 
-void piano_state_init(PianoState *state) {
+SYNTH_BANK_API(flute, FluteState)
+
+void piano_state_init(PianoState *state, float sample_rate, float base_frequency) {
     if (state == NULL) {
         return;
     }
-    memset(state, 0, sizeof(*state));
-    for (size_t i = 0; i < 4; ++i) {
-        state->overtone_envs[i] = 1.0f;
+    static const float ratios[4] = {1.0f, 2.0f, 3.01f, 4.2f};
+    static const float decays[4] = {0.6f, 0.4f, 0.2f, 0.15f};
+    partial_bank_init(&state->partials);
+    for (size_t h = 0; h < 4; ++h) {
+        partial_bank_add(&state->partials, base_frequency * ratios[h], sample_rate,
+                         1.0f / (float)(h + 1), decay_coeff(sample_rate, decays[h]));
     }
 }
 
-void piano_process(PianoState *state,
-                   const SynthBlockConfig *cfg,
-                   float base_frequency,
-                   float *out,
-                   size_t frames) {
-    if (state == NULL || cfg == NULL || out == NULL) {
-        return;
+static void piano_render(PianoState *state,
+                         const SynthBlockConfig *cfg,
+                         SynthSink sink,
+                         size_t frames) {
+    partial_bank_set_control_block(&state->partials, cfg->control_block);
+    partials_put(&state->partials, sink, frames);
+}
+
+SYNTH_PROCESS_API(piano, PianoState)
+
+#define KS_MAX_DELAY 65536u
+
+static float ks_period(float sample_rate, float frequency) {
+    if (frequency <= 0.0f) {
+        frequency = 110.0f;
     }
-    const float sample_rate = cfg->sample_rate;
-    const float ratios[4] = {1.0f, 2.0f, 3.01f, 4.2f};
-    const float decays[4] = {0.6f, 0.4f, 0.2f, 0.15f};
-    for (size_t i = 0; i < frames; ++i) {
-        float acc = 0.0f;
-        for (size_t h = 0; h < 4; ++h) {
-            const float freq = base_frequency * ratios[h];
-            state->phases[h] += 2.0f * (float)M_PI * freq / sample_rate;
-            if (state->phases[h] > 2.0f * (float)M_PI) {
-                state->phases[h] -= 2.0f * (float)M_PI;
-            }
-            acc += sinf(state->phases[h]) * state->overtone_envs[h] * (1.0f / (h + 1));
-            state->overtone_envs[h] *= expf(-1.0f / (sample_rate * decays[h]));
-        }
-        out[i] = acc;
+    return clampf(sample_rate / frequency, 2.0f, (float)(KS_MAX_DELAY - 2u));
+}
+
+size_t ks_delay_length(float sample_rate, float frequency) {
+    const size_t needed = (size_t)ks_period(sample_rate, frequency) + 2u;
+    size_t length = 2u;
+    while (length < needed) {
+        length <<= 1;
     }
+    return length;
 }
 
-void ks_state_init(KarplusStrongState *state, float damping, size_t delay_samples) {
+void ks_state_init(KarplusStrongState *state,
+                   float *delay_line,
+                   size_t line_length,
+                   float sample_rate,
+                   float frequency,
+                   float damping,
+                   uint32_t seed) {
     if (state == NULL) {
         return;
     }
     memset(state, 0, sizeof(*state));
     state->damping = damping;
-    const size_t size = sizeof(state->delay_line) / sizeof(state->delay_line[0]);
-    state->delay_index = delay_samples % size;
-    for (size_t i = 0; i < size; ++i) {
-        state->delay_line[i] = frand();
+    if (delay_line == NULL || line_length < 4u || (line_length & (line_length - 1u)) != 0u) {
+        return;
+    }
+    state->delay_line = delay_line;
+    state->mask = (uint32_t)(line_length - 1u);
+
+    /* loop delay = integer delay + 0.5 (two-point average) + allpass delay */
+    const float loop = ks_period(sample_rate, frequency) - 0.5f;
+    float whole = floorf(loop - 0.5f);
+    if (whole < 1.0f) {
+        whole = 1.0f;
+    }
+    if (whole > (float)(state->mask - 1u)) {
+        whole = (float)(state->mask - 1u);
+    }
+    const float frac = loop - whole;
+    state->delay = (uint32_t)whole;
+    state->allpass_coeff = (1.0f - frac) / (1.0f + frac);
+    for (size_t i = 0; i < line_length; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        state->delay_line[i] = (float)(seed >> 8) / 8388608.0f - 1.0f;
     }
 }
 
+static void ks_render(KarplusStrongState *state,
+                      float excitation_noise,
+                      SynthSink sink,
+                      size_t frames) {
+    if (state->delay_line == NULL) {
+        if (sink.mix == NULL) {
+            memset(sink.out, 0, frames * sizeof(float));
+        }
+        return;
+    }
+    float *line = state->delay_line;
+    const uint32_t mask = state->mask;
+    const uint32_t delay = state->delay;
+    const float coeff = state->allpass_coeff;
+    const float damping = state->damping * 0.5f;
+    uint32_t pos = state->write_pos;
+    float ap_in = state->allpass_in;
+    float ap_out = state->allpass_out;
+    for (size_t i = 0; i < frames; ++i) {
+        const float a = line[(pos - delay) & mask];
+        const float b = line[(pos - delay - 1u) & mask];
+        const float x = (a + b) * damping + excitation_noise * frand() * 0.01f;
+        ap_out = denormal_flush_feedback(coeff * (x - ap_out) + ap_in);
+        ap_in = x;
+        line[pos & mask] = ap_out;
+        sink_put(sink, i, ap_out);
+        ++pos;
+    }
+    state->write_pos = pos;
+    state->allpass_in = ap_in;
+    state->allpass_out = ap_out;
+}
+
 void ks_process(KarplusStrongState *state,
                 const SynthBlockConfig *cfg,
                 float excitation_noise,
@@ -481,188 +933,332 @@ void ks_process(KarplusStrongState *state,
     if (state == NULL || cfg == NULL || out == NULL) {
         return;
     }
-    const size_t size = sizeof(state->delay_line) / sizeof(state->delay_line[0]);
-    for (size_t i = 0; i < frames; ++i) {
-        float current = state->delay_line[state->delay_index];
-        float next = state->delay_line[(state->delay_index + 1) % size];
-        float value = 0.5f * (current + next) * state->damping + excitation_noise * frand() * 0.01f;
-        state->delay_line[state->delay_index] = value;
-        out[i] = value;
-        state->delay_index = (state->delay_index + 1) % size;
-    }
+    const SynthSink sink = {out, NULL};
+    ks_render(state, excitation_noise, sink, frames);
 }
 
-void egtr_state_init(EgtrState *state) {
-    if (state == NULL) {
+void ks_process_mix(KarplusStrongState *state,
+                    const SynthBlockConfig *cfg,
+                    float excitation_noise,
+                    const MixTarget *mix,
+                    size_t frames) {
+    if (state == NULL || cfg == NULL || mix == NULL) {
         return;
     }
-    memset(state, 0, sizeof(*state));
-    state->env = 1.0f;
+    const SynthSink sink = {NULL, mix};
+    ks_render(state, excitation_noise, sink, frames);
 }
 
-void egtr_process(EgtrState *state,
-                  const SynthBlockConfig *cfg,
-                  float frequency,
-                  float drive,
-                  float *out,
-                  size_t frames) {
-    if (state == NULL || cfg == NULL || out == NULL) {
-        return;
-    }
-    const float sample_rate = cfg->sample_rate;
-    const float decay = expf(-1.0f / (sample_rate * 0.5f));
-    for (size_t i = 0; i < frames; ++i) {
-        state->phase += 2.0f * (float)M_PI * frequency / sample_rate;
-        state->vibrato_phase += 2.0f * (float)M_PI * 5.5f / sample_rate;
-        if (state->phase > 2.0f * (float)M_PI) {
-            state->phase -= 2.0f * (float)M_PI;
+static void ks_bank_render(KarplusStrongState *const *states,
+                           size_t count,
+                           float excitation_noise,
+                           float *const *outs,
+                           const MixTarget *mixes,
+                           size_t frames) {
+    for (size_t g = 0; g < count; g += KS_BANK_WIDTH) {
+        const size_t lanes = count - g < KS_BANK_WIDTH ? count - g : KS_BANK_WIDTH;
+        /* idle lanes run on a private scratch line so the loop stays fixed-width */
+        float scratch[4] = {0.0f};
+        float *line[KS_BANK_WIDTH];
+        uint32_t mask[KS_BANK_WIDTH], delay[KS_BANK_WIDTH], pos[KS_BANK_WIDTH];
+        float coeff[KS_BANK_WIDTH], damping[KS_BANK_WIDTH];
+        float ap_in[KS_BANK_WIDTH], ap_out[KS_BANK_WIDTH];
+        for (size_t k = 0; k < KS_BANK_WIDTH; ++k) {
+            const KarplusStrongState *st = k < lanes ? states[g + k] : NULL;
+            if (st == NULL || st->delay_line == NULL) {
+                line[k] = scratch;
+                mask[k] = 3u;
+                delay[k] = 1u;
+                pos[k] = 0u;
+                coeff[k] = 0.0f;
+                damping[k] = 0.0f;
+                ap_in[k] = 0.0f;
+                ap_out[k] = 0.0f;
+                continue;
+            }
+            line[k] = st->delay_line;
+            mask[k] = st->mask;
+            delay[k] = st->delay;
+            pos[k] = st->write_pos;
+            coeff[k] = st->allpass_coeff;
+            damping[k] = st->damping * 0.5f;
+            ap_in[k] = st->allpass_in;
+            ap_out[k] = st->allpass_out;
         }
-        if (state->vibrato_phase > 2.0f * (float)M_PI) {
-            state->vibrato_phase -= 2.0f * (float)M_PI;
+
+        for (size_t i = 0; i < frames; ++i) {
+            float a[KS_BANK_WIDTH], b[KS_BANK_WIDTH], noise[KS_BANK_WIDTH] = {0.0f};
+            for (size_t k = 0; k < lanes; ++k) {
+                noise[k] = excitation_noise * frand() * 0.01f;
+            }
+            for (size_t k = 0; k < KS_BANK_WIDTH; ++k) {
+                a[k] = line[k][(pos[k] - delay[k]) & mask[k]];
+                b[k] = line[k][(pos[k] - delay[k] - 1u) & mask[k]];
+            }
+            for (size_t k = 0; k < KS_BANK_WIDTH; ++k) {
+                const float x = (a[k] + b[k]) * damping[k] + noise[k];
+                ap_out[k] = denormal_flush_feedback(coeff[k] * (x - ap_out[k]) + ap_in[k]);
+                ap_in[k] = x;
+            }
+            for (size_t k = 0; k < KS_BANK_WIDTH; ++k) {
+                line[k][pos[k] & mask[k]] = ap_out[k];
+                ++pos[k];
+            }
+            for (size_t k = 0; k < lanes; ++k) {
+                if (line[k] != scratch) {
+                    lane_put(outs, mixes, g + k, i, ap_out[k]);
+                }
+            }
+        }
+
+        for (size_t k = 0; k < lanes; ++k) {
+            KarplusStrongState *st = states[g + k];
+            if (st == NULL || st->delay_line == NULL) {
+                if (outs != NULL) {
+                    memset(outs[g + k], 0, frames * sizeof(float));
+                }
+                continue;
+            }
+            st->write_pos = pos[k];
+            st->allpass_in = ap_in[k];
+            st->allpass_out = ap_out[k];
         }
-        float saw = fmodf(state->phase / (2.0f * (float)M_PI), 1.0f) * 2.0f - 1.0f;
-        float square = saw >= 0.0f ? 1.0f : -1.0f;
-        float vibrato = 0.01f * sinf(state->vibrato_phase);
-        float signal = (0.6f * saw + 0.4f * square) + vibrato + frand() * 0.02f;
-        float distorted = tanhf(signal * drive);
-        out[i] = distorted * state->env;
-        state->env *= decay;
     }
 }
 
-void birds_state_init(BirdsState *state) {
-    if (state == NULL) {
+void ks_bank_process(KarplusStrongState *const *states,
+                     size_t count,
+                     const SynthBlockConfig *cfg,
+                     float excitation_noise,
+                     float *const *outs,
+                     size_t frames) {
+    if (states == NULL || cfg == NULL || outs == NULL) {
         return;
     }
-    memset(state, 0, sizeof(*state));
-    state->env = 1.0f;
+    ks_bank_render(states, count, excitation_noise, outs, NULL, frames);
 }
 
-void birds_process(BirdsState *state,
-                   const SynthBlockConfig *cfg,
-                   float *out,
-                   size_t frames) {
-    if (state == NULL || cfg == NULL || out == NULL) {
+void ks_bank_process_mix(KarplusStrongState *const *states,
+                         size_t count,
+                         const SynthBlockConfig *cfg,
+                         float excitation_noise,
+                         const MixTarget *mixes,
+                         size_t frames) {
+    if (states == NULL || cfg == NULL || mixes == NULL) {
         return;
     }
-    const float sample_rate = cfg->sample_rate;
-    const float decay = expf(-1.0f / (sample_rate * 0.3f));
-    for (size_t i = 0; i < frames; ++i) {
-        state->chirp_phase += 2.0f * (float)M_PI * (4000.0f + 2000.0f * frand()) / sample_rate;
-        if (state->chirp_phase > 2.0f * (float)M_PI) {
-            state->chirp_phase -= 2.0f * (float)M_PI;
-        }
-        float chirp = sinf(state->chirp_phase) * (0.5f + 0.5f * frand());
-        float noise = frand() * 0.4f;
-        out[i] = (chirp + noise) * state->env;
-        state->env *= decay;
-    }
+    ks_bank_render(states, count, excitation_noise, NULL, mixes, frames);
 }
 
-void strpad_state_init(StrPadState *state) {
+void egtr_state_init(EgtrState *state, float sample_rate, float frequency, float drive) {
     if (state == NULL) {
         return;
     }
     memset(state, 0, sizeof(*state));
+    osc_tables_init();
+    state->env = 1.0f;
+    state->decay = decay_coeff(sample_rate, 0.5f);
+    state->inc = osc_phase_inc(frequency, sample_rate);
+    state->vibrato_inc = osc_phase_inc(5.5f, sample_rate);
+    state->drive = drive;
 }
 
-void strpad_process(StrPadState *state,
-                    const SynthBlockConfig *cfg,
-                    float base_frequency,
-                    float *out,
-                    size_t frames) {
-    if (state == NULL || cfg == NULL || out == NULL) {
-        return;
-    }
-    const float sample_rate = cfg->sample_rate;
-    const float attack = expf(-1.0f / (sample_rate * 1.5f));
-    const float release = expf(-1.0f / (sample_rate * 3.0f));
-    for (size_t i = 0; i < frames; ++i) {
-        float blend = (state->env < 1.0f) ? (1.0f - state->env) : (state->env - 1.0f);
-        state->env = state->env < 1.0f ? 1.0f - (1.0f - state->env) * attack : state->env * release;
-        float acc = 0.0f;
-        for (size_t p = 0; p < 3; ++p) {
-            float freq = base_frequency * (1.0f + 0.01f * p);
-            state->phases[p] += 2.0f * (float)M_PI * freq / sample_rate;
-            if (state->phases[p] > 2.0f * (float)M_PI) {
-                state->phases[p] -= 2.0f * (float)M_PI;
-            }
-            acc += sinf(state->phases[p]) * (1.0f / (p + 1));
+static void egtr_render(EgtrState *state,
+                        const SynthBlockConfig *cfg,
+                        SynthSink sink,
+                        size_t frames) {
+    const size_t block = control_block_size(cfg->control_block);
+    const float block_decay = powf(state->decay, (float)block);
+    for (size_t i = 0; i < frames;) {
+        const size_t n = control_span(block, frames - i);
+        const float env_end = state->env * decay_over(state->decay, block_decay, n, block);
+        const float env_step = control_ramp_step(state->env, env_end, n);
+        float env = state->env;
+        for (size_t k = 0; k < n; ++k, ++i) {
+            state->phase += state->inc;
+            state->vibrato_phase += state->vibrato_inc;
+            float saw = osc_saw(state->phase);
+            float square = saw >= 0.0f ? 1.0f : -1.0f;
+            float vibrato = 0.01f * osc_sine(state->vibrato_phase);
+            float signal = (0.6f * saw + 0.4f * square) + vibrato + frand() * 0.02f;
+            float distorted = dsp_tanhf(signal * state->drive);
+            sink_put(sink, i, distorted * env);
+            env += env_step;
         }
-        out[i] = acc * 0.5f * (0.6f + 0.4f * blend);
+        state->env = env_end;
     }
+    state->env = denormal_flush(state->env);
 }
 
-void bell_state_init(BellState *state) {
+SYNTH_PROCESS_API(egtr, EgtrState)
+
+void birds_state_init(BirdsState *state, float sample_rate) {
     if (state == NULL) {
         return;
     }
     memset(state, 0, sizeof(*state));
+    osc_tables_init();
     state->env = 1.0f;
+    state->decay = decay_coeff(sample_rate, 0.3f);
+    /* chirp frequency wanders randomly in 4000 +/- 2000 Hz */
+    state->chirp_base = 4000.0f * osc_inc_scale(sample_rate);
+    state->chirp_spread = 2000.0f * osc_inc_scale(sample_rate);
 }
 
-void bell_process(BellState *state,
-                  const SynthBlockConfig *cfg,
-                  float base_frequency,
-                  float *out,
-                  size_t frames) {
-    if (state == NULL || cfg == NULL || out == NULL) {
+static void birds_render(BirdsState *state,
+                         const SynthBlockConfig *cfg,
+                         SynthSink sink,
+                         size_t frames) {
+    const size_t block = control_block_size(cfg->control_block);
+    const float block_decay = powf(state->decay, (float)block);
+    for (size_t i = 0; i < frames;) {
+        const size_t n = control_span(block, frames - i);
+        const float env_end = state->env * decay_over(state->decay, block_decay, n, block);
+        const float env_step = control_ramp_step(state->env, env_end, n);
+        float env = state->env;
+        for (size_t k = 0; k < n; ++k, ++i) {
+            state->chirp_phase +=
+                osc_scaled_inc(state->chirp_base + state->chirp_spread * frand());
+            float chirp = osc_sine(state->chirp_phase) * (0.5f + 0.5f * frand());
+            float noise = frand() * 0.4f;
+            sink_put(sink, i, (chirp + noise) * env);
+            env += env_step;
+        }
+        state->env = env_end;
+    }
+    state->env = denormal_flush(state->env);
+}
+
+SYNTH_PROCESS_API(birds, BirdsState)
+
+void strpad_state_init(StrPadState *state, float sample_rate, float base_frequency) {
+    if (state == NULL) {
         return;
     }
-    const float sample_rate = cfg->sample_rate;
-    const float ratios[4] = {1.0f, 2.4f, 3.95f, 5.4f};
-    const float decays[4] = {2.0f, 1.2f, 0.8f, 0.6f};
-    for (size_t i = 0; i < frames; ++i) {
-        float acc = 0.0f;
-        for (size_t h = 0; h < 4; ++h) {
-            const float freq = base_frequency * ratios[h];
-            state->phases[h] += 2.0f * (float)M_PI * freq / sample_rate;
-            if (state->phases[h] > 2.0f * (float)M_PI) {
-                state->phases[h] -= 2.0f * (float)M_PI;
+    partial_bank_init(&state->partials);
+    for (size_t p = 0; p < 3; ++p) {
+        partial_bank_add(&state->partials, base_frequency * (1.0f + 0.01f * (float)p),
+                         sample_rate, 0.5f / (float)(p + 1), 1.0f);
+    }
+    state->env = 0.0f;
+    state->attack = decay_coeff(sample_rate, 1.5f);
+    state->release = decay_coeff(sample_rate, 3.0f);
+}
+
+static void strpad_render(StrPadState *state,
+                          const SynthBlockConfig *cfg,
+                          SynthSink sink,
+                          size_t frames) {
+    const size_t block = control_block_size(cfg->control_block);
+    const float block_attack = powf(state->attack, (float)block);
+    const float block_release = powf(state->release, (float)block);
+    float chunk[SYNTH_MIX_CHUNK];
+    for (size_t base = 0; base < frames;) {
+        const size_t n = sink_chunk_frames(sink, frames - base);
+        float *buf = sink.mix != NULL ? chunk : sink.out;
+        partial_bank_process(&state->partials, buf, n);
+        for (size_t i = 0; i < n;) {
+            const size_t span = control_span(block, n - i);
+            const float env = state->env;
+            const float env_end =
+                env < 1.0f
+                    ? 1.0f - (1.0f - env) * decay_over(state->attack, block_attack, span, block)
+                    : env * decay_over(state->release, block_release, span, block);
+            const float blend = env < 1.0f ? 1.0f - env : env - 1.0f;
+            const float blend_end = env_end < 1.0f ? 1.0f - env_end : env_end - 1.0f;
+            float gain = 0.6f + 0.4f * blend;
+            const float gain_step = control_ramp_step(gain, 0.6f + 0.4f * blend_end, span);
+            for (size_t k = 0; k < span; ++k, ++i) {
+                sink_put(sink, base + i, buf[i] * gain);
+                gain += gain_step;
             }
-            acc += sinf(state->phases[h]) * expf(- (float)i / (sample_rate * decays[h]));
+            state->env = env_end;
         }
-        out[i] = acc * 0.5f;
+        base += n;
     }
 }
 
-void brass_state_init(BrassState *state) {
+SYNTH_PROCESS_API(strpad, StrPadState)
+
+void bell_state_init(BellState *state, float sample_rate, float base_frequency) {
     if (state == NULL) {
         return;
     }
-    memset(state, 0, sizeof(*state));
-    state->env = 0.0f;
+    static const float ratios[4] = {1.0f, 2.4f, 3.95f, 5.4f};
+    static const float decays[4] = {2.0f, 1.2f, 0.8f, 0.6f};
+    partial_bank_init(&state->partials);
+    for (size_t h = 0; h < 4; ++h) {
+        partial_bank_add(&state->partials, base_frequency * ratios[h], sample_rate,
+                         0.5f, decay_coeff(sample_rate, decays[h]));
+    }
 }
 
-void brass_process(BrassState *state,
-                   const SynthBlockConfig *cfg,
-                   float frequency,
-                   float *out,
-                   size_t frames) {
-    if (state == NULL || cfg == NULL || out == NULL) {
+static void bell_render(BellState *state,
+                        const SynthBlockConfig *cfg,
+                        SynthSink sink,
+                        size_t frames) {
+    partial_bank_set_control_block(&state->partials, cfg->control_block);
+    partials_put(&state->partials, sink, frames);
+}
+
+SYNTH_PROCESS_API(bell, BellState)
+
+void brass_state_init(BrassState *state, float sample_rate, float frequency) {
+    if (state == NULL) {
         return;
     }
-    const float sample_rate = cfg->sample_rate;
-    const float attack = 1.0f / (sample_rate * 0.2f);
-    const float release = expf(-1.0f / (sample_rate * 0.8f));
-    for (size_t i = 0; i < frames; ++i) {
-        state->phase += 2.0f * (float)M_PI * frequency / sample_rate;
-        if (state->phase > 2.0f * (float)M_PI) {
-            state->phase -= 2.0f * (float)M_PI;
+    memset(state, 0, sizeof(*state));
+    osc_tables_init();
+    state->env = 0.0f;
+    state->inc = osc_phase_inc(frequency, sample_rate);
+    state->attack = 1.0f / (sample_rate * 0.2f);
+    state->release = decay_coeff(sample_rate, 0.8f);
+    biquad_init(&state->lip_filter, soft_lowpass);
+}
+
+static void brass_render(BrassState *state,
+                         const SynthBlockConfig *cfg,
+                         SynthSink sink,
+                         size_t frames) {
+    const size_t block = control_block_size(cfg->control_block);
+    const float block_release = powf(state->release, (float)block);
+    /*
+     * Per sample env = min(1, env + attack) * release. Below the clamp that
+     * is an affine recurrence with a closed form, and once the clamp engages
+     * it holds env at release, so each block end is one evaluation.
+     */
+    const float rise = state->attack * state->release / (1.0f - state->release);
+    for (size_t i = 0; i < frames;) {
+        const size_t n = control_span(block, frames - i);
+        const float keep = decay_over(state->release, block_release, n, block);
+        const float env_end =
+            fminf(state->release, state->env * keep + rise * (1.0f - keep));
+        float gain = fminf(1.0f, state->env + state->attack);
+        const float gain_step =
+            control_ramp_step(gain, fminf(1.0f, env_end + state->attack), n);
+        for (size_t k = 0; k < n; ++k, ++i) {
+            state->phase += state->inc;
+            float saw = osc_saw(state->phase);
+            const float lip = biquad_tick(&state->lip_filter, saw);
+            sink_put(sink, i, dsp_tanhf(lip * 2.0f) * gain);
+            gain += gain_step;
         }
-        float saw = fmodf(state->phase / (2.0f * (float)M_PI), 1.0f) * 2.0f - 1.0f;
-        state->lip_filter = 0.9f * state->lip_filter + 0.1f * saw;
-        state->env = fminf(1.0f, state->env + attack);
-        out[i] = tanhf(state->lip_filter * 2.0f) * state->env;
-        state->env *= release;
+        state->env = env_end;
     }
 }
 
-void kalimba_state_init(KalimbaState *state, size_t delay_samples) {
+SYNTH_PROCESS_API(brass, BrassState)
+
+void kalimba_state_init(KalimbaState *state,
+                        float *delay_line,
+                        size_t line_length,
+                        float sample_rate,
+                        float frequency,
+                        uint32_t seed) {
     if (state == NULL) {
         return;
     }
-    ks_state_init(&state->ks, 0.98f, delay_samples);
+    ks_state_init(&state->ks, delay_line, line_length, sample_rate, frequency, 0.98f, seed);
 }
 
 void kalimba_process(KalimbaState *state,
@@ -675,3 +1271,266 @@ void kalimba_process(KalimbaState *state,
     }
     ks_process(&state->ks, cfg, excitation, out, frames);
 }
+
+void kalimba_process_mix(KalimbaState *state,
+                         const SynthBlockConfig *cfg,
+                         float excitation,
+                         const MixTarget *mix,
+                         size_t frames) {
+    if (state == NULL || cfg == NULL || mix == NULL) {
+        return;
+    }
+    ks_process_mix(&state->ks, cfg, excitation, mix, frames);
+}
+
+/* FM ---------------------------------------------------------------------- */
+typedef struct {
+    float ratio[FM_OPERATORS];
+    float level[FM_OPERATORS];   /* carriers: amplitude; modulators: index in cycles */
+    float sustain[FM_OPERATORS]; /* fraction of level the envelope settles at */
+    float decay_s[FM_OPERATORS];
+    float carrier[FM_OPERATORS];
+    float route[FM_ROUTES];
+    float feedback;
+} FmPatchDef;
+
+static const FmPatchDef fm_patches[FM_PATCH_COUNT] = {
+    /* e-piano: two 2-op stacks, a soft 1:1 body and a short 14:1 tine bark */
+    {
+        .ratio = {1.0f, 1.0f, 1.0f, 14.0f},
+        .level = {0.55f, 0.2f, 0.35f, 0.12f},
+        .sustain = {0.0f, 0.1f, 0.0f, 0.0f},
+        .decay_s = {1.6f, 0.5f, 0.9f, 0.06f},
+        .carrier = {1.0f, 0.0f, 1.0f, 0.0f},
+        .route = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f},
+        .feedback = 0.0f,
+    },
+    /* metallic bass: 3 -> 2 -> 0 stack with feedback over a sub-octave sine */
+    {
+        .ratio = {1.0f, 0.5f, 1.0f, 3.0f},
+        .level = {0.6f, 0.3f, 0.45f, 0.25f},
+        .sustain = {0.5f, 0.6f, 0.15f, 0.05f},
+        .decay_s = {0.8f, 1.0f, 0.25f, 0.12f},
+        .carrier = {1.0f, 1.0f, 0.0f, 0.0f},
+        .route = {0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f},
+        .feedback = 0.15f,
+    },
+};
+
+void fm_state_init(FmState *state, float sample_rate, float frequency, int patch) {
+    if (state == NULL) {
+        return;
+    }
+    memset(state, 0, sizeof(*state));
+    osc_tables_init();
+    const FmPatchDef *def = &fm_patches[patch >= 0 && patch < FM_PATCH_COUNT ? patch : 0];
+    for (size_t k = 0; k < FM_OPERATORS; ++k) {
+        state->inc[k] = osc_phase_inc(frequency * def->ratio[k], sample_rate);
+        state->level[k] = def->level[k];
+        state->sustain[k] = def->level[k] * def->sustain[k];
+        state->decay[k] = decay_coeff(sample_rate, def->decay_s[k]);
+        state->carrier[k] = def->carrier[k];
+    }
+    for (size_t r = 0; r < FM_ROUTES; ++r) {
+        state->route[r] = def->route[r];
+    }
+    state->feedback = def->feedback;
+}
+
+/* Phase offset for a modulation in cycles; |cycles| < 128, wraps like the phase. */
+static inline uint32_t fm_offset(float cycles) {
+    return (uint32_t)(int32_t)(cycles * 16777216.0f) << 8;
+}
+
+static void fm_render(FmState *state,
+                      const SynthBlockConfig *cfg,
+                      SynthSink sink,
+                      size_t frames) {
+    (void)cfg;
+    const float *r = state->route;
+    for (size_t i = 0; i < frames; ++i) {
+        for (size_t k = 0; k < FM_OPERATORS; ++k) {
+            state->phase[k] += state->inc[k];
+        }
+        const float y3 = osc_sine(state->phase[3] + fm_offset(state->feedback * state->last)) *
+                         state->level[3];
+        const float y2 = osc_sine(state->phase[2] + fm_offset(r[5] * y3)) * state->level[2];
+        const float y1 = osc_sine(state->phase[1] + fm_offset(r[3] * y2 + r[4] * y3)) *
+                         state->level[1];
+        const float y0 = osc_sine(state->phase[0] + fm_offset(r[0] * y1 + r[1] * y2 + r[2] * y3)) *
+                         state->level[0];
+        state->last = y3;
+        for (size_t k = 0; k < FM_OPERATORS; ++k) {
+            state->level[k] = state->sustain[k] + (state->level[k] - state->sustain[k]) *
+                                                      state->decay[k];
+        }
+        sink_put(sink, i,
+                 state->carrier[0] * y0 + state->carrier[1] * y1 + state->carrier[2] * y2 +
+                     state->carrier[3] * y3);
+    }
+    for (size_t k = 0; k < FM_OPERATORS; ++k) {
+        state->level[k] = denormal_flush(state->level[k]);
+    }
+    state->last = denormal_flush(state->last);
+}
+
+SYNTH_PROCESS_API(fm, FmState)
+
+/* Bank lanes render into a frame-major stack block before each lane is stored or mixed. */
+#define FM_BANK_CHUNK 64u
+
+CPU_INLINE void fm_bank_body(FmState *const *states,
+                             size_t count,
+                             float *const *outs,
+                             const MixTarget *mixes,
+                             size_t frames) {
+    for (size_t g = 0; g < count; g += VOICE_BANK_WIDTH) {
+        const size_t lanes = count - g < VOICE_BANK_WIDTH ? count - g : VOICE_BANK_WIDTH;
+        /* operator-major lanes: slot [k][v] is operator k of voice v */
+        uint32_t phase[FM_OPERATORS][VOICE_BANK_WIDTH] = {{0}};
+        uint32_t inc[FM_OPERATORS][VOICE_BANK_WIDTH] = {{0}};
+        float level[FM_OPERATORS][VOICE_BANK_WIDTH] = {{0.0f}};
+        float sustain[FM_OPERATORS][VOICE_BANK_WIDTH] = {{0.0f}};
+        float decay[FM_OPERATORS][VOICE_BANK_WIDTH] = {{0.0f}};
+        float carrier[FM_OPERATORS][VOICE_BANK_WIDTH] = {{0.0f}};
+        float route[FM_ROUTES][VOICE_BANK_WIDTH] = {{0.0f}};
+        float feedback[VOICE_BANK_WIDTH] = {0.0f};
+        float last[VOICE_BANK_WIDTH] = {0.0f};
+        for (size_t v = 0; v < lanes; ++v) {
+            const FmState *st = states[g + v];
+            for (size_t k = 0; k < FM_OPERATORS; ++k) {
+                phase[k][v] = st->phase[k];
+                inc[k][v] = st->inc[k];
+                level[k][v] = st->level[k];
+                sustain[k][v] = st->sustain[k];
+                decay[k][v] = st->decay[k];
+                carrier[k][v] = st->carrier[k];
+            }
+            for (size_t r = 0; r < FM_ROUTES; ++r) {
+                route[r][v] = st->route[r];
+            }
+            feedback[v] = st->feedback;
+            last[v] = st->last;
+        }
+        for (size_t base = 0; base < frames; base += FM_BANK_CHUNK) {
+            const size_t n = frames - base < FM_BANK_CHUNK ? frames - base : FM_BANK_CHUNK;
+            float block[FM_BANK_CHUNK][VOICE_BANK_WIDTH];
+            for (size_t i = 0; i < n; ++i) {
+                /* one operator across all lanes at a time, top of the stack first */
+                float y[FM_OPERATORS][VOICE_BANK_WIDTH];
+                for (size_t v = 0; v < VOICE_BANK_WIDTH; ++v) {
+                    phase[3][v] += inc[3][v];
+                    y[3][v] = osc_sine(phase[3][v] + fm_offset(feedback[v] * last[v])) *
+                              level[3][v];
+                }
+                for (size_t v = 0; v < VOICE_BANK_WIDTH; ++v) {
+                    phase[2][v] += inc[2][v];
+                    y[2][v] = osc_sine(phase[2][v] + fm_offset(route[5][v] * y[3][v])) *
+                              level[2][v];
+                }
+                for (size_t v = 0; v < VOICE_BANK_WIDTH; ++v) {
+                    phase[1][v] += inc[1][v];
+                    y[1][v] = osc_sine(phase[1][v] + fm_offset(route[3][v] * y[2][v] +
+                                                               route[4][v] * y[3][v])) *
+                              level[1][v];
+                }
+                for (size_t v = 0; v < VOICE_BANK_WIDTH; ++v) {
+                    phase[0][v] += inc[0][v];
+                    y[0][v] = osc_sine(phase[0][v] +
+                                       fm_offset(route[0][v] * y[1][v] + route[1][v] * y[2][v] +
+                                                 route[2][v] * y[3][v])) *
+                              level[0][v];
+                }
+                for (size_t v = 0; v < VOICE_BANK_WIDTH; ++v) {
+                    last[v] = y[3][v];
+                    block[i][v] = carrier[0][v] * y[0][v] + carrier[1][v] * y[1][v] +
+                                  carrier[2][v] * y[2][v] + carrier[3][v] * y[3][v];
+                }
+                for (size_t k = 0; k < FM_OPERATORS; ++k) {
+                    for (size_t v = 0; v < VOICE_BANK_WIDTH; ++v) {
+                        level[k][v] = sustain[k][v] + (level[k][v] - sustain[k][v]) * decay[k][v];
+                    }
+                }
+            }
+            for (size_t v = 0; v < lanes; ++v) {
+                float column[FM_BANK_CHUNK];
+                for (size_t i = 0; i < n; ++i) {
+                    column[i] = block[i][v];
+                }
+                if (mixes != NULL) {
+                    const MixTarget part = mix_target_advance(&mixes[g + v], base);
+                    mix_accumulate_target(&part, column, n);
+                } else {
+                    memcpy(outs[g + v] + base, column, n * sizeof(float));
+                }
+            }
+        }
+        for (size_t v = 0; v < lanes; ++v) {
+            FmState *st = states[g + v];
+            for (size_t k = 0; k < FM_OPERATORS; ++k) {
+                st->phase[k] = phase[k][v];
+                st->level[k] = denormal_flush(level[k][v]);
+            }
+            st->last = denormal_flush(last[v]);
+        }
+    }
+}
+
+typedef void (*FmBankFn)(FmState *const *, size_t, float *const *, const MixTarget *, size_t);
+
+static void fm_bank_baseline(FmState *const *states,
+                             size_t count,
+                             float *const *outs,
+                             const MixTarget *mixes,
+                             size_t frames) {
+    fm_bank_body(states, count, outs, mixes, frames);
+}
+
+#if CPU_MULTIVERSION
+CPU_TARGET_AVX2 static void fm_bank_avx2(FmState *const *states,
+                                         size_t count,
+                                         float *const *outs,
+                                         const MixTarget *mixes,
+                                         size_t frames) {
+    fm_bank_body(states, count, outs, mixes, frames);
+}
+
+CPU_TARGET_AVX512 static void fm_bank_avx512(FmState *const *states,
+                                             size_t count,
+                                             float *const *outs,
+                                             const MixTarget *mixes,
+                                             size_t frames) {
+    fm_bank_body(states, count, outs, mixes, frames);
+}
+#endif
+
+static FmBankFn fm_bank_selected = fm_bank_baseline;
+static pthread_once_t fm_bank_once = PTHREAD_ONCE_INIT;
+
+static void fm_bank_resolve(void) {
+    switch (cpu_dispatch_level()) {
+#if CPU_MULTIVERSION
+        case CPU_LEVEL_AVX512:
+            fm_bank_selected = fm_bank_avx512;
+            break;
+        case CPU_LEVEL_AVX2:
+            fm_bank_selected = fm_bank_avx2;
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+static void fm_bank_render(FmState *const *states,
+                           size_t count,
+                           const SynthBlockConfig *cfg,
+                           float *const *outs,
+                           const MixTarget *mixes,
+                           size_t frames) {
+    (void)cfg;
+    pthread_once(&fm_bank_once, fm_bank_resolve);
+    fm_bank_selected(states, count, outs, mixes, frames);
+}
+
+SYNTH_BANK_API(fm, FmState)
@@ -9,6 +9,7 @@
 #include <string.h>
 #include <unistd.h>
 
+#include "bake.h"
 #include "sequence.h"
 #include "midi_loader.h"
 #include "scheduler.h"
@@ -48,7 +49,14 @@ static void usage(const char *prog) {
             "  -sr <rate>       Sample rate (default 44100)\n"
             "  -g <gain>        Output gain 0..1 (default 0.3)\n"
             "  -l <ms>          Default duration per token (default 120)\n"
-            "  -fade <ms>       Fade in/out per tone (default 8)\n"
+            "  -fade <ms>       Fade in/out of the whole mix (default 8)\n"
+            "  -cr <samples>    Samples per glide/sweep/envelope update (default 32)\n"
+            "  -rq <quality>    Sample resampling: sinc or linear (default sinc)\n"
+            "  -bake <list>     Play choir,strpad,bell,egtr (or all) from baked tables\n"
+            "  -hpf <hz>        High-pass the output buses (default off)\n"
+            "  -lpf <hz>        Low-pass the output buses (default off)\n"
+            "  -governor <load> Step quality down when rendering takes more than load\n"
+            "                   seconds per second of audio (default off)\n"
             "  -f <file>        Sequence file (.srave/.aox)\n"
             "  -espeak <path>   espeak binary for SAY events\n",
             prog, prog);
@@ -59,6 +67,7 @@ int main(int argc, char **argv) {
         .sample_rate = 44100,
         .default_duration_ms = 120,
         .fade_ms = 8,
+        .control_block = 32,
     };
     float gain = 0.3f;
     const char *seq_file = NULL;
@@ -107,6 +116,57 @@ int main(int argc, char **argv) {
             idx += 2;
             continue;
         }
+        if (strcmp(argv[idx], "-cr") == 0 && idx + 1 < argc) {
+            int tmp = 0;
+            if (!parse_int(argv[idx + 1], &tmp) || tmp <= 0) {
+                fprintf(stderr, "invalid control block: %s\n", argv[idx + 1]);
+                return 1;
+            }
+            opts.control_block = tmp;
+            idx += 2;
+            continue;
+        }
+        if (strcmp(argv[idx], "-rq") == 0 && idx + 1 < argc) {
+            if (!resampler_parse_quality(argv[idx + 1], &opts.resample_quality)) {
+                fprintf(stderr, "invalid resampler quality: %s\n", argv[idx + 1]);
+                return 1;
+            }
+            idx += 2;
+            continue;
+        }
+        if (strcmp(argv[idx], "-bake") == 0 && idx + 1 < argc) {
+            if (!bake_parse_list(argv[idx + 1], &opts.bake_mask)) {
+                fprintf(stderr, "invalid bake list: %s\n", argv[idx + 1]);
+                return 1;
+            }
+            idx += 2;
+            continue;
+        }
+        if ((strcmp(argv[idx], "-hpf") == 0 || strcmp(argv[idx], "-lpf") == 0) &&
+            idx + 1 < argc) {
+            float tmp = 0.f;
+            if (!parse_float(argv[idx + 1], &tmp) || tmp <= 0.f) {
+                fprintf(stderr, "invalid cutoff: %s\n", argv[idx + 1]);
+                return 1;
+            }
+            if (argv[idx][1] == 'h') {
+                opts.bus_highpass_hz = tmp;
+            } else {
+                opts.bus_lowpass_hz = tmp;
+            }
+            idx += 2;
+            continue;
+        }
+        if (strcmp(argv[idx], "-governor") == 0 && idx + 1 < argc) {
+            float tmp = 0.f;
+            if (!parse_float(argv[idx + 1], &tmp) || tmp <= 0.f) {
+                fprintf(stderr, "invalid governor load: %s\n", argv[idx + 1]);
+                return 1;
+            }
+            opts.governor_budget = tmp;
+            idx += 2;
+            continue;
+        }
         if (strcmp(argv[idx], "-f") == 0 && idx + 1 < argc) {
             seq_file = argv[idx + 1];
             idx += 2;
@@ -156,5 +216,6 @@ int main(int argc, char **argv) {
 
     sequence_document_free(&doc);
     sample_cache_clear();
+    bake_tables_clear();
     return rc;
 }
@@ -51,11 +51,11 @@ static float note_to_hz(int note) {
 
 static const char *program_to_token(uint8_t program) {
     static const char *table[] = {
-        "PIANO","PIANO","PIANO","PIANO","PIANO","PIANO","PIANO","PIANO",
+        "PIANO","PIANO","PIANO","PIANO","EPIANO","EPIANO","PIANO","PIANO",
         "GUITAR","GUITAR","GUITAR","GUITAR","EGTR","EGTR","EGTR","EGTR",
         "BASS","BASS","SIDBASS","SIDBASS","FLUTE","FLUTE","FLUTE","FLUTE",
         "STRPAD","STRPAD","CHOIR","CHOIR","BRASS","BRASS","BRASS","BRASS",
-        "LASER","ANALOGLEAD","CHIPARP","CHIPARP"
+        "LASER","ANALOGLEAD","CHIPARP","CHIPARP","PIANO","PIANO","FMBASS","FMBASS"
     };
     if (program < sizeof(table)/sizeof(table[0])) {
         return table[program];
@@ -2,6 +2,8 @@
 
 #include "midi_loader.h"
 
+#include "fm_patch.h"
+
 #include <math.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -17,6 +19,7 @@ typedef struct {
     double duration_ms;
     float freq;
     SeqSpecType spec_type;
+    int patch;
     float pan;
 } MidiNoteEvent;
 
@@ -82,7 +85,7 @@ static float midi_note_to_hz(int note) {
 static SeqSpecType program_to_spec(uint8_t program) {
     static const SeqSpecType table[] = {
         SEQ_SPEC_PIANO, SEQ_SPEC_PIANO, SEQ_SPEC_PIANO, SEQ_SPEC_PIANO,
-        SEQ_SPEC_PIANO, SEQ_SPEC_PIANO, SEQ_SPEC_PIANO, SEQ_SPEC_PIANO,
+        SEQ_SPEC_FM, SEQ_SPEC_FM, SEQ_SPEC_PIANO, SEQ_SPEC_PIANO,
         SEQ_SPEC_GUITAR, SEQ_SPEC_GUITAR, SEQ_SPEC_GUITAR, SEQ_SPEC_GUITAR,
         SEQ_SPEC_EGTR, SEQ_SPEC_EGTR, SEQ_SPEC_EGTR, SEQ_SPEC_EGTR,
         SEQ_SPEC_BASS, SEQ_SPEC_BASS, SEQ_SPEC_BASS, SEQ_SPEC_BASS,
@@ -90,6 +93,7 @@ static SeqSpecType program_to_spec(uint8_t program) {
         SEQ_SPEC_STRPAD, SEQ_SPEC_STRPAD, SEQ_SPEC_STRPAD, SEQ_SPEC_CHOIR,
         SEQ_SPEC_BRASS, SEQ_SPEC_BRASS, SEQ_SPEC_BRASS, SEQ_SPEC_ANALOGLEAD,
         SEQ_SPEC_LASER, SEQ_SPEC_ANALOGLEAD, SEQ_SPEC_CHIPARP, SEQ_SPEC_CHIPARP,
+        SEQ_SPEC_PIANO, SEQ_SPEC_PIANO, SEQ_SPEC_FM, SEQ_SPEC_FM,
     };
     if (program < sizeof(table) / sizeof(table[0])) {
         return table[program];
@@ -97,6 +101,11 @@ static SeqSpecType program_to_spec(uint8_t program) {
     return SEQ_SPEC_PIANO;
 }
 
+/* Electric pianos 1/2 play the FM e-piano, synth basses 1/2 the FM bass. */
+static int program_to_patch(uint8_t program) {
+    return program == 38 || program == 39 ? FM_PATCH_BASS : FM_PATCH_EPIANO;
+}
+
 static void note_vec_push(MidiNoteVec *vec, MidiNoteEvent ev) {
     if (vec->len == vec->cap) {
         size_t n = vec->cap ? vec->cap * 2 : 128;
@@ -110,6 +119,7 @@ typedef struct {
     int active;
     double start_ms;
     SeqSpecType spec;
+    int patch;
     float freq;
     float pan;
 } ActiveNote;
@@ -206,6 +216,7 @@ static void convert_track(FILE *mid,
                     .duration_ms = dur_ms,
                     .freq = slot->freq,
                     .spec_type = slot->spec,
+                    .patch = slot->patch,
                     .pan = slot->pan,
                 };
                 note_vec_push(notes, ev);
@@ -218,6 +229,7 @@ static void convert_track(FILE *mid,
             slot->start_ms = current_ms;
             slot->freq = midi_note_to_hz(data1);
             slot->spec = program_to_spec(program_per_channel[channel]);
+            slot->patch = program_to_patch(program_per_channel[channel]);
             slot->pan = default_pan_for_channel(channel);
         } else if ((type == 0x90 && data2 == 0) || type == 0x80) {
             ActiveNote *slot = &active[channel][data1];
@@ -231,6 +243,7 @@ static void convert_track(FILE *mid,
                     .duration_ms = dur_ms,
                     .freq = slot->freq,
                     .spec_type = slot->spec,
+                    .patch = slot->patch,
                     .pan = slot->pan,
                 };
                 note_vec_push(notes, ev);
@@ -258,6 +271,7 @@ static void convert_track(FILE *mid,
                     .duration_ms = dur_ms,
                     .freq = slot->freq,
                     .spec_type = slot->spec,
+                    .patch = slot->patch,
                     .pan = slot->pan,
                 };
                 note_vec_push(notes, ev);
@@ -344,6 +358,7 @@ bool sequence_load_midi(const char *path,
         dst->left.f_const = src->freq;
         dst->left.f0 = src->freq;
         dst->left.f1 = src->freq;
+        dst->left.patch = src->patch;
         dst->right = dst->left;
         dst->stereo = true;
         dst->pan = src->pan;
@@ -0,0 +1,269 @@
+#include "mix_kernels.h"
+
+#include "cpu_dispatch.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#if CPU_MULTIVERSION
+#include <immintrin.h>
+#endif
+
+/* Adding and subtracting 1.5 * 2^23 rounds to nearest-even like lrintf. */
+#define ROUND_MAGIC 12582912.0f
+
+CPU_INLINE void accumulate_body(float *restrict dst, const float *restrict src, size_t n) {
+    const size_t body = n & ~(size_t)(CPU_VECTOR_BLOCK - 1u);
+    for (size_t i = 0; i < body; ++i) {
+        dst[i] += src[i];
+    }
+    for (size_t i = body; i < n; ++i) {
+        dst[i] += src[i];
+    }
+}
+
+CPU_INLINE void accumulate_pan_body(float *restrict left,
+                                    float *restrict right,
+                                    const float *restrict src,
+                                    float gain_l,
+                                    float gain_r,
+                                    size_t n) {
+    const size_t body = n & ~(size_t)(CPU_VECTOR_BLOCK - 1u);
+    for (size_t i = 0; i < body; ++i) {
+        left[i] += src[i] * gain_l;
+        right[i] += src[i] * gain_r;
+    }
+    for (size_t i = body; i < n; ++i) {
+        left[i] += src[i] * gain_l;
+        right[i] += src[i] * gain_r;
+    }
+}
+
+/* The ramp position is converted from a 32-bit int so the loops vectorize. */
+CPU_INLINE void accumulate_ramp_body(float *restrict dst,
+                                     const float *restrict src,
+                                     float gain,
+                                     float step,
+                                     size_t n) {
+    const size_t body = n & ~(size_t)(CPU_VECTOR_BLOCK - 1u);
+    for (size_t i = 0; i < body; ++i) {
+        dst[i] += src[i] * (gain + step * (float)(int32_t)i);
+    }
+    for (size_t i = body; i < n; ++i) {
+        dst[i] += src[i] * (gain + step * (float)(int32_t)i);
+    }
+}
+
+CPU_INLINE void accumulate_ramp2_body(float *restrict left,
+                                      float *restrict right,
+                                      const float *restrict src,
+                                      const float *gain,
+                                      const float *step,
+                                      size_t n) {
+    const float gl = gain[0], gr = gain[1];
+    const float sl = step[0], sr = step[1];
+    const size_t body = n & ~(size_t)(CPU_VECTOR_BLOCK - 1u);
+    for (size_t i = 0; i < body; ++i) {
+        const float x = (float)(int32_t)i;
+        left[i] += src[i] * (gl + sl * x);
+        right[i] += src[i] * (gr + sr * x);
+    }
+    for (size_t i = body; i < n; ++i) {
+        const float x = (float)(int32_t)i;
+        left[i] += src[i] * (gl + sl * x);
+        right[i] += src[i] * (gr + sr * x);
+    }
+}
+
+CPU_INLINE void accumulate_target_body(const MixTarget *t, const float *src, size_t n) {
+    if (t->bus[1] == NULL) {
+        accumulate_ramp_body(t->bus[0], src, t->gain[0], t->step[0], n);
+    } else {
+        accumulate_ramp2_body(t->bus[0], t->bus[1], src, t->gain, t->step, n);
+    }
+}
+
+CPU_INLINE int16_t to_s16(float v, float gain) {
+    v *= gain;
+    v = v > 1.f ? 1.f : v;
+    v = v < -1.f ? -1.f : v;
+    v = v * 32767.f + ROUND_MAGIC - ROUND_MAGIC;
+    return (int16_t)(int32_t)v;
+}
+
+static void interleave_s16_baseline(int16_t *restrict dst,
+                                   const float *restrict left,
+                                   const float *restrict right,
+                                   size_t n,
+                                   float gain) {
+    for (size_t i = 0; i < n; ++i) {
+        dst[2 * i] = to_s16(left[i], gain);
+        dst[2 * i + 1] = to_s16(right[i], gain);
+    }
+}
+
+#if CPU_MULTIVERSION
+/*
+ * Eight frames per step with the same operations as to_s16(). unpack plus
+ * packs leaves the samples in L/R order because both work within 128-bit
+ * halves.
+ */
+CPU_TARGET_AVX2 static void interleave_s16_avx2(int16_t *dst,
+                                                const float *left,
+                                                const float *right,
+                                                size_t n,
+                                                float gain) {
+    const __m256 g = _mm256_set1_ps(gain);
+    const __m256 hi = _mm256_set1_ps(1.f);
+    const __m256 lo = _mm256_set1_ps(-1.f);
+    const __m256 scale = _mm256_set1_ps(32767.f);
+    const __m256 magic = _mm256_set1_ps(ROUND_MAGIC);
+    const size_t body = n & ~(size_t)7u;
+    for (size_t i = 0; i < body; i += 8u) {
+        __m256 l = _mm256_mul_ps(_mm256_loadu_ps(left + i), g);
+        __m256 r = _mm256_mul_ps(_mm256_loadu_ps(right + i), g);
+        l = _mm256_max_ps(lo, _mm256_min_ps(hi, l));
+        r = _mm256_max_ps(lo, _mm256_min_ps(hi, r));
+        l = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(l, scale), magic), magic);
+        r = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(r, scale), magic), magic);
+        const __m256i li = _mm256_cvttps_epi32(l);
+        const __m256i ri = _mm256_cvttps_epi32(r);
+        const __m256i out = _mm256_packs_epi32(_mm256_unpacklo_epi32(li, ri),
+                                               _mm256_unpackhi_epi32(li, ri));
+        _mm256_storeu_si256((__m256i *)(dst + 2 * i), out);
+    }
+    for (size_t i = body; i < n; ++i) {
+        dst[2 * i] = to_s16(left[i], gain);
+        dst[2 * i + 1] = to_s16(right[i], gain);
+    }
+}
+#endif
+
+typedef struct {
+    void (*accumulate)(float *, const float *, size_t);
+    void (*accumulate_pan)(float *, float *, const float *, float, float, size_t);
+    void (*accumulate_target)(const MixTarget *, const float *, size_t);
+    void (*interleave_s16)(int16_t *, const float *, const float *, size_t, float);
+} MixKernels;
+
+#define DEFINE_MIX_KERNELS(suffix, attr, interleave)                                  \
+    attr static void accumulate_##suffix(float *dst, const float *src, size_t n) {    \
+        accumulate_body(dst, src, n);                                                  \
+    }                                                                                  \
+    attr static void accumulate_pan_##suffix(float *left, float *right,               \
+                                             const float *src, float gain_l,          \
+                                             float gain_r, size_t n) {                \
+        accumulate_pan_body(left, right, src, gain_l, gain_r, n);                      \
+    }                                                                                  \
+    attr static void accumulate_target_##suffix(const MixTarget *t, const float *src, \
+                                                size_t n) {                           \
+        accumulate_target_body(t, src, n);                                             \
+    }                                                                                  \
+    static const MixKernels mix_kernels_##suffix = {                                  \
+        accumulate_##suffix, accumulate_pan_##suffix, accumulate_target_##suffix,     \
+        interleave,                                                                    \
+    };
+
+DEFINE_MIX_KERNELS(baseline, , interleave_s16_baseline)
+#if CPU_MULTIVERSION
+/* The interleave is hand-written once; AVX-512 hosts share the AVX2 one. */
+DEFINE_MIX_KERNELS(avx2, CPU_TARGET_AVX2, interleave_s16_avx2)
+DEFINE_MIX_KERNELS(avx512, CPU_TARGET_AVX512, interleave_s16_avx2)
+#endif
+
+static const MixKernels *mix_kernels_selected = &mix_kernels_baseline;
+static pthread_once_t mix_kernels_once = PTHREAD_ONCE_INIT;
+
+static void mix_kernels_resolve(void) {
+    switch (cpu_dispatch_level()) {
+#if CPU_MULTIVERSION
+        case CPU_LEVEL_AVX512:
+            mix_kernels_selected = &mix_kernels_avx512;
+            break;
+        case CPU_LEVEL_AVX2:
+            mix_kernels_selected = &mix_kernels_avx2;
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+static const MixKernels *mix_kernels(void) {
+    pthread_once(&mix_kernels_once, mix_kernels_resolve);
+    return mix_kernels_selected;
+}
+
+void mix_accumulate(float *dst, const float *src, size_t n) {
+    mix_kernels()->accumulate(dst, src, n);
+}
+
+void mix_accumulate_pan(float *left,
+                        float *right,
+                        const float *src,
+                        float gain_l,
+                        float gain_r,
+                        size_t n) {
+    mix_kernels()->accumulate_pan(left, right, src, gain_l, gain_r, n);
+}
+
+void mix_accumulate_target(const MixTarget *t, const float *src, size_t n) {
+    if (t == NULL || src == NULL) {
+        return;
+    }
+    mix_kernels()->accumulate_target(t, src, n);
+}
+
+MixTarget mix_target_mono(float *bus, float gain) {
+    MixTarget t = {{bus, NULL}, {gain, 0.0f}, {0.0f, 0.0f}};
+    return t;
+}
+
+MixTarget mix_target_stereo(float *left, float *right, const float gains[2]) {
+    if (gains[1] == 0.0f) {
+        return mix_target_mono(left, gains[0]);
+    }
+    if (gains[0] == 0.0f) {
+        return mix_target_mono(right, gains[1]);
+    }
+    MixTarget t = {{left, right}, {gains[0], gains[1]}, {0.0f, 0.0f}};
+    return t;
+}
+
+MixTarget mix_target_advance(const MixTarget *t, size_t frames) {
+    MixTarget next = *t;
+    const float x = (float)frames;
+    for (int c = 0; c < 2; ++c) {
+        if (next.bus[c] != NULL) {
+            next.bus[c] += frames;
+        }
+        next.gain[c] += next.step[c] * x;
+    }
+    return next;
+}
+
+void mix_pan_gains(float gain, float pan, float gains[2]) {
+    pan = pan < -1.0f ? -1.0f : (pan > 1.0f ? 1.0f : pan);
+    gains[0] = gain * (pan > 0.0f ? 1.0f - pan : 1.0f);
+    gains[1] = gain * (pan < 0.0f ? 1.0f + pan : 1.0f);
+}
+
+void mix_interleave_s16(int16_t *dst,
+                        const float *left,
+                        const float *right,
+                        size_t n,
+                        float gain) {
+    mix_kernels()->interleave_s16(dst, left, right, n, gain);
+}
+
+void mix_interleave_q15(int16_t *dst,
+                        const int32_t *left,
+                        const int32_t *right,
+                        size_t n,
+                        int32_t gain) {
+    for (size_t i = 0; i < n; ++i) {
+        const int64_t l = ((int64_t)left[i] * gain) >> 15;
+        const int64_t r = ((int64_t)right[i] * gain) >> 15;
+        dst[2 * i] = (int16_t)(l > 32767 ? 32767 : (l < -32768 ? -32768 : l));
+        dst[2 * i + 1] = (int16_t)(r > 32767 ? 32767 : (r < -32768 ? -32768 : r));
+    }
+}
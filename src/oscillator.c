@@ -0,0 +1,199 @@
+#include "oscillator.h"
+
+#include "cpu_dispatch.h"
+#include "fixed_point.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#if CPU_MULTIVERSION
+#include <immintrin.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+float osc_sine_table[OSC_TABLE_SIZE + 1];
+int16_t osc_sine_table_q15[OSC_TABLE_SIZE + 1];
+
+static bool tables_ready = false;
+
+void osc_tables_init(void) {
+    if (tables_ready) {
+        return;
+    }
+    for (uint32_t i = 0; i <= OSC_TABLE_SIZE; ++i) {
+        const double s = sin(2.0 * M_PI * (double)i / (double)OSC_TABLE_SIZE);
+        osc_sine_table[i] = (float)s;
+        osc_sine_table_q15[i] = (int16_t)lrint(s * Q15_ONE);
+    }
+    tables_ready = true;
+}
+
+/* Phase of sample i is computed directly, so the loop carries no dependency. */
+CPU_INLINE void sine_bank_body(uint32_t *phases,
+                               const uint32_t *incs,
+                               float *const *outs,
+                               size_t count,
+                               size_t frames) {
+    for (size_t v = 0; v < count; ++v) {
+        float *restrict out = outs[v];
+        const uint32_t start = phases[v];
+        const uint32_t inc = incs[v];
+        for (size_t i = 0; i < frames; ++i) {
+            out[i] = osc_sine(start + (uint32_t)(i + 1u) * inc);
+        }
+        phases[v] = start + (uint32_t)frames * inc;
+    }
+}
+
+CPU_INLINE void sine_mix_body(uint32_t *phases,
+                              const uint32_t *incs,
+                              const MixTarget *mixes,
+                              size_t count,
+                              size_t frames) {
+    for (size_t v = 0; v < count; ++v) {
+        const MixTarget *t = &mixes[v];
+        const uint32_t start = phases[v];
+        const uint32_t inc = incs[v];
+        for (size_t i = 0; i < frames; ++i) {
+            mix_target_add(t, i, osc_sine(start + (uint32_t)(i + 1u) * inc));
+        }
+        phases[v] = start + (uint32_t)frames * inc;
+    }
+}
+
+typedef void (*SineBankFn)(uint32_t *, const uint32_t *, float *const *, size_t, size_t);
+typedef void (*SineMixFn)(uint32_t *, const uint32_t *, const MixTarget *, size_t, size_t);
+
+static void sine_bank_baseline(uint32_t *phases,
+                               const uint32_t *incs,
+                               float *const *outs,
+                               size_t count,
+                               size_t frames) {
+    sine_bank_body(phases, incs, outs, count, frames);
+}
+
+static void sine_mix_baseline(uint32_t *phases,
+                              const uint32_t *incs,
+                              const MixTarget *mixes,
+                              size_t count,
+                              size_t frames) {
+    sine_mix_body(phases, incs, mixes, count, frames);
+}
+
+#if CPU_MULTIVERSION
+/*
+ * osc_sine() for eight consecutive phases, with the two table points
+ * gathered. The interpolation keeps the scalar operation order (no FMA),
+ * so this level renders bit-identically to the baseline.
+ */
+CPU_TARGET_AVX2 static inline __m256 sine8_avx2(__m256i phase) {
+    const __m256i idx = _mm256_srli_epi32(phase, OSC_FRAC_BITS);
+    const __m256i bits = _mm256_and_si256(phase, _mm256_set1_epi32((1 << OSC_FRAC_BITS) - 1));
+    const __m256 frac = _mm256_mul_ps(_mm256_cvtepi32_ps(bits),
+                                      _mm256_set1_ps(1.0f / (float)(1u << OSC_FRAC_BITS)));
+    const __m256 a = _mm256_i32gather_ps(osc_sine_table, idx, 4);
+    const __m256 b = _mm256_i32gather_ps(osc_sine_table + 1, idx, 4);
+    return _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), frac));
+}
+
+/* Phases of samples 0..7 of a call; the caller steps them by 8 * inc. */
+CPU_TARGET_AVX2 static inline __m256i phase8_avx2(uint32_t start, uint32_t inc) {
+    const __m256i lane = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 8);
+    return _mm256_add_epi32(_mm256_set1_epi32((int32_t)start),
+                            _mm256_mullo_epi32(lane, _mm256_set1_epi32((int32_t)inc)));
+}
+
+CPU_TARGET_AVX2 static void sine_bank_avx2(uint32_t *phases,
+                                           const uint32_t *incs,
+                                           float *const *outs,
+                                           size_t count,
+                                           size_t frames) {
+    const size_t body = frames & ~(size_t)7u;
+    for (size_t v = 0; v < count; ++v) {
+        float *out = outs[v];
+        const uint32_t start = phases[v];
+        const uint32_t inc = incs[v];
+        const __m256i step = _mm256_set1_epi32((int32_t)(inc * 8u));
+        __m256i phase = phase8_avx2(start, inc);
+        for (size_t i = 0; i < body; i += 8u) {
+            _mm256_storeu_ps(out + i, sine8_avx2(phase));
+            phase = _mm256_add_epi32(phase, step);
+        }
+        for (size_t i = body; i < frames; ++i) {
+            out[i] = osc_sine(start + (uint32_t)(i + 1u) * inc);
+        }
+        phases[v] = start + (uint32_t)frames * inc;
+    }
+}
+
+CPU_TARGET_AVX2 static void sine_mix_avx2(uint32_t *phases,
+                                          const uint32_t *incs,
+                                          const MixTarget *mixes,
+                                          size_t count,
+                                          size_t frames) {
+    const size_t body = frames & ~(size_t)7u;
+    for (size_t v = 0; v < count; ++v) {
+        const MixTarget *t = &mixes[v];
+        float *left = t->bus[0];
+        float *right = t->bus[1];
+        const uint32_t start = phases[v];
+        const uint32_t inc = incs[v];
+        const __m256i step = _mm256_set1_epi32((int32_t)(inc * 8u));
+        const __m256 gl = _mm256_set1_ps(t->gain[0]), sl = _mm256_set1_ps(t->step[0]);
+        const __m256 gr = _mm256_set1_ps(t->gain[1]), sr = _mm256_set1_ps(t->step[1]);
+        __m256i phase = phase8_avx2(start, inc);
+        __m256i pos = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        for (size_t i = 0; i < body; i += 8u) {
+            const __m256 y = sine8_avx2(phase);
+            const __m256 x = _mm256_cvtepi32_ps(pos);
+            const __m256 l = _mm256_mul_ps(y, _mm256_add_ps(gl, _mm256_mul_ps(sl, x)));
+            _mm256_storeu_ps(left + i, _mm256_add_ps(_mm256_loadu_ps(left + i), l));
+            if (right != NULL) {
+                const __m256 r = _mm256_mul_ps(y, _mm256_add_ps(gr, _mm256_mul_ps(sr, x)));
+                _mm256_storeu_ps(right + i, _mm256_add_ps(_mm256_loadu_ps(right + i), r));
+            }
+            phase = _mm256_add_epi32(phase, step);
+            pos = _mm256_add_epi32(pos, _mm256_set1_epi32(8));
+        }
+        for (size_t i = body; i < frames; ++i) {
+            mix_target_add(t, i, osc_sine(start + (uint32_t)(i + 1u) * inc));
+        }
+        phases[v] = start + (uint32_t)frames * inc;
+    }
+}
+#endif
+
+/* AVX-512 hosts run the AVX2 kernels; the gathers gain nothing from zmm here. */
+static SineBankFn sine_bank_impl = sine_bank_baseline;
+static SineMixFn sine_mix_impl = sine_mix_baseline;
+static pthread_once_t sine_kernels_once = PTHREAD_ONCE_INIT;
+
+static void sine_kernels_resolve(void) {
+#if CPU_MULTIVERSION
+    if (cpu_dispatch_level() >= CPU_LEVEL_AVX2) {
+        sine_bank_impl = sine_bank_avx2;
+        sine_mix_impl = sine_mix_avx2;
+    }
+#endif
+}
+
+void osc_sine_bank(uint32_t *phases,
+                   const uint32_t *incs,
+                   float *const *outs,
+                   size_t count,
+                   size_t frames) {
+    pthread_once(&sine_kernels_once, sine_kernels_resolve);
+    sine_bank_impl(phases, incs, outs, count, frames);
+}
+
+void osc_sine_bank_mix(uint32_t *phases,
+                       const uint32_t *incs,
+                       const MixTarget *mixes,
+                       size_t count,
+                       size_t frames) {
+    pthread_once(&sine_kernels_once, sine_kernels_resolve);
+    sine_mix_impl(phases, incs, mixes, count, frames);
+}
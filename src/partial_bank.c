@@ -0,0 +1,575 @@
+#include "partial_bank.h"
+
+#include "control_rate.h"
+#include "cpu_dispatch.h"
+#include "denormal.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <string.h>
+#if CPU_MULTIVERSION
+#include <immintrin.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static size_t lane_count(size_t count) {
+    return (count + PARTIAL_BANK_WIDTH - 1u) & ~(size_t)(PARTIAL_BANK_WIDTH - 1u);
+}
+
+void partial_bank_init(PartialBank *bank) {
+    if (bank == NULL) {
+        return;
+    }
+    memset(bank, 0, sizeof(*bank));
+    for (size_t p = 0; p < PARTIAL_BANK_MAX; ++p) {
+        bank->re[p] = 1.0f;
+        bank->rot_re[p] = 1.0f;
+        bank->decay[p] = 1.0f;
+        bank->block_decay[p] = 1.0f;
+    }
+    bank->control_block = CONTROL_BLOCK_DEFAULT;
+}
+
+int partial_bank_add(PartialBank *bank,
+                     float frequency,
+                     float sample_rate,
+                     float amplitude,
+                     float decay) {
+    if (bank == NULL || bank->count >= PARTIAL_BANK_MAX || sample_rate <= 0.0f) {
+        return 0;
+    }
+    const size_t p = bank->count++;
+    const double w = 2.0 * M_PI * (double)frequency / (double)sample_rate;
+    bank->re[p] = 1.0f;
+    bank->im[p] = 0.0f;
+    bank->rot_re[p] = (float)cos(w);
+    bank->rot_im[p] = (float)sin(w);
+    bank->amp[p] = amplitude;
+    bank->decay[p] = decay;
+    bank->block_decay[p] = powf(decay, (float)bank->control_block);
+    return 1;
+}
+
+void partial_bank_set_control_block(PartialBank *bank, size_t block) {
+    if (bank == NULL) {
+        return;
+    }
+    block = control_block_size(block);
+    if (block == bank->control_block) {
+        return;
+    }
+    bank->control_block = block;
+    for (size_t p = 0; p < bank->count; ++p) {
+        bank->block_decay[p] = powf(bank->decay[p], (float)block);
+    }
+}
+
+void partial_bank_truncate(PartialBank *bank, size_t keep) {
+    if (bank == NULL || keep >= bank->count) {
+        return;
+    }
+    for (size_t p = keep; p < bank->count; ++p) {
+        bank->amp[p] = 0.0f;
+    }
+    bank->count = keep;
+}
+
+/*
+ * Per-sample steps that take the first `lanes` lanes to their decayed amplitude at
+ * the end of the next n frames; lanes that do not decay get a zero step.
+ */
+static void ramp_slopes(float *slope,
+                        const float *amp,
+                        const float *decay,
+                        const float *block_decay,
+                        size_t block,
+                        size_t n,
+                        size_t lanes) {
+    for (size_t p = 0; p < lanes; ++p) {
+        const float keep = n == block ? block_decay[p] : powf(decay[p], (float)n);
+        slope[p] = (amp[p] * keep - amp[p]) / (float)n;
+    }
+}
+
+/* Kernel bodies store into out, or add through mix when it is set. */
+CPU_INLINE void bank_put(float *out, const MixTarget *mix, size_t i, float v) {
+    if (mix != NULL) {
+        mix_target_add(mix, i, v);
+    } else {
+        out[i] = v;
+    }
+}
+
+CPU_INLINE void process_body(PartialBank *bank,
+                             float *out,
+                             const MixTarget *mix,
+                             size_t frames) {
+    const size_t lanes = lane_count(bank->count);
+    if (lanes == 0u) {
+        if (out != NULL) {
+            memset(out, 0, frames * sizeof(float));
+        }
+        return;
+    }
+
+    /* Work on local copies so the compiler can keep lanes in vector registers. */
+    float re[PARTIAL_BANK_MAX], im[PARTIAL_BANK_MAX];
+    float cr[PARTIAL_BANK_MAX], ci[PARTIAL_BANK_MAX];
+    float amp[PARTIAL_BANK_MAX], slope[PARTIAL_BANK_MAX];
+    memcpy(re, bank->re, lanes * sizeof(float));
+    memcpy(im, bank->im, lanes * sizeof(float));
+    memcpy(cr, bank->rot_re, lanes * sizeof(float));
+    memcpy(ci, bank->rot_im, lanes * sizeof(float));
+    memcpy(amp, bank->amp, lanes * sizeof(float));
+
+    for (size_t i = 0; i < frames;) {
+        const size_t n = control_span(bank->control_block, frames - i);
+        ramp_slopes(slope, amp, bank->decay, bank->block_decay, bank->control_block, n,
+                    lanes);
+        for (size_t j = 0; j < n; ++j, ++i) {
+            float acc[PARTIAL_BANK_WIDTH] = {0.0f};
+            for (size_t g = 0; g < lanes; g += PARTIAL_BANK_WIDTH) {
+                for (size_t k = 0; k < PARTIAL_BANK_WIDTH; ++k) {
+                    const size_t p = g + k;
+                    const float r = re[p] * cr[p] - im[p] * ci[p];
+                    const float s = re[p] * ci[p] + im[p] * cr[p];
+                    re[p] = r;
+                    im[p] = s;
+                    acc[k] += amp[p] * s;
+                    amp[p] += slope[p];
+                }
+            }
+            float sum = 0.0f;
+            for (size_t k = 0; k < PARTIAL_BANK_WIDTH; ++k) {
+                sum += acc[k];
+            }
+            bank_put(out, mix, i, sum);
+        }
+    }
+
+    /* One Newton step pulls the phasors back onto the unit circle. */
+    for (size_t p = 0; p < lanes; ++p) {
+        const float g = 1.5f - 0.5f * (re[p] * re[p] + im[p] * im[p]);
+        re[p] *= g;
+        im[p] *= g;
+        amp[p] = denormal_flush(amp[p]);
+    }
+    memcpy(bank->re, re, lanes * sizeof(float));
+    memcpy(bank->im, im, lanes * sizeof(float));
+    memcpy(bank->amp, amp, lanes * sizeof(float));
+}
+
+/* outs[v] or mixes[v] receives bank v; exactly one of the two is set. */
+CPU_INLINE void process_multi_body(PartialBank *const *banks,
+                                   size_t count,
+                                   float *const *outs,
+                                   const MixTarget *mixes,
+                                   size_t frames) {
+    size_t v = 0;
+    while (v < count) {
+        /* Pack as many whole banks as fit into one set of lanes. */
+        float re[PARTIAL_BANK_MAX], im[PARTIAL_BANK_MAX];
+        float cr[PARTIAL_BANK_MAX], ci[PARTIAL_BANK_MAX];
+        float amp[PARTIAL_BANK_MAX], slope[PARTIAL_BANK_MAX];
+        float decay[PARTIAL_BANK_MAX], block_decay[PARTIAL_BANK_MAX];
+        size_t packed[PARTIAL_BANK_MAX / PARTIAL_BANK_WIDTH];
+        size_t first_group[PARTIAL_BANK_MAX / PARTIAL_BANK_WIDTH + 1u];
+        size_t packed_count = 0;
+        size_t lanes = 0;
+        size_t block = 0;
+        while (v < count) {
+            PartialBank *bank = banks[v];
+            const size_t need = bank ? lane_count(bank->count) : 0u;
+            if (need == 0u) {
+                if (outs != NULL) {
+                    memset(outs[v], 0, frames * sizeof(float));
+                }
+                ++v;
+                continue;
+            }
+            /* Packed banks share their control spans. */
+            if (lanes + need > PARTIAL_BANK_MAX || (lanes > 0u && bank->control_block != block)) {
+                break;
+            }
+            block = bank->control_block;
+            memcpy(re + lanes, bank->re, need * sizeof(float));
+            memcpy(im + lanes, bank->im, need * sizeof(float));
+            memcpy(cr + lanes, bank->rot_re, need * sizeof(float));
+            memcpy(ci + lanes, bank->rot_im, need * sizeof(float));
+            memcpy(amp + lanes, bank->amp, need * sizeof(float));
+            memcpy(decay + lanes, bank->decay, need * sizeof(float));
+            memcpy(block_decay + lanes, bank->block_decay, need * sizeof(float));
+            first_group[packed_count] = lanes / PARTIAL_BANK_WIDTH;
+            packed[packed_count++] = v;
+            lanes += need;
+            ++v;
+        }
+        if (lanes == 0u) {
+            continue;
+        }
+        first_group[packed_count] = lanes / PARTIAL_BANK_WIDTH;
+
+        for (size_t i = 0; i < frames;) {
+            const size_t n = control_span(block, frames - i);
+            ramp_slopes(slope, amp, decay, block_decay, block, n, lanes);
+            for (size_t j = 0; j < n; ++j, ++i) {
+                float group_sum[PARTIAL_BANK_MAX / PARTIAL_BANK_WIDTH];
+                for (size_t g = 0; g < lanes; g += PARTIAL_BANK_WIDTH) {
+                    float sum = 0.0f;
+                    for (size_t k = 0; k < PARTIAL_BANK_WIDTH; ++k) {
+                        const size_t p = g + k;
+                        const float r = re[p] * cr[p] - im[p] * ci[p];
+                        const float s = re[p] * ci[p] + im[p] * cr[p];
+                        re[p] = r;
+                        im[p] = s;
+                        sum += amp[p] * s;
+                        amp[p] += slope[p];
+                    }
+                    group_sum[g / PARTIAL_BANK_WIDTH] = sum;
+                }
+                for (size_t b = 0; b < packed_count; ++b) {
+                    float y = group_sum[first_group[b]];
+                    for (size_t g = first_group[b] + 1u; g < first_group[b + 1u]; ++g) {
+                        y += group_sum[g];
+                    }
+                    const size_t dst = packed[b];
+                    bank_put(mixes ? NULL : outs[dst], mixes ? &mixes[dst] : NULL, i, y);
+                }
+            }
+        }
+
+        size_t offset = 0;
+        for (size_t b = 0; b < packed_count; ++b) {
+            PartialBank *bank = banks[packed[b]];
+            const size_t need = lane_count(bank->count);
+            for (size_t p = offset; p < offset + need; ++p) {
+                const float g = 1.5f - 0.5f * (re[p] * re[p] + im[p] * im[p]);
+                re[p] *= g;
+                im[p] *= g;
+                amp[p] = denormal_flush(amp[p]);
+            }
+            memcpy(bank->re, re + offset, need * sizeof(float));
+            memcpy(bank->im, im + offset, need * sizeof(float));
+            memcpy(bank->amp, amp + offset, need * sizeof(float));
+            offset += need;
+        }
+    }
+}
+
+#if CPU_MULTIVERSION
+/*
+ * AVX2 keeps all PARTIAL_BANK_MAX lanes in two ymm registers per field and
+ * skips the upper pair when eight lanes suffice. Lanes past the packed ones
+ * are set up silent (unit phasor, zero amplitude), which only adds zeros
+ * to the sums. Products, sums and their order match the scalar body.
+ */
+typedef struct {
+    __m256 re[2], im[2], cr[2], ci[2], amp[2], slope[2];
+    int pairs;
+} PartialLanesAvx2;
+
+CPU_TARGET_AVX2 static inline void lanes_load_avx2(PartialLanesAvx2 *l,
+                                                   float *re,
+                                                   float *im,
+                                                   float *cr,
+                                                   float *ci,
+                                                   float *amp,
+                                                   float *slope,
+                                                   size_t lanes) {
+    for (size_t p = lanes; p < PARTIAL_BANK_MAX; ++p) {
+        re[p] = 1.0f;
+        im[p] = 0.0f;
+        cr[p] = 1.0f;
+        ci[p] = 0.0f;
+        amp[p] = 0.0f;
+        slope[p] = 0.0f;
+    }
+    l->pairs = lanes > 8u ? 2 : 1;
+    for (int h = 0; h < 2; ++h) {
+        l->re[h] = _mm256_loadu_ps(re + 8 * h);
+        l->im[h] = _mm256_loadu_ps(im + 8 * h);
+        l->cr[h] = _mm256_loadu_ps(cr + 8 * h);
+        l->ci[h] = _mm256_loadu_ps(ci + 8 * h);
+        l->amp[h] = _mm256_loadu_ps(amp + 8 * h);
+    }
+}
+
+/* Spills the amplitudes, derives the next span's steps and loads them. */
+CPU_TARGET_AVX2 static inline void lanes_ramp_avx2(PartialLanesAvx2 *l,
+                                                   float *amp,
+                                                   float *slope,
+                                                   const float *decay,
+                                                   const float *block_decay,
+                                                   size_t block,
+                                                   size_t n,
+                                                   size_t lanes) {
+    for (int h = 0; h < 2; ++h) {
+        _mm256_storeu_ps(amp + 8 * h, l->amp[h]);
+    }
+    ramp_slopes(slope, amp, decay, block_decay, block, n, lanes);
+    for (int h = 0; h < 2; ++h) {
+        l->slope[h] = _mm256_loadu_ps(slope + 8 * h);
+    }
+}
+
+CPU_TARGET_AVX2 static inline void lanes_store_avx2(const PartialLanesAvx2 *l,
+                                                    float *re,
+                                                    float *im,
+                                                    float *amp) {
+    for (int h = 0; h < 2; ++h) {
+        _mm256_storeu_ps(re + 8 * h, l->re[h]);
+        _mm256_storeu_ps(im + 8 * h, l->im[h]);
+        _mm256_storeu_ps(amp + 8 * h, l->amp[h]);
+    }
+}
+
+/* Advances eight lanes by one sample and returns amp * sin for each. */
+CPU_TARGET_AVX2 static inline __m256 lanes_step_avx2(PartialLanesAvx2 *l, int h) {
+    const __m256 r = _mm256_sub_ps(_mm256_mul_ps(l->re[h], l->cr[h]),
+                                   _mm256_mul_ps(l->im[h], l->ci[h]));
+    const __m256 s = _mm256_add_ps(_mm256_mul_ps(l->re[h], l->ci[h]),
+                                   _mm256_mul_ps(l->im[h], l->cr[h]));
+    l->re[h] = r;
+    l->im[h] = s;
+    const __m256 t = _mm256_mul_ps(l->amp[h], s);
+    l->amp[h] = _mm256_add_ps(l->amp[h], l->slope[h]);
+    return t;
+}
+
+/* ((x0 + x1) + x2) + x3, the scalar summation order. */
+CPU_TARGET_AVX2 static inline float hsum4_avx2(__m128 x) {
+    __m128 sum = _mm_add_ss(x, _mm_shuffle_ps(x, x, 1));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(x, x, 2));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(x, x, 3));
+    return _mm_cvtss_f32(sum);
+}
+
+CPU_TARGET_AVX2 static inline void renormalize_lanes(float *re, float *im, float *amp,
+                                                     size_t from, size_t to) {
+    for (size_t p = from; p < to; ++p) {
+        const float g = 1.5f - 0.5f * (re[p] * re[p] + im[p] * im[p]);
+        re[p] *= g;
+        im[p] *= g;
+        amp[p] = denormal_flush(amp[p]);
+    }
+}
+
+CPU_TARGET_AVX2 CPU_INLINE void process_body_avx2(PartialBank *bank,
+                                                  float *out,
+                                                  const MixTarget *mix,
+                                                  size_t frames) {
+    const size_t lanes = lane_count(bank->count);
+    if (lanes == 0u) {
+        if (out != NULL) {
+            memset(out, 0, frames * sizeof(float));
+        }
+        return;
+    }
+    float re[PARTIAL_BANK_MAX], im[PARTIAL_BANK_MAX];
+    float cr[PARTIAL_BANK_MAX], ci[PARTIAL_BANK_MAX];
+    float amp[PARTIAL_BANK_MAX], slope[PARTIAL_BANK_MAX];
+    memcpy(re, bank->re, lanes * sizeof(float));
+    memcpy(im, bank->im, lanes * sizeof(float));
+    memcpy(cr, bank->rot_re, lanes * sizeof(float));
+    memcpy(ci, bank->rot_im, lanes * sizeof(float));
+    memcpy(amp, bank->amp, lanes * sizeof(float));
+
+    PartialLanesAvx2 l;
+    lanes_load_avx2(&l, re, im, cr, ci, amp, slope, lanes);
+    for (size_t i = 0; i < frames;) {
+        const size_t n = control_span(bank->control_block, frames - i);
+        lanes_ramp_avx2(&l, amp, slope, bank->decay, bank->block_decay, bank->control_block, n,
+                        lanes);
+        for (size_t j = 0; j < n; ++j, ++i) {
+            const __m256 t0 = lanes_step_avx2(&l, 0);
+            __m128 acc = _mm_add_ps(_mm256_castps256_ps128(t0), _mm256_extractf128_ps(t0, 1));
+            if (l.pairs == 2) {
+                const __m256 t1 = lanes_step_avx2(&l, 1);
+                acc = _mm_add_ps(acc, _mm256_castps256_ps128(t1));
+                acc = _mm_add_ps(acc, _mm256_extractf128_ps(t1, 1));
+            }
+            bank_put(out, mix, i, hsum4_avx2(acc));
+        }
+    }
+    lanes_store_avx2(&l, re, im, amp);
+
+    renormalize_lanes(re, im, amp, 0u, lanes);
+    memcpy(bank->re, re, lanes * sizeof(float));
+    memcpy(bank->im, im, lanes * sizeof(float));
+    memcpy(bank->amp, amp, lanes * sizeof(float));
+}
+
+CPU_TARGET_AVX2 CPU_INLINE void process_multi_body_avx2(PartialBank *const *banks,
+                                                        size_t count,
+                                                        float *const *outs,
+                                                        const MixTarget *mixes,
+                                                        size_t frames) {
+    size_t v = 0;
+    while (v < count) {
+        float re[PARTIAL_BANK_MAX], im[PARTIAL_BANK_MAX];
+        float cr[PARTIAL_BANK_MAX], ci[PARTIAL_BANK_MAX];
+        float amp[PARTIAL_BANK_MAX], slope[PARTIAL_BANK_MAX];
+        float decay[PARTIAL_BANK_MAX], block_decay[PARTIAL_BANK_MAX];
+        size_t packed[PARTIAL_BANK_MAX / PARTIAL_BANK_WIDTH];
+        size_t first_group[PARTIAL_BANK_MAX / PARTIAL_BANK_WIDTH + 1u];
+        size_t packed_count = 0;
+        size_t lanes = 0;
+        size_t block = 0;
+        while (v < count) {
+            PartialBank *bank = banks[v];
+            const size_t need = bank ? lane_count(bank->count) : 0u;
+            if (need == 0u) {
+                if (outs != NULL) {
+                    memset(outs[v], 0, frames * sizeof(float));
+                }
+                ++v;
+                continue;
+            }
+            /* Packed banks share their control spans. */
+            if (lanes + need > PARTIAL_BANK_MAX || (lanes > 0u && bank->control_block != block)) {
+                break;
+            }
+            block = bank->control_block;
+            memcpy(re + lanes, bank->re, need * sizeof(float));
+            memcpy(im + lanes, bank->im, need * sizeof(float));
+            memcpy(cr + lanes, bank->rot_re, need * sizeof(float));
+            memcpy(ci + lanes, bank->rot_im, need * sizeof(float));
+            memcpy(amp + lanes, bank->amp, need * sizeof(float));
+            memcpy(decay + lanes, bank->decay, need * sizeof(float));
+            memcpy(block_decay + lanes, bank->block_decay, need * sizeof(float));
+            first_group[packed_count] = lanes / PARTIAL_BANK_WIDTH;
+            packed[packed_count++] = v;
+            lanes += need;
+            ++v;
+        }
+        if (lanes == 0u) {
+            continue;
+        }
+        first_group[packed_count] = lanes / PARTIAL_BANK_WIDTH;
+
+        PartialLanesAvx2 l;
+        lanes_load_avx2(&l, re, im, cr, ci, amp, slope, lanes);
+        for (size_t i = 0; i < frames;) {
+            const size_t n = control_span(block, frames - i);
+            lanes_ramp_avx2(&l, amp, slope, decay, block_decay, block, n, lanes);
+            for (size_t j = 0; j < n; ++j, ++i) {
+                /* Transposing the four groups sums each one lane by lane. */
+                const __m256 t0 = lanes_step_avx2(&l, 0);
+                const __m256 t1 = l.pairs == 2 ? lanes_step_avx2(&l, 1) : _mm256_setzero_ps();
+                __m128 g0 = _mm256_castps256_ps128(t0), g1 = _mm256_extractf128_ps(t0, 1);
+                __m128 g2 = _mm256_castps256_ps128(t1), g3 = _mm256_extractf128_ps(t1, 1);
+                _MM_TRANSPOSE4_PS(g0, g1, g2, g3);
+                float group_sum[PARTIAL_BANK_MAX / PARTIAL_BANK_WIDTH];
+                _mm_storeu_ps(group_sum, _mm_add_ps(_mm_add_ps(_mm_add_ps(g0, g1), g2), g3));
+                for (size_t b = 0; b < packed_count; ++b) {
+                    float y = group_sum[first_group[b]];
+                    for (size_t g = first_group[b] + 1u; g < first_group[b + 1u]; ++g) {
+                        y += group_sum[g];
+                    }
+                    const size_t dst = packed[b];
+                    bank_put(mixes ? NULL : outs[dst], mixes ? &mixes[dst] : NULL, i, y);
+                }
+            }
+        }
+        lanes_store_avx2(&l, re, im, amp);
+
+        size_t offset = 0;
+        for (size_t b = 0; b < packed_count; ++b) {
+            PartialBank *bank = banks[packed[b]];
+            const size_t need = lane_count(bank->count);
+            renormalize_lanes(re, im, amp, offset, offset + need);
+            memcpy(bank->re, re + offset, need * sizeof(float));
+            memcpy(bank->im, im + offset, need * sizeof(float));
+            memcpy(bank->amp, amp + offset, need * sizeof(float));
+            offset += need;
+        }
+    }
+}
+#endif
+
+typedef struct {
+    void (*process)(PartialBank *, float *, size_t);
+    void (*process_mix)(PartialBank *, const MixTarget *, size_t);
+    void (*process_multi)(PartialBank *const *, size_t, float *const *, size_t);
+    void (*process_multi_mix)(PartialBank *const *, size_t, const MixTarget *, size_t);
+} PartialBankKernels;
+
+#define DEFINE_PARTIAL_KERNELS(suffix, attr, body, multi)                               \
+    attr static void process_##suffix(PartialBank *bank, float *out, size_t frames) {   \
+        body(bank, out, NULL, frames);                                                  \
+    }                                                                                   \
+    attr static void process_mix_##suffix(PartialBank *bank, const MixTarget *mix,      \
+                                          size_t frames) {                              \
+        body(bank, NULL, mix, frames);                                                  \
+    }                                                                                   \
+    attr static void process_multi_##suffix(PartialBank *const *banks, size_t count,    \
+                                            float *const *outs, size_t frames) {        \
+        multi(banks, count, outs, NULL, frames);                                        \
+    }                                                                                   \
+    attr static void process_multi_mix_##suffix(PartialBank *const *banks, size_t count,\
+                                                const MixTarget *mixes, size_t frames) {\
+        multi(banks, count, NULL, mixes, frames);                                       \
+    }                                                                                   \
+    static const PartialBankKernels partial_kernels_##suffix = {                        \
+        process_##suffix, process_mix_##suffix, process_multi_##suffix,                 \
+        process_multi_mix_##suffix,                                                     \
+    };
+
+DEFINE_PARTIAL_KERNELS(baseline, , process_body, process_multi_body)
+#if CPU_MULTIVERSION
+DEFINE_PARTIAL_KERNELS(avx2, CPU_TARGET_AVX2, process_body_avx2, process_multi_body_avx2)
+#endif
+
+/* AVX-512 hosts run the AVX2 kernels; sixteen lanes fit two ymm registers. */
+static const PartialBankKernels *partial_kernels_selected = &partial_kernels_baseline;
+static pthread_once_t partial_kernels_once = PTHREAD_ONCE_INIT;
+
+static void partial_kernels_resolve(void) {
+#if CPU_MULTIVERSION
+    if (cpu_dispatch_level() >= CPU_LEVEL_AVX2) {
+        partial_kernels_selected = &partial_kernels_avx2;
+    }
+#endif
+}
+
+static const PartialBankKernels *partial_kernels(void) {
+    pthread_once(&partial_kernels_once, partial_kernels_resolve);
+    return partial_kernels_selected;
+}
+
+void partial_bank_process(PartialBank *bank, float *out, size_t frames) {
+    if (bank == NULL || out == NULL || frames == 0u) {
+        return;
+    }
+    partial_kernels()->process(bank, out, frames);
+}
+
+void partial_bank_process_multi(PartialBank *const *banks,
+                                size_t count,
+                                float *const *outs,
+                                size_t frames) {
+    if (banks == NULL || outs == NULL || frames == 0u) {
+        return;
+    }
+    partial_kernels()->process_multi(banks, count, outs, frames);
+}
+
+void partial_bank_process_mix(PartialBank *bank, const MixTarget *mix, size_t frames) {
+    if (bank == NULL || mix == NULL || frames == 0u) {
+        return;
+    }
+    partial_kernels()->process_mix(bank, mix, frames);
+}
+
+void partial_bank_process_multi_mix(PartialBank *const *banks,
+                                    size_t count,
+                                    const MixTarget *mixes,
+                                    size_t frames) {
+    if (banks == NULL || mixes == NULL || frames == 0u) {
+        return;
+    }
+    partial_kernels()->process_multi_mix(banks, count, mixes, frames);
+}
@@ -0,0 +1,372 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "resampler.h"
+
+#include "cpu_dispatch.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define FRAC_SCALE (1.0f / 16777216.0f)
+#define RESAMPLE_UNITY ((uint64_t)1u << 32)
+#define PHASE_BITS 8u
+#define KAISER_BETA 8.0
+#define SINC_PASSBAND 0.92
+
+/* Sinc tables for reading 1, 1.125, 1.25, ... 4 source frames per output frame. */
+#define SINC_FACTOR_COUNT 25u
+
+/* Built on first use; the lock lets resamplers be created from pool workers. */
+static float *sinc_tables[SINC_FACTOR_COUNT];
+static pthread_mutex_t sinc_tables_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void *xmalloc(size_t sz) {
+    void *ptr = malloc(sz);
+    if (!ptr) {
+        fprintf(stderr, "synthrave: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    return ptr;
+}
+
+static double sinc_factor(size_t index) {
+    return 1.0 + 0.125 * (double)index;
+}
+
+static uint32_t sinc_taps(size_t index) {
+    return RESAMPLE_SINC_TAPS * (uint32_t)ceil(sinc_factor(index));
+}
+
+static double bessel_i0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+/* Row r holds the taps for a source position r / PHASES past the centre frame. */
+static float *sinc_table_build(size_t index) {
+    const uint32_t taps = sinc_taps(index);
+    const double half = (double)(taps / 2u);
+    const double cutoff = SINC_PASSBAND / sinc_factor(index);
+    const double norm = bessel_i0(KAISER_BETA);
+    float *table = xmalloc((RESAMPLE_SINC_PHASES + 1u) * taps * sizeof(float));
+    for (uint32_t r = 0; r <= RESAMPLE_SINC_PHASES; ++r) {
+        const double frac = (double)r / (double)RESAMPLE_SINC_PHASES;
+        float *row = table + (size_t)r * taps;
+        double sum = 0.0;
+        double coeffs[RESAMPLE_SINC_TAPS * 4u];
+        for (uint32_t k = 0; k < taps; ++k) {
+            const double x = (double)k - (half - 1.0) - frac;
+            const double arg = M_PI * cutoff * x;
+            const double s = fabs(arg) < 1e-9 ? 1.0 : sin(arg) / arg;
+            const double w = x / half;
+            const double window = fabs(w) >= 1.0 ? 0.0 : bessel_i0(KAISER_BETA * sqrt(1.0 - w * w)) / norm;
+            coeffs[k] = s * window;
+            sum += coeffs[k];
+        }
+        for (uint32_t k = 0; k < taps; ++k) {
+            row[k] = (float)(coeffs[k] / sum);
+        }
+    }
+    return table;
+}
+
+/*
+ * Within one call the linear path works in 32-bit positions relative to the
+ * first frame (12.20 fixed point), so GCC vectorizes the index and fraction
+ * math (the two taps are still loaded one lane at a time, not gathered);
+ * chunks restart from the exact 64-bit position so the truncated step
+ * cannot drift.
+ */
+#define LOCAL_FRAC_BITS 20u
+#define LOCAL_FRAC_SCALE (1.0f / 1048576.0f)
+#define LOCAL_SPAN ((uint64_t)1 << (32u + 31u - LOCAL_FRAC_BITS))
+
+CPU_INLINE void linear_chunk(const float *restrict base,
+                             uint32_t pos,
+                             uint32_t step,
+                             float *restrict out,
+                             size_t n) {
+    const size_t body = n & ~(size_t)(CPU_VECTOR_BLOCK - 1u);
+    for (size_t i = 0; i < body; ++i) {
+        const uint32_t p = pos + (uint32_t)i * step;
+        const uint32_t idx = p >> LOCAL_FRAC_BITS;
+        const float frac = (float)(int32_t)(p & ((1u << LOCAL_FRAC_BITS) - 1u)) * LOCAL_FRAC_SCALE;
+        const float a = base[idx];
+        out[i] = a + (base[idx + 1u] - a) * frac;
+    }
+    for (size_t i = body; i < n; ++i) {
+        const uint32_t p = pos + (uint32_t)i * step;
+        const uint32_t idx = p >> LOCAL_FRAC_BITS;
+        const float frac = (float)(int32_t)(p & ((1u << LOCAL_FRAC_BITS) - 1u)) * LOCAL_FRAC_SCALE;
+        const float a = base[idx];
+        out[i] = a + (base[idx + 1u] - a) * frac;
+    }
+}
+
+CPU_INLINE void linear_body(const float *restrict src,
+                            uint64_t pos,
+                            uint64_t step,
+                            float *restrict out,
+                            size_t n) {
+    const size_t max_chunk = (size_t)(LOCAL_SPAN / (step + 1u));
+    while (n > 0u) {
+        const size_t chunk = n < max_chunk ? n : max_chunk;
+        linear_chunk(src + (pos >> 32), (uint32_t)pos >> (32u - LOCAL_FRAC_BITS),
+                     (uint32_t)(step >> (32u - LOCAL_FRAC_BITS)), out, chunk);
+        pos += (uint64_t)chunk * step;
+        out += chunk;
+        n -= chunk;
+    }
+}
+
+/* Source frame j with silence before the start and the last frame held after the end. */
+static inline float source_at(const float *src, size_t length, int64_t j) {
+    if (j < 0) {
+        return 0.0f;
+    }
+    return (size_t)j < length ? src[j] : src[length - 1u];
+}
+
+CPU_INLINE void sinc_body(const float *restrict src,
+                          size_t length,
+                          const float *restrict table,
+                          uint32_t taps,
+                          uint64_t pos,
+                          uint64_t step,
+                          float *restrict out,
+                          size_t n) {
+    const int64_t half = (int64_t)(taps / 2u);
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t p = pos + (uint64_t)i * step;
+        const uint32_t frac = (uint32_t)p;
+        const float *restrict r0 = table + (size_t)(frac >> (32u - PHASE_BITS)) * taps;
+        const float *restrict r1 = r0 + taps;
+        const float blend = (float)(int32_t)((frac << PHASE_BITS) >> 8) * FRAC_SCALE;
+        const int64_t start = (int64_t)(p >> 32) - half + 1;
+        float acc[RESAMPLE_SINC_TAPS] = {0.0f};
+        if (start >= 0 && (size_t)start + taps <= length) {
+            const float *restrict s = src + start;
+            for (size_t k = 0; k < taps; k += RESAMPLE_SINC_TAPS) {
+                for (size_t j = 0; j < RESAMPLE_SINC_TAPS; ++j) {
+                    const float c = r0[k + j] + (r1[k + j] - r0[k + j]) * blend;
+                    acc[j] += s[k + j] * c;
+                }
+            }
+        } else {
+            for (size_t k = 0; k < taps; k += RESAMPLE_SINC_TAPS) {
+                for (size_t j = 0; j < RESAMPLE_SINC_TAPS; ++j) {
+                    const float c = r0[k + j] + (r1[k + j] - r0[k + j]) * blend;
+                    acc[j] += source_at(src, length, start + (int64_t)(k + j)) * c;
+                }
+            }
+        }
+        /* pairwise lane sum; a loop over a halving width would stay scalar */
+        float sum8[RESAMPLE_SINC_TAPS / 2u];
+        for (size_t j = 0; j < RESAMPLE_SINC_TAPS / 2u; ++j) {
+            sum8[j] = acc[j] + acc[j + RESAMPLE_SINC_TAPS / 2u];
+        }
+        float sum4[RESAMPLE_SINC_TAPS / 4u];
+        for (size_t j = 0; j < RESAMPLE_SINC_TAPS / 4u; ++j) {
+            sum4[j] = sum8[j] + sum8[j + RESAMPLE_SINC_TAPS / 4u];
+        }
+        out[i] = (sum4[0] + sum4[2]) + (sum4[1] + sum4[3]);
+    }
+}
+
+typedef struct {
+    void (*linear)(const float *, uint64_t, uint64_t, float *, size_t);
+    void (*sinc)(const float *, size_t, const float *, uint32_t, uint64_t, uint64_t, float *, size_t);
+} ResampleKernels;
+
+#define DEFINE_RESAMPLE_KERNELS(suffix, attr)                                          \
+    attr static void linear_##suffix(const float *src, uint64_t pos, uint64_t step,  \
+                                     float *out, size_t n) {                         \
+        linear_body(src, pos, step, out, n);                                          \
+    }                                                                                 \
+    attr static void sinc_##suffix(const float *src, size_t length,                  \
+                                   const float *table, uint32_t taps, uint64_t pos,  \
+                                   uint64_t step, float *out, size_t n) {            \
+        sinc_body(src, length, table, taps, pos, step, out, n);                       \
+    }                                                                                 \
+    static const ResampleKernels resample_kernels_##suffix = {                       \
+        linear_##suffix, sinc_##suffix,                                               \
+    };
+
+DEFINE_RESAMPLE_KERNELS(baseline, )
+#if CPU_MULTIVERSION
+DEFINE_RESAMPLE_KERNELS(avx2, CPU_TARGET_AVX2)
+DEFINE_RESAMPLE_KERNELS(avx512, CPU_TARGET_AVX512)
+#endif
+
+static const ResampleKernels *resample_kernels_selected = &resample_kernels_baseline;
+static pthread_once_t resample_kernels_once = PTHREAD_ONCE_INIT;
+
+static void resample_kernels_resolve(void) {
+    switch (cpu_dispatch_level()) {
+#if CPU_MULTIVERSION
+        case CPU_LEVEL_AVX512:
+            resample_kernels_selected = &resample_kernels_avx512;
+            break;
+        case CPU_LEVEL_AVX2:
+            resample_kernels_selected = &resample_kernels_avx2;
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+static const ResampleKernels *resample_kernels(void) {
+    pthread_once(&resample_kernels_once, resample_kernels_resolve);
+    return resample_kernels_selected;
+}
+
+void resampler_init(Resampler *rs,
+                    const float *src,
+                    size_t length,
+                    double step,
+                    ResampleQuality quality) {
+    if (rs == NULL) {
+        return;
+    }
+    memset(rs, 0, sizeof(*rs));
+    rs->src = src;
+    rs->length = src ? length : 0u;
+    rs->step = step > 0.0 ? (uint64_t)llround(step * 4294967296.0) : 0u;
+    rs->quality = quality;
+    if (quality != RESAMPLE_SINC) {
+        return;
+    }
+    size_t index = 0;
+    while (index + 1u < SINC_FACTOR_COUNT && sinc_factor(index) < step) {
+        ++index;
+    }
+    pthread_mutex_lock(&sinc_tables_lock);
+    if (sinc_tables[index] == NULL) {
+        sinc_tables[index] = sinc_table_build(index);
+    }
+    rs->table = sinc_tables[index];
+    pthread_mutex_unlock(&sinc_tables_lock);
+    rs->taps = sinc_taps(index);
+}
+
+void resampler_set_quality(Resampler *rs, ResampleQuality quality) {
+    if (rs == NULL || rs->quality == quality) {
+        return;
+    }
+    const Resampler old = *rs;
+    resampler_init(rs, old.src, old.length, (double)old.step / 4294967296.0, quality);
+    rs->pos = old.pos;
+    rs->loop_start = old.loop_start;
+    rs->loop_end = old.loop_end;
+}
+
+/* Unity rate on a whole frame: the source frames themselves, the last one held. */
+static void copy_span(Resampler *rs, float *out, size_t frames) {
+    const size_t first = (size_t)(rs->pos >> 32);
+    size_t inside = first < rs->length ? rs->length - first : 0u;
+    inside = inside < frames ? inside : frames;
+    memcpy(out, rs->src + first, inside * sizeof(float));
+    const float last = rs->src[rs->length - 1u];
+    for (size_t i = inside; i < frames; ++i) {
+        out[i] = last;
+    }
+    rs->pos += (uint64_t)frames << 32;
+}
+
+static void resample_span(Resampler *rs, float *out, size_t frames) {
+    if (rs->step == RESAMPLE_UNITY && (uint32_t)rs->pos == 0u) {
+        copy_span(rs, out, frames);
+        return;
+    }
+    if (rs->table != NULL) {
+        resample_kernels()->sinc(rs->src, rs->length, rs->table, rs->taps, rs->pos, rs->step,
+                                 out, frames);
+        rs->pos += (uint64_t)frames * rs->step;
+        return;
+    }
+    /* frames whose right-hand tap is still inside the source need no bounds check */
+    const uint64_t limit = (uint64_t)(rs->length - 1u) << 32;
+    size_t inside = 0;
+    if (rs->pos < limit) {
+        inside = rs->step ? (size_t)((limit - rs->pos + rs->step - 1u) / rs->step) : frames;
+        inside = inside < frames ? inside : frames;
+    }
+    resample_kernels()->linear(rs->src, rs->pos, rs->step, out, inside);
+    const float last = rs->src[rs->length - 1u];
+    for (size_t i = inside; i < frames; ++i) {
+        out[i] = last;
+    }
+    rs->pos += (uint64_t)frames * rs->step;
+}
+
+void resampler_process(Resampler *rs, float *out, size_t frames) {
+    if (rs == NULL || out == NULL) {
+        return;
+    }
+    if (rs->length == 0u) {
+        memset(out, 0, frames * sizeof(float));
+        return;
+    }
+    if (rs->loop_end == 0u || rs->step == 0u) {
+        resample_span(rs, out, frames);
+        return;
+    }
+    /* split where the position crosses loop_end so every span reads unwrapped */
+    const uint64_t loop_len = rs->loop_end - rs->loop_start;
+    while (frames > 0u) {
+        while (rs->pos >= rs->loop_end) {
+            rs->pos -= loop_len;
+        }
+        size_t n = (size_t)((rs->loop_end - rs->pos + rs->step - 1u) / rs->step);
+        n = n < frames ? n : frames;
+        resample_span(rs, out, n);
+        out += n;
+        frames -= n;
+    }
+}
+
+void resampler_set_loop(Resampler *rs, size_t start, size_t end) {
+    if (rs == NULL) {
+        return;
+    }
+    if (end <= start || end > rs->length) {
+        rs->loop_start = 0u;
+        rs->loop_end = 0u;
+        return;
+    }
+    rs->loop_start = (uint64_t)start << 32;
+    rs->loop_end = (uint64_t)end << 32;
+}
+
+bool resampler_parse_quality(const char *name, ResampleQuality *out) {
+    if (name == NULL || out == NULL) {
+        return false;
+    }
+    if (strcasecmp(name, "sinc") == 0) {
+        *out = RESAMPLE_SINC;
+        return true;
+    }
+    if (strcasecmp(name, "linear") == 0) {
+        *out = RESAMPLE_LINEAR;
+        return true;
+    }
+    return false;
+}
+
+const char *resampler_quality_name(ResampleQuality quality) {
+    return quality == RESAMPLE_LINEAR ? "linear" : "sinc";
+}
@@ -2,7 +2,17 @@
 
 #include "scheduler.h"
 
+#include "arena.h"
+#include "bake.h"
+#include "control_rate.h"
+#include "denormal.h"
+#include "filter.h"
+#include "fixed_point.h"
+#include "governor.h"
 #include "instruments_ext.h"
+#include "mix_kernels.h"
+#include "oscillator.h"
+#include "resampler.h"
 
 #include <AL/al.h>
 #include <AL/alc.h>
@@ -22,28 +32,38 @@
 #endif
 
 #define MIX_BLOCK 512
+/* Resampled one-shots are read through a stack chunk this long before mixing. */
+#define SAMPLE_MIX_CHUNK 256u
 
 typedef struct {
     SeqSpec spec;
-    int channel;
+    float gain[2]; /* left, right; 0 keeps the voice off that bus */
     size_t start_sample;
     size_t total_samples;
     size_t rendered;
     float duration_s;
+    bool baked; /* played from a baked table instead of its kernel */
     union {
         struct {
-            float phase;
+            uint32_t phase;
+            uint32_t inc;
         } osc;
         struct {
-            float phase;
+            uint32_t phase;
+            uint32_t inc;
+            uint32_t start_inc;
+            uint32_t end_inc;
         } glide;
+        PartialBank chord;
         struct {
-            float phases[16];
-        } chord;
+            uint32_t phase[16];
+            uint32_t inc[16];
+            int32_t gain; /* Q15, 1 / count */
+            int count;
+        } chord_q; /* CHORD in an integer mix */
         struct {
-            const SampleData *sample;
-            double pos;
-            double step;
+            Resampler rs;
+            const float *direct; /* session-rate copy when playing at unity pitch */
         } sample;
         KickState kick;
         SnareState snare;
@@ -63,6 +83,8 @@ typedef struct {
         AnalogLeadState analog;
         SidBassState sid;
         ChipArpState chip;
+        FmState fm;
+        BakedVoice bake;
     } state;
 } VoiceRuntime;
 
@@ -81,15 +103,6 @@ static void *xcalloc(size_t n, size_t sz) {
     return ptr;
 }
 
-static void *xmalloc(size_t sz) {
-    void *ptr = malloc(sz);
-    if (!ptr) {
-        fprintf(stderr, "synthrave: out of memory\n");
-        exit(EXIT_FAILURE);
-    }
-    return ptr;
-}
-
 static void *xrealloc(void *ptr, size_t sz) {
     void *p = realloc(ptr, sz);
     if (!p && sz != 0) {
@@ -108,105 +121,260 @@ static void voice_vec_push(VoiceVec *vec, const VoiceRuntime *vr) {
     vec->items[vec->len++] = *vr;
 }
 
+/*
+ * Delay lines of finished pluck voices, one free list per power-of-two
+ * length, so a long song reuses a handful of lines instead of growing the
+ * arena by one per note.
+ */
+#define DELAY_POOL_BUCKETS 32
+
+typedef struct DelayLineFree {
+    struct DelayLineFree *next;
+} DelayLineFree;
+
+typedef struct {
+    Arena *arena;
+    DelayLineFree *free[DELAY_POOL_BUCKETS];
+} DelayPool;
+
+static unsigned int delay_bucket(size_t len) {
+    unsigned int b = 0;
+    while (b < DELAY_POOL_BUCKETS && ((size_t)1 << b) < len) {
+        ++b;
+    }
+    return b;
+}
+
+static float *delay_line_take(DelayPool *pool, size_t len) {
+    const unsigned int b = delay_bucket(len);
+    if (b < DELAY_POOL_BUCKETS && ((size_t)1 << b) == len && pool->free[b]) {
+        DelayLineFree *line = pool->free[b];
+        pool->free[b] = line->next;
+        return (float *)(void *)line;
+    }
+    return arena_alloc(pool->arena, len * sizeof(float));
+}
+
+static void delay_line_give(DelayPool *pool, float *line, size_t len) {
+    const unsigned int b = delay_bucket(len);
+    if (b >= DELAY_POOL_BUCKETS || ((size_t)1 << b) != len) {
+        return;
+    }
+    DelayLineFree *node = (DelayLineFree *)(void *)line;
+    node->next = pool->free[b];
+    pool->free[b] = node;
+}
+
 static bool spec_is_silence(const SeqSpec *sp) {
-    return !sp || sp->type == SEQ_SPEC_SILENCE || sp->f_const <= 0.f;
+    if (!sp) {
+        return true;
+    }
+    switch (sp->type) {
+        case SEQ_SPEC_SILENCE:
+            return true;
+        case SEQ_SPEC_CHORD:
+            return sp->chord_count <= 0;
+        case SEQ_SPEC_GLIDE:
+            return sp->f0 <= 0.f && sp->f1 <= 0.f;
+        case SEQ_SPEC_SAMPLE:
+            return sp->sample == NULL;
+        default:
+            return sp->f_const <= 0.f;
+    }
 }
 
-static size_t pluck_delay(float freq, int sr) {
-    if (freq <= 0.f) {
-        freq = 110.f;
+/* Instruments that draw from rand(), so two renders of one spec differ. */
+static bool spec_uses_noise(SeqSpecType type) {
+    switch (type) {
+        case SEQ_SPEC_KICK:
+        case SEQ_SPEC_SNARE:
+        case SEQ_SPEC_HIHAT:
+        case SEQ_SPEC_FLUTE:
+        case SEQ_SPEC_GUITAR:
+        case SEQ_SPEC_KALIMBA:
+        case SEQ_SPEC_EGTR:
+        case SEQ_SPEC_BIRDS:
+            return true;
+        default:
+            return false;
     }
-    size_t delay = (size_t)((float)sr / freq);
-    if (delay < 2) {
-        delay = 2;
+}
+
+/*
+ * Pluck noise seed from the tone's start frame, pitch and side, so the noise
+ * does not depend on when the feed created the voice.
+ */
+static uint32_t voice_noise_seed(const SeqToneEvent *tone, const SeqSpec *spec) {
+    uint32_t pitch;
+    memcpy(&pitch, &spec->f_const, sizeof(pitch));
+    const uint64_t start = (uint64_t)tone->start_sample;
+    uint32_t h = (uint32_t)start ^ (uint32_t)(start >> 32);
+    h = h * 2654435761u ^ pitch * 2246822519u ^ (spec == &tone->right ? 0x9e3779b9u : 0u);
+    h ^= h >> 15;
+    h *= 2246822519u;
+    h ^= h >> 13;
+    return h;
+}
+
+/* Identical specs on both sides, e.g. a panned MIDI note. */
+static bool spec_same(const SeqSpec *a, const SeqSpec *b) {
+    if (a->type != b->type || a->f_const != b->f_const || a->f0 != b->f0 || a->f1 != b->f1 ||
+        a->chord_count != b->chord_count || a->sample != b->sample ||
+        a->sample_channel != b->sample_channel || a->patch != b->patch) {
+        return false;
     }
-    if (delay >= 128) {
-        delay = 127;
+    for (int h = 0; h < a->chord_count && h < 16; ++h) {
+        if (a->chord[h] != b->chord[h]) {
+            return false;
+        }
     }
-    return delay;
+    return true;
 }
 
 static bool voice_init(VoiceRuntime *vr,
                        const SeqToneEvent *tone,
                        const SeqSpec *spec,
-                       int channel,
-                       int sample_rate) {
+                       float gain_l,
+                       float gain_r,
+                       const SequenceOptions *opts,
+                       DelayPool *lines,
+                       bool fixed) {
     if (!vr || !spec || tone->sample_count == 0 || spec_is_silence(spec)) {
         return false;
     }
+    const int sample_rate = opts->sample_rate;
+    osc_tables_init();
     memset(vr, 0, sizeof(*vr));
     vr->spec = *spec;
-    vr->channel = channel;
+    vr->gain[0] = gain_l;
+    vr->gain[1] = gain_r;
     vr->start_sample = tone->start_sample;
     vr->total_samples = tone->sample_count;
     vr->duration_s = (float)tone->sample_count / (float)sample_rate;
+    const float sr = (float)sample_rate;
+    if ((opts->bake_mask & BAKE_BIT(spec->type)) != 0u &&
+        baked_voice_init(&vr->state.bake, spec->type, spec->f_const, sample_rate)) {
+        vr->baked = true;
+        return true;
+    }
 
     switch (spec->type) {
-        case SEQ_SPEC_SAMPLE:
-            if (!spec->sample) {
+        case SEQ_SPEC_CONST:
+            vr->state.osc.inc = osc_phase_inc(spec->f_const, sr);
+            break;
+        case SEQ_SPEC_GLIDE:
+            vr->state.glide.inc = osc_phase_inc(spec->f0, sr);
+            vr->state.glide.start_inc = vr->state.glide.inc;
+            vr->state.glide.end_inc = osc_phase_inc(spec->f1, sr);
+            break;
+        case SEQ_SPEC_CHORD: {
+            int count = spec->chord_count > 16 ? 16 : spec->chord_count;
+            if (fixed) {
+                vr->state.chord_q.count = count;
+                vr->state.chord_q.gain = count > 0 ? Q15_ONE / count : 0;
+                for (int h = 0; h < count; ++h) {
+                    vr->state.chord_q.inc[h] = osc_phase_inc(spec->chord[h], sr);
+                }
+                break;
+            }
+            partial_bank_init(&vr->state.chord);
+            for (int h = 0; h < count; ++h) {
+                partial_bank_add(&vr->state.chord, spec->chord[h], sr,
+                                 1.f / (float)count, 1.f);
+            }
+            break;
+        }
+        case SEQ_SPEC_SAMPLE: {
+            const SampleData *sd = spec->sample;
+            if (!sd || sd->length <= 0) {
                 return false;
             }
-            vr->state.sample.sample = spec->sample;
-            vr->state.sample.pos = 0.0;
-            vr->state.sample.step =
-                (double)spec->sample->length / (double)vr->total_samples;
+            const int ch = spec->sample_channel < sd->channels ? spec->sample_channel : 0;
+            if (sd->rate == sample_rate && (size_t)sd->rate_length == vr->total_samples &&
+                sd->rate_chan[ch]) {
+                vr->state.sample.direct = sd->rate_chan[ch];
+                break;
+            }
+            resampler_init(&vr->state.sample.rs, sd->chan[ch], (size_t)sd->length,
+                           (double)sd->length / (double)vr->total_samples,
+                           opts->resample_quality);
             break;
-        case SEQ_SPEC_KICK:
-            kick_state_init(&vr->state.kick);
+        }
+        case SEQ_SPEC_KICK: {
+            float start = spec->f0 > 0.f ? spec->f0 : 140.f;
+            float end = spec->f1 > 0.f ? spec->f1 : start * 0.35f;
+            kick_state_init(&vr->state.kick, sr, start, end, vr->duration_s);
             break;
+        }
         case SEQ_SPEC_SNARE:
-            snare_state_init(&vr->state.snare);
+            snare_state_init(&vr->state.snare, sr,
+                             spec->f_const > 0.f ? spec->f_const : 200.f,
+                             vr->duration_s);
             break;
         case SEQ_SPEC_HIHAT:
-            hat_state_init(&vr->state.hat);
+            hat_state_init(&vr->state.hat, sr);
             break;
         case SEQ_SPEC_BASS:
-            bass_state_init(&vr->state.bass);
+            bass_state_init(&vr->state.bass, sr, spec->f_const);
             break;
         case SEQ_SPEC_FLUTE:
-            flute_state_init(&vr->state.flute);
+            flute_state_init(&vr->state.flute, sr, spec->f_const);
             break;
         case SEQ_SPEC_PIANO:
-            piano_state_init(&vr->state.piano);
+            piano_state_init(&vr->state.piano, sr, spec->f_const);
             break;
-        case SEQ_SPEC_GUITAR:
-            ks_state_init(&vr->state.karplus, 0.995f, pluck_delay(spec->f_const, sample_rate));
+        case SEQ_SPEC_GUITAR: {
+            size_t len = ks_delay_length(sr, spec->f_const);
+            float *line = delay_line_take(lines, len);
+            ks_state_init(&vr->state.karplus, line, len, sr, spec->f_const, 0.995f,
+                          voice_noise_seed(tone, spec));
             break;
+        }
         case SEQ_SPEC_EGTR:
-            egtr_state_init(&vr->state.egtr);
+            egtr_state_init(&vr->state.egtr, sr, spec->f_const, 3.0f);
             break;
         case SEQ_SPEC_BIRDS:
-            birds_state_init(&vr->state.birds);
+            birds_state_init(&vr->state.birds, sr);
             break;
         case SEQ_SPEC_STRPAD:
-            strpad_state_init(&vr->state.strpad);
+            strpad_state_init(&vr->state.strpad, sr, spec->f_const);
             break;
         case SEQ_SPEC_BELL:
-            bell_state_init(&vr->state.bell);
+            bell_state_init(&vr->state.bell, sr, spec->f_const);
             break;
         case SEQ_SPEC_BRASS:
-            brass_state_init(&vr->state.brass);
+            brass_state_init(&vr->state.brass, sr, spec->f_const);
             break;
-        case SEQ_SPEC_KALIMBA:
-            kalimba_state_init(&vr->state.kalimba, pluck_delay(spec->f_const, sample_rate));
+        case SEQ_SPEC_KALIMBA: {
+            size_t len = ks_delay_length(sr, spec->f_const);
+            float *line = delay_line_take(lines, len);
+            kalimba_state_init(&vr->state.kalimba, line, len, sr, spec->f_const,
+                               voice_noise_seed(tone, spec));
             break;
+        }
         case SEQ_SPEC_LASER:
             laser_synth_init(&vr->state.laser,
+                             sr,
                              spec->f_const > 0.f ? spec->f_const : 1320.f,
                              spec->f1 > 0.f ? spec->f1 : spec->f_const * 0.2f,
-                             3.0f);
+                             3.0f,
+                             vr->duration_s);
             break;
         case SEQ_SPEC_CHOIR:
             choir_synth_init(&vr->state.choir,
-                             spec->f_const > 0.f ? spec->f_const : 261.63f);
+                             sr,
+                             spec->f_const > 0.f ? spec->f_const : 261.63f,
+                             0.4f);
             break;
         case SEQ_SPEC_ANALOGLEAD:
             analog_lead_init(&vr->state.analog,
+                             sr,
                              spec->f_const > 0.f ? spec->f_const : 440.f,
                              0.02f);
             break;
         case SEQ_SPEC_SIDBASS:
             sid_bass_init(&vr->state.sid,
+                          sr,
                           spec->f_const > 0.f ? spec->f_const : 55.f,
                           120.f);
             break;
@@ -223,161 +391,141 @@ static bool voice_init(VoiceRuntime *vr,
                     notes[i] = spec->chord[i];
                 }
             }
-            chip_arp_init(&vr->state.chip, notes, count, 60.f);
+            chip_arp_init(&vr->state.chip, sr, notes, count, 60.f);
             break;
         }
+        case SEQ_SPEC_FM:
+            fm_state_init(&vr->state.fm, sr, spec->f_const, spec->patch);
+            break;
         default:
             break;
     }
     return true;
 }
 
+/* Adds the voice's next `frames` samples through the mix target. */
 static void voice_render_block(VoiceRuntime *vr,
-                               float *dst,
+                               const MixTarget *mix,
                                size_t frames,
-                               int sample_rate) {
-    memset(dst, 0, frames * sizeof(float));
+                               int sample_rate,
+                               size_t control_block) {
     SynthBlockConfig cfg = {
         .sample_rate = (float)sample_rate,
         .block_duration = (float)frames / (float)sample_rate,
+        .control_block = control_block,
     };
 
+    if (vr->baked) {
+        baked_voice_process_mix(&vr->state.bake, mix, frames);
+        vr->rendered += frames;
+        return;
+    }
     switch (vr->spec.type) {
         case SEQ_SPEC_CONST: {
-            float phase = vr->state.osc.phase;
-            float step = vr->spec.f_const / (float)sample_rate;
+            uint32_t phase = vr->state.osc.phase;
+            const uint32_t inc = vr->state.osc.inc;
             for (size_t i = 0; i < frames; ++i) {
-                phase += step;
-                if (phase >= 1.f) {
-                    phase -= floorf(phase);
-                }
-                dst[i] = sinf(2.f * (float)M_PI * phase);
+                phase += inc;
+                mix_target_add(mix, i, osc_sine(phase));
             }
             vr->state.osc.phase = phase;
             break;
         }
         case SEQ_SPEC_GLIDE: {
-            float phase = vr->state.glide.phase;
-            for (size_t i = 0; i < frames; ++i) {
-                float progress = (float)(vr->rendered + i) /
-                                 (float)(vr->total_samples > 1 ? vr->total_samples - 1 : 1);
+            const size_t block = control_block_size(control_block);
+            const float span = (float)(vr->total_samples > 1 ? vr->total_samples - 1 : 1);
+            uint32_t phase = vr->state.glide.phase;
+            uint32_t inc = vr->state.glide.inc;
+            for (size_t i = 0; i < frames;) {
+                const size_t n = control_span(block, frames - i);
+                float progress = (float)(vr->rendered + i + n - 1) / span;
                 float freq = vr->spec.f0 + (vr->spec.f1 - vr->spec.f0) * progress;
-                phase += freq / (float)sample_rate;
-                if (phase >= 1.f) {
-                    phase -= floorf(phase);
+                const uint32_t next_inc = osc_phase_inc(freq, (float)sample_rate);
+                const int32_t step = control_inc_step(inc, next_inc, n);
+                for (size_t k = 0; k < n; ++k, ++i) {
+                    inc += (uint32_t)step;
+                    phase += inc;
+                    mix_target_add(mix, i, osc_sine(phase));
                 }
-                dst[i] = sinf(2.f * (float)M_PI * phase);
+                inc = next_inc;
             }
             vr->state.glide.phase = phase;
+            vr->state.glide.inc = inc;
             break;
         }
-        case SEQ_SPEC_CHORD: {
-            float phases[16] = {0};
-            memcpy(phases, vr->state.chord.phases, sizeof(phases));
-            int count = vr->spec.chord_count;
-            if (count <= 0) {
-                break;
-            }
-            for (size_t i = 0; i < frames; ++i) {
-                float acc = 0.f;
-                for (int h = 0; h < count; ++h) {
-                    phases[h] += vr->spec.chord[h] / (float)sample_rate;
-                    if (phases[h] >= 1.f) {
-                        phases[h] -= floorf(phases[h]);
-                    }
-                    acc += sinf(2.f * (float)M_PI * phases[h]);
-                }
-                dst[i] = acc / (float)count;
-            }
-            memcpy(vr->state.chord.phases, phases, sizeof(phases));
+        case SEQ_SPEC_CHORD:
+            partial_bank_process_mix(&vr->state.chord, mix, frames);
             break;
-        }
-        case SEQ_SPEC_SAMPLE: {
-            const SampleData *sd = vr->state.sample.sample;
-            if (!sd || sd->length <= 0) {
+        case SEQ_SPEC_SAMPLE:
+            if (vr->state.sample.direct) {
+                /* pre-resampled one-shot: add straight from the cache */
+                mix_accumulate_target(mix, vr->state.sample.direct + vr->rendered, frames);
                 break;
             }
-            int ch = vr->spec.sample_channel;
-            if (ch >= sd->channels) {
-                ch = 0;
-            }
-            const float *src = sd->chan[ch];
-            double pos = vr->state.sample.pos;
-            for (size_t i = 0; i < frames; ++i) {
-                size_t idx = (size_t)pos;
-                float sample;
-                if (idx >= (size_t)(sd->length - 1)) {
-                    sample = src[sd->length - 1];
-                } else {
-                    double frac = pos - (double)idx;
-                    float a = src[idx];
-                    float b = src[idx + 1];
-                    sample = (float)(a + (b - a) * frac);
-                }
-                dst[i] = sample;
-                pos += vr->state.sample.step;
+            for (size_t i = 0; i < frames; i += SAMPLE_MIX_CHUNK) {
+                float chunk[SAMPLE_MIX_CHUNK];
+                const size_t n = frames - i < SAMPLE_MIX_CHUNK ? frames - i : SAMPLE_MIX_CHUNK;
+                const MixTarget part = mix_target_advance(mix, i);
+                resampler_process(&vr->state.sample.rs, chunk, n);
+                mix_accumulate_target(&part, chunk, n);
             }
-            vr->state.sample.pos = pos;
             break;
-        }
-        case SEQ_SPEC_KICK: {
-            float start = vr->spec.f0 > 0.f ? vr->spec.f0 : 140.f;
-            float end = vr->spec.f1 > 0.f ? vr->spec.f1 : start * 0.35f;
-            kick_process(&vr->state.kick, &cfg, start, end, vr->duration_s, dst, frames);
+        case SEQ_SPEC_KICK:
+            kick_process_mix(&vr->state.kick, &cfg, mix, frames);
             break;
-        }
         case SEQ_SPEC_SNARE:
-            snare_process(&vr->state.snare, &cfg,
-                          vr->spec.f_const > 0.f ? vr->spec.f_const : 200.f,
-                          vr->duration_s, dst, frames);
+            snare_process_mix(&vr->state.snare, &cfg, mix, frames);
             break;
         case SEQ_SPEC_HIHAT:
-            hat_process(&vr->state.hat, &cfg, dst, frames);
+            hat_process_mix(&vr->state.hat, &cfg, mix, frames);
             break;
         case SEQ_SPEC_BASS:
-            bass_process(&vr->state.bass, &cfg, vr->spec.f_const, dst, frames);
+            bass_process_mix(&vr->state.bass, &cfg, mix, frames);
             break;
         case SEQ_SPEC_FLUTE:
-            flute_process(&vr->state.flute, &cfg, vr->spec.f_const, dst, frames);
+            flute_process_mix(&vr->state.flute, &cfg, mix, frames);
             break;
         case SEQ_SPEC_PIANO:
-            piano_process(&vr->state.piano, &cfg, vr->spec.f_const, dst, frames);
+            piano_process_mix(&vr->state.piano, &cfg, mix, frames);
             break;
         case SEQ_SPEC_GUITAR:
-            ks_process(&vr->state.karplus, &cfg, 1.0f, dst, frames);
+            ks_process_mix(&vr->state.karplus, &cfg, 1.0f, mix, frames);
             break;
         case SEQ_SPEC_EGTR:
-            egtr_process(&vr->state.egtr, &cfg, vr->spec.f_const, 3.0f, dst, frames);
+            egtr_process_mix(&vr->state.egtr, &cfg, mix, frames);
             break;
         case SEQ_SPEC_BIRDS:
-            birds_process(&vr->state.birds, &cfg, dst, frames);
+            birds_process_mix(&vr->state.birds, &cfg, mix, frames);
             break;
         case SEQ_SPEC_STRPAD:
-            strpad_process(&vr->state.strpad, &cfg, vr->spec.f_const, dst, frames);
+            strpad_process_mix(&vr->state.strpad, &cfg, mix, frames);
             break;
         case SEQ_SPEC_BELL:
-            bell_process(&vr->state.bell, &cfg, vr->spec.f_const, dst, frames);
+            bell_process_mix(&vr->state.bell, &cfg, mix, frames);
             break;
         case SEQ_SPEC_BRASS:
-            brass_process(&vr->state.brass, &cfg, vr->spec.f_const, dst, frames);
+            brass_process_mix(&vr->state.brass, &cfg, mix, frames);
             break;
         case SEQ_SPEC_KALIMBA:
-            kalimba_process(&vr->state.kalimba, &cfg, 1.0f, dst, frames);
+            kalimba_process_mix(&vr->state.kalimba, &cfg, 1.0f, mix, frames);
             break;
         case SEQ_SPEC_LASER:
-            laser_synth_process(&vr->state.laser, &cfg, dst, frames);
+            laser_synth_process_mix(&vr->state.laser, &cfg, mix, frames);
             break;
         case SEQ_SPEC_CHOIR:
-            choir_synth_process(&vr->state.choir, &cfg, 0.4f, dst, frames);
+            choir_synth_process_mix(&vr->state.choir, &cfg, mix, frames);
             break;
         case SEQ_SPEC_ANALOGLEAD:
-            analog_lead_process(&vr->state.analog, &cfg, dst, frames);
+            analog_lead_process_mix(&vr->state.analog, &cfg, mix, frames);
             break;
         case SEQ_SPEC_SIDBASS:
-            sid_bass_process(&vr->state.sid, &cfg, dst, frames);
+            sid_bass_process_mix(&vr->state.sid, &cfg, mix, frames);
             break;
         case SEQ_SPEC_CHIPARP:
-            chip_arp_process(&vr->state.chip, &cfg, dst, frames);
+            chip_arp_process_mix(&vr->state.chip, &cfg, mix, frames);
+            break;
+        case SEQ_SPEC_FM:
+            fm_process_mix(&vr->state.fm, &cfg, mix, frames);
             break;
         default:
             break;
@@ -385,74 +533,651 @@ static void voice_render_block(VoiceRuntime *vr,
     vr->rendered += frames;
 }
 
-static void build_voice_list(const SequenceDocument *doc,
-                             int sample_rate,
-                             VoiceVec *voices) {
-    for (size_t i = 0; i < doc->tone_count; ++i) {
-        const SeqToneEvent *tone = &doc->tones[i];
-        if (tone->sample_count == 0) {
-            continue;
+/*
+ * The -fade ramps over the first and last `len` frames of the mix. Voices
+ * apply them through their MixTarget gain step while they add into the
+ * buses, so the finished buses need no extra pass.
+ */
+typedef struct {
+    size_t len;
+    size_t total;
+} MixFade;
+
+static MixFade mix_fade_init(size_t total, int sample_rate, int fade_ms) {
+    MixFade fade = {0, total};
+    if (fade_ms > 0) {
+        fade.len = (size_t)((float)fade_ms / 1000.f * (float)sample_rate);
+        if (fade.len * 2 > total) {
+            fade.len = total / 2;
         }
-        VoiceRuntime vr;
-        if (!spec_is_silence(&tone->left) &&
-            voice_init(&vr, tone, &tone->left, 0, sample_rate)) {
-            voice_vec_push(voices, &vr);
+    }
+    return fade;
+}
+
+/*
+ * Bus target for a voice whose next frame lands on left[0]/right[0], bus
+ * frame `at`. *span is how many frames its gain step holds before the fade
+ * ramp changes slope.
+ */
+static MixTarget voice_mix_target(const VoiceRuntime *vr,
+                                  const MixFade *fade,
+                                  float *left,
+                                  float *right,
+                                  size_t at,
+                                  size_t *span) {
+    const size_t len = fade->len;
+    const float inv = len > 0 ? 1.0f / (float)len : 0.0f;
+    float gain = 1.0f;
+    float slope = 0.0f;
+    if (at < len) {
+        gain = (float)at * inv;
+        slope = inv;
+        *span = len - at;
+    } else if (at < fade->total - len) {
+        *span = fade->total - len - at;
+    } else {
+        gain = (float)(fade->total - 1u - at) * inv;
+        slope = -inv;
+        *span = fade->total - at;
+    }
+    MixTarget t = mix_target_stereo(left, right, vr->gain);
+    for (int c = 0; c < 2; ++c) {
+        t.step[c] = t.gain[c] * slope;
+        t.gain[c] *= gain;
+    }
+    return t;
+}
+
+/*
+ * Renders a voice span whose first frame lands on left[0]/right[0], bus
+ * frame `at`, split only where the fade ramp changes slope.
+ */
+static void voice_render_span(VoiceRuntime *vr,
+                              const MixFade *fade,
+                              float *left,
+                              float *right,
+                              size_t at,
+                              size_t frames,
+                              int sample_rate,
+                              size_t control_block) {
+    for (size_t done = 0; done < frames;) {
+        size_t span = 0;
+        const MixTarget part =
+            voice_mix_target(vr, fade, left + done, right + done, at + done, &span);
+        const size_t n = frames - done < span ? frames - done : span;
+        voice_render_block(vr, &part, n, sample_rate, control_block);
+        done += n;
+    }
+}
+
+/*
+ * FIXED_POINT playback mixes into Q20 (QMIX_BITS) buses. The oscillator
+ * voices (CONST, GLIDE, CHORD) render there with Q15 sines, Q15 gains and
+ * the fade as a Q31 envelope; MixTargetQ is their MixTarget.
+ */
+typedef struct {
+    int32_t *bus[2]; /* NULL keeps the voice off that bus */
+    int32_t gain[2]; /* Q15 */
+    int32_t env;     /* Q31 fade at frame 0 */
+    int32_t step;    /* Q31 fade change per frame */
+} MixTargetQ;
+
+static inline void mix_target_q_add(const MixTargetQ *t, size_t i, int32_t wave) {
+    const int32_t env = t->env + t->step * (int32_t)i;
+    for (int c = 0; c < 2; ++c) {
+        if (t->bus[c]) {
+            t->bus[c][i] += q_mul(env, (wave * t->gain[c]) >> 15, 31 + 15 - QMIX_BITS);
         }
-        bool needs_right = tone->stereo || tone->left.type != tone->right.type;
-        if (needs_right && !spec_is_silence(&tone->right) &&
-            voice_init(&vr, tone, &tone->right, 1, sample_rate)) {
-            voice_vec_push(voices, &vr);
+    }
+}
+
+static bool voice_is_integer(const VoiceRuntime *vr) {
+    return !vr->baked && (vr->spec.type == SEQ_SPEC_CONST || vr->spec.type == SEQ_SPEC_GLIDE ||
+                          vr->spec.type == SEQ_SPEC_CHORD);
+}
+
+/* voice_mix_target() for the Q20 buses. */
+static MixTargetQ voice_mix_target_q(const VoiceRuntime *vr,
+                                     const MixFade *fade,
+                                     int32_t *left,
+                                     int32_t *right,
+                                     size_t at,
+                                     size_t *span) {
+    const size_t len = fade->len;
+    const int32_t inv = len > 0 ? (int32_t)(Q31_ONE / (int64_t)len) : 0;
+    MixTargetQ t = {{left, right}, {0, 0}, Q31_ONE, 0};
+    if (at < len) {
+        t.env = (int32_t)((int64_t)at * inv);
+        t.step = inv;
+        *span = len - at;
+    } else if (at < fade->total - len) {
+        *span = fade->total - len - at;
+    } else {
+        t.env = (int32_t)((int64_t)(fade->total - 1u - at) * inv);
+        t.step = -inv;
+        *span = fade->total - at;
+    }
+    for (int c = 0; c < 2; ++c) {
+        t.gain[c] = q_from_float(vr->gain[c], 15);
+        if (t.gain[c] == 0) {
+            t.bus[c] = NULL;
+        }
+    }
+    return t;
+}
+
+/* voice_render_block() for the voices voice_is_integer() accepts. */
+static void voice_render_block_q(VoiceRuntime *vr,
+                                 const MixTargetQ *mix,
+                                 size_t frames,
+                                 size_t control_block) {
+    switch (vr->spec.type) {
+        case SEQ_SPEC_CONST: {
+            uint32_t phase = vr->state.osc.phase;
+            const uint32_t inc = vr->state.osc.inc;
+            for (size_t i = 0; i < frames; ++i) {
+                phase += inc;
+                mix_target_q_add(mix, i, osc_sine_q15(phase));
+            }
+            vr->state.osc.phase = phase;
+            break;
+        }
+        case SEQ_SPEC_GLIDE: {
+            /* the increment moves linearly from start_inc to end_inc, like the float frequency */
+            const size_t block = control_block_size(control_block);
+            const int64_t span = vr->total_samples > 1 ? (int64_t)vr->total_samples - 1 : 1;
+            const int64_t delta =
+                (int64_t)vr->state.glide.end_inc - (int64_t)vr->state.glide.start_inc;
+            uint32_t phase = vr->state.glide.phase;
+            uint32_t inc = vr->state.glide.inc;
+            for (size_t i = 0; i < frames;) {
+                const size_t n = control_span(block, frames - i);
+                const int64_t pos = (int64_t)(vr->rendered + i + n - 1);
+                const uint32_t next_inc =
+                    (uint32_t)((int64_t)vr->state.glide.start_inc + delta * pos / span);
+                const int32_t step = control_inc_step(inc, next_inc, n);
+                for (size_t k = 0; k < n; ++k, ++i) {
+                    inc += (uint32_t)step;
+                    phase += inc;
+                    mix_target_q_add(mix, i, osc_sine_q15(phase));
+                }
+                inc = next_inc;
+            }
+            vr->state.glide.phase = phase;
+            vr->state.glide.inc = inc;
+            break;
         }
+        case SEQ_SPEC_CHORD: {
+            const int count = vr->state.chord_q.count;
+            const int32_t gain = vr->state.chord_q.gain;
+            uint32_t *phase = vr->state.chord_q.phase;
+            const uint32_t *inc = vr->state.chord_q.inc;
+            for (size_t i = 0; i < frames; ++i) {
+                int32_t wave = 0;
+                for (int h = 0; h < count; ++h) {
+                    phase[h] += inc[h];
+                    wave += (osc_sine_q15(phase[h]) * gain) >> 15;
+                }
+                mix_target_q_add(mix, i, wave);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    vr->rendered += frames;
+}
+
+/* voice_render_span() for the Q20 buses. */
+static void voice_render_span_q(VoiceRuntime *vr,
+                                const MixFade *fade,
+                                int32_t *left,
+                                int32_t *right,
+                                size_t at,
+                                size_t frames,
+                                size_t control_block) {
+    for (size_t done = 0; done < frames;) {
+        size_t span = 0;
+        const MixTargetQ part =
+            voice_mix_target_q(vr, fade, left + done, right + done, at + done, &span);
+        const size_t n = frames - done < span ? frames - done : span;
+        voice_render_block_q(vr, &part, n, control_block);
+        done += n;
     }
 }
 
-static void apply_fade(float *buf, size_t frames, int sr, int fade_ms) {
-    if (fade_ms <= 0) {
+static void add_tone_voices(const SeqToneEvent *tone,
+                            const SequenceOptions *opts,
+                            DelayPool *lines,
+                            bool fixed,
+                            VoiceVec *voices) {
+    if (tone->sample_count == 0) {
         return;
     }
-    size_t fade = (size_t)((float)fade_ms / 1000.f * sr);
-    if (fade * 2 > frames) {
-        fade = frames / 2;
+    VoiceRuntime vr;
+    bool needs_right = tone->stereo || tone->left.type != tone->right.type;
+    float gains[2];
+    mix_pan_gains(tone->gain, tone->pan, gains);
+    if (needs_right && spec_same(&tone->left, &tone->right) &&
+        !spec_uses_noise(tone->left.type)) {
+        /* one render feeds both buses; noise voices keep independent sides */
+        if (voice_init(&vr, tone, &tone->left, gains[0], gains[1], opts, lines, fixed)) {
+            voice_vec_push(voices, &vr);
+        }
+        return;
+    }
+    if (!needs_right) {
+        gains[0] = tone->gain;
+    }
+    if (!spec_is_silence(&tone->left) &&
+        voice_init(&vr, tone, &tone->left, gains[0], 0.f, opts, lines, fixed)) {
+        voice_vec_push(voices, &vr);
+    }
+    if (needs_right && !spec_is_silence(&tone->right) &&
+        voice_init(&vr, tone, &tone->right, 0.f, gains[1], opts, lines, fixed)) {
+        voice_vec_push(voices, &vr);
+    }
+}
+
+/*
+ * Tones not yet turned into voices. An ordered document is read only as far
+ * as the block being mixed, so live voices track the polyphony rather than
+ * the length of the song; an unordered tone list is read in one go.
+ */
+typedef struct {
+    SequenceCursor cursor;
+    SeqToneEvent next;
+    bool has_next;
+    bool fixed; /* voices feed an integer mix */
+    DelayPool lines;
+} VoiceFeed;
+
+static void voice_feed_init(VoiceFeed *feed,
+                            const SequenceDocument *doc,
+                            Arena *arena,
+                            bool fixed) {
+    memset(feed, 0, sizeof(*feed));
+    feed->fixed = fixed;
+    sequence_cursor_init(&feed->cursor, doc);
+    feed->lines.arena = arena;
+    feed->has_next = sequence_cursor_next(&feed->cursor, &feed->next);
+}
+
+/* Adds the voices of every tone that starts before `end`. */
+static void voice_feed_until(VoiceFeed *feed,
+                             size_t end,
+                             const SequenceOptions *opts,
+                             VoiceVec *voices) {
+    while (feed->has_next && (!feed->cursor.ordered || feed->next.start_sample < end)) {
+        add_tone_voices(&feed->next, opts, &feed->lines, feed->fixed, voices);
+        feed->has_next = sequence_cursor_next(&feed->cursor, &feed->next);
+    }
+}
+
+/* Drops finished voices, keeping the rest in order so the mix sums the same way. */
+static void voice_vec_retire(VoiceVec *voices, DelayPool *lines) {
+    size_t kept = 0;
+    for (size_t v = 0; v < voices->len; ++v) {
+        VoiceRuntime *vr = &voices->items[v];
+        if (vr->rendered < vr->total_samples) {
+            if (kept != v) {
+                voices->items[kept] = *vr;
+            }
+            ++kept;
+            continue;
+        }
+        const KarplusStrongState *ks = NULL;
+        if (!vr->baked && vr->spec.type == SEQ_SPEC_GUITAR) {
+            ks = &vr->state.karplus;
+        } else if (!vr->baked && vr->spec.type == SEQ_SPEC_KALIMBA) {
+            ks = &vr->state.kalimba.ks;
+        }
+        if (ks && ks->delay_line) {
+            delay_line_give(lines, ks->delay_line, (size_t)ks->mask + 1u);
+        }
     }
-    for (size_t i = 0; i < fade; ++i) {
-        float g = (float)i / (float)fade;
-        buf[i] *= g;
-        buf[frames - 1 - i] *= g;
+    voices->len = kept;
+}
+
+/* Optional Butterworth high-/low-pass over the finished buses, both in one lane group. */
+static void apply_bus_filters(float *left, float *right, size_t frames,
+                              const SequenceOptions *opts) {
+    const float sr = (float)opts->sample_rate;
+    const float cutoffs[2] = {opts->bus_highpass_hz, opts->bus_lowpass_hz};
+    const FilterMode modes[2] = {FILTER_HIGHPASS, FILTER_LOWPASS};
+    float *bufs[2] = {left, right};
+    for (int m = 0; m < 2; ++m) {
+        if (cutoffs[m] <= 0.0f) {
+            continue;
+        }
+        const BiquadCoeffs c = biquad_design(modes[m], cutoffs[m], 0.7071f, sr);
+        Biquad filters[2];
+        biquad_init(&filters[0], c);
+        biquad_init(&filters[1], c);
+        Biquad *const lanes[2] = {&filters[0], &filters[1]};
+        biquad_bank_process(lanes, bufs, 2, frames);
     }
 }
 
-static size_t ensure_minimum_tail(float **left,
-                                  float **right,
-                                  size_t current,
-                                  int sample_rate) {
-    const float min_ms = 250.f; /* keep device awake for short bursts */
+/* apply_bus_filters() on the Q20 buses of a fixed-point mix. */
+static void apply_bus_filters_q(int32_t *left, int32_t *right, size_t frames,
+                                const SequenceOptions *opts) {
+    const float sr = (float)opts->sample_rate;
+    const float cutoffs[2] = {opts->bus_highpass_hz, opts->bus_lowpass_hz};
+    const FilterMode modes[2] = {FILTER_HIGHPASS, FILTER_LOWPASS};
+    int32_t *bufs[2] = {left, right};
+    for (int m = 0; m < 2; ++m) {
+        if (cutoffs[m] <= 0.0f) {
+            continue;
+        }
+        const BiquadCoeffs c = biquad_design(modes[m], cutoffs[m], 0.7071f, sr);
+        for (int ch = 0; ch < 2; ++ch) {
+            BiquadQ f;
+            biquad_q_init(&f, c);
+            biquad_q_process(&f, bufs[ch], frames);
+        }
+    }
+}
+
+/* Frames to play: the mix padded with silence so short bursts keep the device awake. */
+static size_t minimum_tail_frames(size_t current, int sample_rate) {
+    const float min_ms = 250.f;
     size_t min_samples = (size_t)((min_ms / 1000.f) * (float)sample_rate);
     if (min_samples < MIX_BLOCK) {
         min_samples = MIX_BLOCK;
     }
-    if (current >= min_samples) {
-        return current;
+    return current >= min_samples ? current : min_samples;
+}
+
+/*
+ * Voice banks: voices of the bankable types that cover a whole mix block are
+ * grouped per SeqSpecType and rendered by one structure-of-arrays kernel call
+ * instead of one switch and kernel call per voice.
+ */
+#define VOICE_BANK_MAX 16
+
+typedef struct {
+    VoiceRuntime *voices[VOICE_BANK_MAX];
+    size_t count;
+} VoiceBank;
+
+enum {
+    BANK_CONST,
+    BANK_CHORD,
+    BANK_BASS,
+    BANK_FLUTE,
+    BANK_ANALOGLEAD,
+    BANK_SIDBASS,
+    BANK_PLUCK,
+    BANK_FM,
+    BANK_COUNT
+};
+
+static int voice_bank_index(SeqSpecType type) {
+    switch (type) {
+        case SEQ_SPEC_CONST:
+            return BANK_CONST;
+        case SEQ_SPEC_CHORD:
+            return BANK_CHORD;
+        case SEQ_SPEC_BASS:
+            return BANK_BASS;
+        case SEQ_SPEC_FLUTE:
+            return BANK_FLUTE;
+        case SEQ_SPEC_ANALOGLEAD:
+            return BANK_ANALOGLEAD;
+        case SEQ_SPEC_SIDBASS:
+            return BANK_SIDBASS;
+        case SEQ_SPEC_GUITAR:
+        case SEQ_SPEC_KALIMBA:
+            return BANK_PLUCK;
+        case SEQ_SPEC_FM:
+            return BANK_FM;
+        default:
+            return -1;
+    }
+}
+
+static void const_bank_render(VoiceRuntime *const *voices,
+                              size_t count,
+                              const MixTarget *mixes,
+                              size_t frames) {
+    uint32_t phases[VOICE_BANK_MAX];
+    uint32_t incs[VOICE_BANK_MAX];
+    for (size_t v = 0; v < count; ++v) {
+        phases[v] = voices[v]->state.osc.phase;
+        incs[v] = voices[v]->state.osc.inc;
+    }
+    osc_sine_bank_mix(phases, incs, mixes, count, frames);
+    for (size_t v = 0; v < count; ++v) {
+        voices[v]->state.osc.phase = phases[v];
+    }
+}
+
+static void voice_bank_render(int bank,
+                              VoiceRuntime *const *voices,
+                              size_t count,
+                              const SynthBlockConfig *cfg,
+                              const MixTarget *mixes,
+                              size_t frames) {
+    void *states[VOICE_BANK_MAX];
+    for (size_t v = 0; v < count; ++v) {
+        VoiceRuntime *vr = voices[v];
+        switch (bank) {
+            case BANK_CHORD:
+                states[v] = &vr->state.chord;
+                break;
+            case BANK_BASS:
+                states[v] = &vr->state.bass;
+                break;
+            case BANK_FLUTE:
+                states[v] = &vr->state.flute;
+                break;
+            case BANK_ANALOGLEAD:
+                states[v] = &vr->state.analog;
+                break;
+            case BANK_SIDBASS:
+                states[v] = &vr->state.sid;
+                break;
+            case BANK_PLUCK:
+                states[v] = vr->spec.type == SEQ_SPEC_KALIMBA ? (void *)&vr->state.kalimba.ks
+                                                              : (void *)&vr->state.karplus;
+                break;
+            case BANK_FM:
+                states[v] = &vr->state.fm;
+                break;
+            default:
+                states[v] = NULL;
+                break;
+        }
+    }
+    switch (bank) {
+        case BANK_CONST:
+            const_bank_render(voices, count, mixes, frames);
+            break;
+        case BANK_CHORD:
+            partial_bank_process_multi_mix((PartialBank *const *)states, count, mixes, frames);
+            break;
+        case BANK_BASS:
+            bass_bank_process_mix((BassState *const *)states, count, cfg, mixes, frames);
+            break;
+        case BANK_FLUTE:
+            flute_bank_process_mix((FluteState *const *)states, count, cfg, mixes, frames);
+            break;
+        case BANK_ANALOGLEAD:
+            analog_lead_bank_process_mix((AnalogLeadState *const *)states, count, cfg, mixes,
+                                         frames);
+            break;
+        case BANK_SIDBASS:
+            sid_bass_bank_process_mix((SidBassState *const *)states, count, cfg, mixes, frames);
+            break;
+        case BANK_PLUCK:
+            ks_bank_process_mix((KarplusStrongState *const *)states, count, cfg, 1.0f, mixes,
+                                frames);
+            break;
+        case BANK_FM:
+            fm_bank_process_mix((FmState *const *)states, count, cfg, mixes, frames);
+            break;
+        default:
+            break;
+    }
+}
+
+static void voice_bank_flush(VoiceBank *bank,
+                             int index,
+                             const SynthBlockConfig *cfg,
+                             const MixFade *fade,
+                             float *left,
+                             float *right,
+                             size_t at,
+                             size_t frames) {
+    if (bank->count == 0) {
+        return;
+    }
+    MixTarget mixes[VOICE_BANK_MAX];
+    bool one_ramp = bank->count > 1;
+    for (size_t b = 0; b < bank->count; ++b) {
+        size_t span = 0;
+        mixes[b] = voice_mix_target(bank->voices[b], fade, left, right, at, &span);
+        one_ramp = one_ramp && span >= frames;
+    }
+    if (!one_ramp) {
+        /* a lone voice is cheaper through its scalar kernel, and a fade edge splits the block */
+        for (size_t b = 0; b < bank->count; ++b) {
+            voice_render_span(bank->voices[b], fade, left, right, at, frames,
+                              (int)cfg->sample_rate, cfg->control_block);
+        }
+        bank->count = 0;
+        return;
+    }
+    voice_bank_render(index, bank->voices, bank->count, cfg, mixes, frames);
+    for (size_t b = 0; b < bank->count; ++b) {
+        bank->voices[b]->rendered += frames;
+    }
+    bank->count = 0;
+}
+
+static float voice_peak_gain(const VoiceRuntime *vr) {
+    return vr->gain[0] > vr->gain[1] ? vr->gain[0] : vr->gain[1];
+}
+
+/*
+ * Applies the governor's cheaper variants to a voice about to start. Returns
+ * false when the voice is culled; `loudest` is the peak gain of the voices
+ * that sounded in the previous block.
+ */
+static bool voice_govern(VoiceRuntime *vr, QualityGovernor *gov, float loudest) {
+    if (governor_at(gov, GOVERNOR_CULL) &&
+        voice_peak_gain(vr) < GOVERNOR_CULL_RATIO * loudest) {
+        vr->rendered = vr->total_samples;
+        ++gov->culled;
+        return false;
+    }
+    if (vr->baked) {
+        return true;
+    }
+    if (governor_at(gov, GOVERNOR_FEWER_PARTIALS)) {
+        /*
+         * Halves the lane groups, rounded up, so every cut saves lane updates:
+         * CHOIR 5 -> 4 drops its formant and a group; PIANO and STRPAD fit in
+         * one group and keep all partials.
+         */
+        PartialBank *bank = NULL;
+        switch (vr->spec.type) {
+            case SEQ_SPEC_CHOIR:
+                bank = &vr->state.choir.partials;
+                break;
+            case SEQ_SPEC_STRPAD:
+                bank = &vr->state.strpad.partials;
+                break;
+            case SEQ_SPEC_PIANO:
+                bank = &vr->state.piano.partials;
+                break;
+            default:
+                break;
+        }
+        if (bank != NULL && bank->count > PARTIAL_BANK_WIDTH) {
+            const size_t groups = (bank->count + PARTIAL_BANK_WIDTH - 1u) / PARTIAL_BANK_WIDTH;
+            partial_bank_truncate(bank, (groups + 1u) / 2u * PARTIAL_BANK_WIDTH);
+        }
+    }
+    if (governor_at(gov, GOVERNOR_LINEAR_RESAMPLE) && vr->spec.type == SEQ_SPEC_SAMPLE &&
+        vr->state.sample.direct == NULL) {
+        resampler_set_quality(&vr->state.sample.rs, RESAMPLE_LINEAR);
+    }
+    return true;
+}
+
+/* Adds a block of float voice output to the Q20 buses and clears it for the next block. */
+static void mix_fold_q(int32_t *qleft,
+                       int32_t *qright,
+                       float *left,
+                       float *right,
+                       size_t frames) {
+    for (size_t i = 0; i < frames; ++i) {
+        qleft[i] += q_from_float(left[i], QMIX_BITS);
+        qright[i] += q_from_float(right[i], QMIX_BITS);
     }
-    size_t padded = min_samples;
-    *left = xrealloc(*left, padded * sizeof(float));
-    *right = xrealloc(*right, padded * sizeof(float));
-    memset(*left + current, 0, (padded - current) * sizeof(float));
-    memset(*right + current, 0, (padded - current) * sizeof(float));
-    return padded;
+    memset(left, 0, frames * sizeof(float));
+    memset(right, 0, frames * sizeof(float));
 }
 
-static size_t mix_offline(const VoiceVec *voices,
-                        const SequenceDocument *doc,
-                        const SequenceOptions *opts,
-                        float **out_left,
-                        float **out_right) {
+/*
+ * Voices add straight into the left/right buses through their MixTarget, so
+ * no per-voice scratch buffer is cleared, written and read back. With a
+ * governor budget set, each block is timed and the governor's level picks
+ * the variants of the voices that start next.
+ *
+ * A fixed feed fills the Q20 out_qleft and out_qright buses instead: oscillator voices
+ * add there directly, the float instrument kernels add into one block of
+ * float scratch that is folded into the Q20 buses once per block.
+ */
+static size_t mix_offline(VoiceVec *voices,
+                          VoiceFeed *feed,
+                          const SequenceDocument *doc,
+                          const SequenceOptions *opts,
+                          float **out_left,
+                          float **out_right,
+                          int32_t **out_qleft,
+                          int32_t **out_qright) {
     size_t total = doc->total_samples;
-    float *left = xcalloc(total, sizeof(float));
-    float *right = xcalloc(total, sizeof(float));
-    float *temp = xmalloc(MIX_BLOCK * sizeof(float));
+    const bool fixed = feed->fixed;
+    float *left = NULL;
+    float *right = NULL;
+    int32_t *qleft = NULL;
+    int32_t *qright = NULL;
+    float scratch[2][MIX_BLOCK];
+    if (fixed) {
+        qleft = xcalloc(total, sizeof(int32_t));
+        qright = xcalloc(total, sizeof(int32_t));
+        memset(scratch, 0, sizeof(scratch));
+    } else {
+        left = xcalloc(total, sizeof(float));
+        right = xcalloc(total, sizeof(float));
+    }
+    const MixFade fade = mix_fade_init(total, opts->sample_rate, opts->fade_ms);
+    VoiceBank banks[BANK_COUNT] = {{{0}, 0}};
+    QualityGovernor gov;
+    governor_init(&gov, opts->governor_budget, opts->sample_rate);
+    float loudest = 0.f;
 
     for (size_t frame = 0; frame < total; frame += MIX_BLOCK) {
         size_t frames = (frame + MIX_BLOCK > total) ? (total - frame) : MIX_BLOCK;
+        governor_block_begin(&gov);
+        voice_feed_until(feed, frame + frames, opts, voices);
+        size_t control_block = (size_t)opts->control_block;
+        if (governor_at(&gov, GOVERNOR_SLOW_CONTROL)) {
+            control_block =
+                control_block_size(control_block_size(control_block) * GOVERNOR_CONTROL_FACTOR);
+        }
+        SynthBlockConfig cfg = {
+            .sample_rate = (float)opts->sample_rate,
+            .block_duration = (float)frames / (float)opts->sample_rate,
+            .control_block = control_block,
+        };
+        float *bl = fixed ? scratch[0] : left + frame;
+        float *br = fixed ? scratch[1] : right + frame;
+        bool float_voices = false;
+        float block_loudest = 0.f;
         for (size_t v = 0; v < voices->len; ++v) {
             VoiceRuntime *vr = &voices->items[v];
             if (vr->rendered >= vr->total_samples) {
@@ -464,6 +1189,13 @@ static size_t mix_offline(const VoiceVec *voices,
             if (voice_end <= frame || voice_start >= block_end) {
                 continue;
             }
+            if (vr->rendered == 0 && gov.level != GOVERNOR_FULL &&
+                !voice_govern(vr, &gov, loudest)) {
+                continue;
+            }
+            if (voice_peak_gain(vr) > block_loudest) {
+                block_loudest = voice_peak_gain(vr);
+            }
             size_t offset = 0;
             if (voice_start > frame) {
                 offset = voice_start - frame;
@@ -473,38 +1205,46 @@ static size_t mix_offline(const VoiceVec *voices,
             if (to_render > available) {
                 to_render = available;
             }
-            voice_render_block(vr, temp, to_render, opts->sample_rate);
-            float *dest = (vr->channel == 0 ? left : right) + frame + offset;
-            for (size_t i = 0; i < to_render; ++i) {
-                dest[i] += temp[i];
+            if (fixed && voice_is_integer(vr)) {
+                voice_render_span_q(vr, &fade, qleft + frame + offset, qright + frame + offset,
+                                    frame + offset, to_render, control_block);
+                continue;
+            }
+            float_voices = true;
+            const int bank = voice_bank_index(vr->spec.type);
+            if (bank >= 0 && offset == 0 && to_render == frames) {
+                VoiceBank *vb = &banks[bank];
+                vb->voices[vb->count++] = vr;
+                if (vb->count == VOICE_BANK_MAX) {
+                    voice_bank_flush(vb, bank, &cfg, &fade, bl, br, frame, frames);
+                }
+                continue;
             }
+            voice_render_span(vr, &fade, bl + offset, br + offset, frame + offset, to_render,
+                              opts->sample_rate, control_block);
+        }
+        for (int b = 0; b < BANK_COUNT; ++b) {
+            voice_bank_flush(&banks[b], b, &cfg, &fade, bl, br, frame, frames);
         }
+        if (fixed && float_voices) {
+            mix_fold_q(qleft + frame, qright + frame, bl, br, frames);
+        }
+        loudest = block_loudest;
+        voice_vec_retire(voices, &feed->lines);
+        governor_block_end(&gov, frames);
     }
+    governor_report(&gov);
 
-    apply_fade(left, total, opts->sample_rate, opts->fade_ms);
-    apply_fade(right, total, opts->sample_rate, opts->fade_ms);
-
-    free(temp);
-    *out_left = left;
-    *out_right = right;
-    return total;
-}
-
-static void clamp_and_interleave(int16_t *dst,
-                                 const float *L,
-                                 const float *R,
-                                 size_t n,
-                                 float gain) {
-    for (size_t i = 0; i < n; ++i) {
-        float l = L[i] * gain;
-        float r = R[i] * gain;
-        if (l > 1.f) l = 1.f;
-        if (l < -1.f) l = -1.f;
-        if (r > 1.f) r = 1.f;
-        if (r < -1.f) r = -1.f;
-        dst[2 * i] = (int16_t)lrintf(l * 32767.f);
-        dst[2 * i + 1] = (int16_t)lrintf(r * 32767.f);
+    if (fixed) {
+        apply_bus_filters_q(qleft, qright, total, opts);
+        *out_qleft = qleft;
+        *out_qright = qright;
+    } else {
+        apply_bus_filters(left, right, total, opts);
+        *out_left = left;
+        *out_right = right;
     }
+    return total;
 }
 
 static int64_t now_ms(void) {
@@ -568,27 +1308,30 @@ static void launch_espeak_event(const SeqSpeechEvent *ev, const char *espeak_bin
     }
 }
 
-static int play_with_openal(const float *L,
-                            const float *R,
+void scheduler_interleave_q15(int16_t *pcm,
+                              const int32_t *left,
+                              const int32_t *right,
+                              size_t frames,
+                              float gain) {
+    const int32_t qgain = q_from_float(gain, 15);
+    for (size_t i = 0; i < frames; ++i) {
+        pcm[2 * i] = q15_saturate(q_mul(left[i], qgain, QMIX_BITS));
+        pcm[2 * i + 1] = q15_saturate(q_mul(right[i], qgain, QMIX_BITS));
+    }
+}
+
+static int play_with_openal(const int16_t *pcm,
                             size_t total_samples,
-                            float gain,
                             int sr,
                             const SequenceDocument *doc,
                             const char *espeak_bin) {
     if (total_samples == 0) {
         return 0;
     }
-    int16_t *pcm = malloc(total_samples * 2 * sizeof(int16_t));
-    if (!pcm) {
-        fprintf(stderr, "synthrave: cannot allocate pcm buffer\n");
-        return 1;
-    }
-    clamp_and_interleave(pcm, L, R, total_samples, gain);
 
     ALCdevice *dev = alcOpenDevice(NULL);
     if (!dev) {
         fprintf(stderr, "synthrave: alcOpenDevice failed\n");
-        free(pcm);
         return 1;
     }
     ALCcontext *ctx = alcCreateContext(dev, NULL);
@@ -598,7 +1341,6 @@ static int play_with_openal(const float *L,
             alcDestroyContext(ctx);
         }
         alcCloseDevice(dev);
-        free(pcm);
         return 1;
     }
 
@@ -634,10 +1376,63 @@ static int play_with_openal(const float *L,
     alcMakeContextCurrent(NULL);
     alcDestroyContext(ctx);
     alcCloseDevice(dev);
-    free(pcm);
     return 0;
 }
 
+static size_t render_document(const SequenceDocument *doc,
+                              const SequenceOptions *opts,
+                              bool fixed,
+                              float **out_left,
+                              float **out_right,
+                              int32_t **out_qleft,
+                              int32_t **out_qright) {
+    DenormalMode fp_mode;
+    denormal_protect_begin(&fp_mode);
+    VoiceVec voices = {0};
+    Arena arena;
+    arena_init(&arena, 0);
+    VoiceFeed feed;
+    voice_feed_init(&feed, doc, &arena, fixed);
+    /* read up to the first playable tone; a document without one renders nothing */
+    while (voices.len == 0 && feed.has_next) {
+        voice_feed_until(&feed, feed.next.start_sample + 1u, opts, &voices);
+    }
+    size_t total = 0;
+    if (voices.len > 0) {
+        total = mix_offline(&voices, &feed, doc, opts, out_left, out_right, out_qleft,
+                            out_qright);
+    }
+    sequence_cursor_free(&feed.cursor);
+    free(voices.items);
+    arena_free(&arena);
+    denormal_protect_end(&fp_mode);
+    return total;
+}
+
+size_t scheduler_render_document(const SequenceDocument *doc,
+                                 const SequenceOptions *opts,
+                                 float **out_left,
+                                 float **out_right) {
+    if (!doc || !opts || !out_left || !out_right) {
+        return 0;
+    }
+    *out_left = NULL;
+    *out_right = NULL;
+    return render_document(doc, opts, false, out_left, out_right, NULL, NULL);
+}
+
+size_t scheduler_render_document_q(const SequenceDocument *doc,
+                                   const SequenceOptions *opts,
+                                   int32_t **out_left,
+                                   int32_t **out_right) {
+    if (!doc || !opts || !out_left || !out_right) {
+        return 0;
+    }
+    *out_left = NULL;
+    *out_right = NULL;
+    return render_document(doc, opts, true, NULL, NULL, out_left, out_right);
+}
+
 int scheduler_play_document(const SequenceDocument *doc,
                             const SequenceOptions *opts,
                             float gain,
@@ -645,18 +1440,18 @@ int scheduler_play_document(const SequenceDocument *doc,
     if (!doc || !opts) {
         return 1;
     }
-    VoiceVec voices = {0};
-    build_voice_list(doc, opts->sample_rate, &voices);
-
+#if SYNTHRAVE_FIXED_POINT
+    int32_t *left = NULL;
+    int32_t *right = NULL;
+    const size_t rendered = scheduler_render_document_q(doc, opts, &left, &right);
+#else
     float *left = NULL;
     float *right = NULL;
-    size_t total_samples = doc->total_samples;
-    if (voices.len > 0) {
-        total_samples = mix_offline(&voices, doc, opts, &left, &right);
-        total_samples = ensure_minimum_tail(&left, &right, total_samples,
-                                            opts->sample_rate);
-    } else {
-        size_t total = total_samples;
+    const size_t rendered = scheduler_render_document(doc, opts, &left, &right);
+#endif
+    size_t total = rendered;
+    if (rendered == 0) {
+        total = doc->total_samples;
         if (total == 0) {
             total = (size_t)((float)opts->sample_rate *
                              (opts->default_duration_ms / 1000.f));
@@ -666,20 +1461,28 @@ int scheduler_play_document(const SequenceDocument *doc,
         }
         if (doc->speech_count == 0) {
             fprintf(stderr, "synthrave: no playable voices\n");
-            free(voices.items);
             return 1;
         }
-        left = xcalloc(total, sizeof(float));
-        right = xcalloc(total, sizeof(float));
-        total_samples = ensure_minimum_tail(&left, &right, total,
-                                            opts->sample_rate);
     }
-    free(voices.items);
-
-    int rc = play_with_openal(left, right, total_samples, gain,
-                              opts->sample_rate, doc, espeak_bin);
-
+    total = minimum_tail_frames(total, opts->sample_rate);
+    int16_t *pcm = calloc(total * 2u, sizeof(int16_t));
+    if (!pcm) {
+        fprintf(stderr, "synthrave: cannot allocate pcm buffer\n");
+        free(left);
+        free(right);
+        return 1;
+    }
+    if (rendered > 0) {
+#if SYNTHRAVE_FIXED_POINT
+        scheduler_interleave_q15(pcm, left, right, rendered, gain);
+#else
+        mix_interleave_s16(pcm, left, right, rendered, gain);
+#endif
+    }
     free(left);
     free(right);
+
+    int rc = play_with_openal(pcm, total, opts->sample_rate, doc, espeak_bin);
+    free(pcm);
     return rc;
 }
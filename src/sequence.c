@@ -1,6 +1,9 @@
 #define _GNU_SOURCE
 #include "sequence.h"
 
+#include "arena.h"
+#include "fm_patch.h"
+
 #include <ctype.h>
 #include <errno.h>
 #include <math.h>
@@ -9,15 +12,34 @@
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+/* Chunk size of the per-load arena; large files take a handful of chunks. */
+#define LOAD_ARENA_CHUNK (256u * 1024u)
+/* The timeline takes roughly this many bytes per source byte. */
+#define TIMELINE_BYTES_PER_SOURCE 32u
+#define TIMELINE_CHUNK_MIN (4u * 1024u)
+/* Initial buffer for sources that cannot be mapped; doubles as it fills. */
+#define READ_FILE_CHUNK (64u * 1024u)
+
+/* Non-owning slice of the source text; ptr is NULL for an absent field. */
+typedef struct {
+    const char *ptr;
+    size_t len;
+} StrView;
+
+/* Fields are views into the mapped file (or the token strings), not copies. */
 typedef struct {
-    char *cols[5];
+    StrView cols[5];
 } CsvRow;
 
 typedef struct {
@@ -26,15 +48,23 @@ typedef struct {
     size_t cap;
 } CsvRowVec;
 
+typedef struct TimelineNode TimelineNode;
+
 typedef struct {
-    char *name;
+    StrView name;
+    uint32_t hash; /* name_hash of the name, case-folded */
     CsvRowVec rows;
+    TimelineNode *node; /* folded body, built on the first call */
+    int height;         /* deepest macro nesting below and including this one */
 } MacroDef;
 
+/* Definitions in file order plus an open-addressing index over them. */
 typedef struct {
     MacroDef *items;
     size_t len;
     size_t cap;
+    uint32_t *slots; /* item index + 1, 0 = empty; power-of-two size */
+    size_t slot_count;
 } MacroVec;
 
 typedef struct {
@@ -49,17 +79,27 @@ typedef struct {
     size_t cap;
 } SpeechVec;
 
+/*
+ * Sample cache: open addressing keyed by (path, rate). Each file is stored
+ * once under its realpath; other spellings of the same file get alias
+ * entries that share the data, so repeat lookups skip realpath().
+ */
 typedef struct {
     char *path;
-    SampleData data;
+    uint32_t hash;
+    int rate;
+    bool owner; /* frees data on clear; aliases do not */
+    SampleData *data;
 } SampleCacheEntry;
 
-static SampleCacheEntry *sample_cache = NULL;
+static SampleCacheEntry *sample_cache = NULL; /* power-of-two slots, path NULL = empty */
 static size_t sample_cache_len = 0;
 static size_t sample_cache_cap = 0;
 static uint32_t noise_state = 0x12345678u;
+static SequenceLoadStats load_stats;
 
 static void *xcalloc(size_t n, size_t sz) {
+    ++load_stats.allocations;
     void *ptr = calloc(n, sz);
     if (!ptr) {
         fprintf(stderr, "synthrave: out of memory\n");
@@ -69,6 +109,7 @@ static void *xcalloc(size_t n, size_t sz) {
 }
 
 static void *xmalloc(size_t sz) {
+    ++load_stats.allocations;
     void *ptr = malloc(sz);
     if (!ptr) {
         fprintf(stderr, "synthrave: out of memory\n");
@@ -78,6 +119,7 @@ static void *xmalloc(size_t sz) {
 }
 
 static void *xrealloc(void *ptr, size_t sz) {
+    ++load_stats.allocations;
     void *out = realloc(ptr, sz);
     if (!out && sz != 0) {
         fprintf(stderr, "synthrave: out of memory\n");
@@ -86,6 +128,13 @@ static void *xrealloc(void *ptr, size_t sz) {
     return out;
 }
 
+static char *arena_strdup(Arena *arena, const char *s) {
+    size_t len = strlen(s);
+    char *dup = arena_alloc(arena, len + 1);
+    memcpy(dup, s, len + 1);
+    return dup;
+}
+
 static char *xstrdup(const char *s) {
     if (!s) {
         return NULL;
@@ -105,18 +154,30 @@ static void sample_data_free(SampleData *sd) {
     if (!sd) {
         return;
     }
-    free(sd->chan[0]);
-    free(sd->chan[1]);
-    sd->chan[0] = sd->chan[1] = NULL;
+    for (int c = 0; c < 2; ++c) {
+        if (sd->rate_chan[c] != sd->chan[c]) {
+            free(sd->rate_chan[c]);
+        }
+        free(sd->chan[c]);
+        sd->chan[c] = sd->rate_chan[c] = NULL;
+    }
     sd->channels = 0;
     sd->length = 0;
     sd->sample_rate = 0;
+    sd->rate_length = 0;
+    sd->rate = 0;
 }
 
 void sample_cache_clear(void) {
-    for (size_t i = 0; i < sample_cache_len; ++i) {
+    for (size_t i = 0; i < sample_cache_cap; ++i) {
+        if (!sample_cache[i].path) {
+            continue;
+        }
         free(sample_cache[i].path);
-        sample_data_free(&sample_cache[i].data);
+        if (sample_cache[i].owner) {
+            sample_data_free(sample_cache[i].data);
+            free(sample_cache[i].data);
+        }
     }
     free(sample_cache);
     sample_cache = NULL;
@@ -197,17 +258,50 @@ static char *collect_field(const char *start, size_t len) {
     return buf;
 }
 
-static bool string_is_numeric(const char *s) {
-    if (!s || *s == '\0') {
+static StrView view_trim(StrView v) {
+    while (v.len > 0 && isspace((unsigned char)v.ptr[0])) {
+        v.ptr++;
+        v.len--;
+    }
+    while (v.len > 0 && isspace((unsigned char)v.ptr[v.len - 1])) {
+        v.len--;
+    }
+    return v;
+}
+
+static bool view_starts_with(StrView v, const char *prefix) {
+    const size_t n = strlen(prefix);
+    return v.len >= n && memcmp(v.ptr, prefix, n) == 0;
+}
+
+/* Present and non-empty, like `s && *s` for the old string fields. */
+static bool view_set(StrView v) {
+    return v.ptr != NULL && v.len > 0;
+}
+
+/* Integers are short, so they parse from a stack copy. */
+static bool view_parse_int(StrView v, int *out) {
+    char buf[32];
+    if (v.ptr == NULL || v.len >= sizeof(buf)) {
+        return false;
+    }
+    memcpy(buf, v.ptr, v.len);
+    buf[v.len] = '\0';
+    return parse_int_strict(buf, out);
+}
+
+static bool string_is_numeric(StrView s) {
+    if (!view_set(s)) {
         return false;
     }
-    const char *p = s;
+    const char *p = s.ptr;
+    const char *end = s.ptr + s.len;
     if (*p == '+' || *p == '-') {
         p++;
     }
     bool has_digit = false;
     bool has_dot = false;
-    while (*p) {
+    while (p < end) {
         if (*p >= '0' && *p <= '9') {
             has_digit = true;
             p++;
@@ -227,146 +321,138 @@ static void normalize_inline_row(CsvRow *row) {
     if (!row) {
         return;
     }
-    if (row->cols[1] && *row->cols[1] && !string_is_numeric(row->cols[1])) {
-        if (!row->cols[3] || *row->cols[3] == '\0') {
+    if (view_set(row->cols[1]) && !string_is_numeric(row->cols[1])) {
+        if (!view_set(row->cols[3])) {
             row->cols[3] = row->cols[1];
-            row->cols[1] = NULL;
+            row->cols[1] = (StrView){NULL, 0};
         }
     }
-    if ((!row->cols[3] || *row->cols[3] == '\0') &&
-        row->cols[2] && *row->cols[2] && !string_is_numeric(row->cols[2])) {
+    if (!view_set(row->cols[3]) &&
+        view_set(row->cols[2]) && !string_is_numeric(row->cols[2])) {
         row->cols[3] = row->cols[2];
-        row->cols[2] = NULL;
+        row->cols[2] = (StrView){NULL, 0};
     }
 }
 
-static CsvRow csv_row_clone(const CsvRow *src) {
-    CsvRow r = {{0}};
-    for (int i = 0; i < 5; ++i) {
-        if (src->cols[i]) {
-            r.cols[i] = xstrdup(src->cols[i]);
-        }
-    }
-    return r;
-}
-
-static void csv_row_free(CsvRow *row) {
-    if (!row) {
-        return;
-    }
-    for (int i = 0; i < 5; ++i) {
-        free(row->cols[i]);
-        row->cols[i] = NULL;
-    }
+/*
+ * Load-time vectors live in the load's arena: growing one copies it into a
+ * fresh block and abandons the old one, which costs at most as much again
+ * as the final size and is released with everything else in arena_free.
+ */
+static void *arena_grow(Arena *arena, void *items, size_t len, size_t cap, size_t elem) {
+    void *grown = arena_alloc(arena, cap * elem);
+    if (len > 0) {
+        memcpy(grown, items, len * elem);
+    }
+    return grown;
 }
 
-static void csv_rowvec_push(CsvRowVec *vec, CsvRow row) {
+static void csv_rowvec_push(Arena *arena, CsvRowVec *vec, CsvRow row) {
     if (vec->len == vec->cap) {
         size_t n = vec->cap ? vec->cap * 2 : 32;
-        vec->items = xrealloc(vec->items, n * sizeof(CsvRow));
+        vec->items = arena_grow(arena, vec->items, vec->len, n, sizeof(CsvRow));
         vec->cap = n;
     }
     vec->items[vec->len++] = row;
 }
 
-static void csv_rowvec_free(CsvRowVec *vec) {
-    if (!vec) {
-        return;
+/* FNV-1a over the upper-cased bytes, so macro names match case-insensitively. */
+static uint32_t name_hash(StrView name) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < name.len; ++i) {
+        h ^= (uint32_t)toupper((unsigned char)name.ptr[i]);
+        h *= 16777619u;
     }
-    for (size_t i = 0; i < vec->len; ++i) {
-        csv_row_free(&vec->items[i]);
-    }
-    free(vec->items);
-    vec->items = NULL;
-    vec->len = vec->cap = 0;
+    return h;
 }
 
-static void macro_def_free(MacroDef *def) {
-    if (!def) {
-        return;
-    }
-    free(def->name);
-    csv_rowvec_free(&def->rows);
-}
-
-static void macro_vec_push(MacroVec *vec, MacroDef def) {
-    if (vec->len == vec->cap) {
-        size_t n = vec->cap ? vec->cap * 2 : 8;
-        vec->items = xrealloc(vec->items, n * sizeof(MacroDef));
-        vec->cap = n;
+/* Returns the slot holding `name`, or the empty slot where it would go. */
+static uint32_t *macro_slot(const MacroVec *vec, StrView name, uint32_t hash) {
+    const size_t mask = vec->slot_count - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        uint32_t *slot = &vec->slots[i];
+        if (*slot == 0) {
+            return slot;
+        }
+        const MacroDef *def = &vec->items[*slot - 1];
+        if (def->hash == hash && def->name.len == name.len &&
+            strncasecmp(def->name.ptr, name.ptr, name.len) == 0) {
+            return slot;
+        }
     }
-    vec->items[vec->len++] = def;
 }
 
-static void macro_vec_free(MacroVec *vec) {
-    if (!vec) {
+/* Keeps the index at most half full; rehashes every definition when it grows. */
+static void macro_index_reserve(Arena *arena, MacroVec *vec) {
+    if ((vec->len + 1) * 2 <= vec->slot_count) {
         return;
     }
+    const size_t n = vec->slot_count ? vec->slot_count * 2 : 16;
+    vec->slots = arena_alloc(arena, n * sizeof(uint32_t));
+    memset(vec->slots, 0, n * sizeof(uint32_t));
+    vec->slot_count = n;
     for (size_t i = 0; i < vec->len; ++i) {
-        macro_def_free(&vec->items[i]);
+        uint32_t *slot = macro_slot(vec, vec->items[i].name, vec->items[i].hash);
+        if (*slot == 0) {
+            *slot = (uint32_t)i + 1u;
+        }
     }
-    free(vec->items);
-    vec->items = NULL;
-    vec->len = vec->cap = 0;
 }
 
-static char *strdup_upper(const char *s) {
-    if (!s) {
-        return NULL;
+/* Later definitions of a name stay in the list but lookups keep the first. */
+static void macro_vec_push(Arena *arena, MacroVec *vec, MacroDef def) {
+    macro_index_reserve(arena, vec);
+    if (vec->len == vec->cap) {
+        size_t n = vec->cap ? vec->cap * 2 : 8;
+        vec->items = arena_grow(arena, vec->items, vec->len, n, sizeof(MacroDef));
+        vec->cap = n;
     }
-    size_t len = strlen(s);
-    char *r = xmalloc(len + 1);
-    for (size_t i = 0; i < len; ++i) {
-        r[i] = (char)toupper((unsigned char)s[i]);
+    def.hash = name_hash(def.name);
+    uint32_t *slot = macro_slot(vec, def.name, def.hash);
+    if (*slot == 0) {
+        *slot = (uint32_t)vec->len + 1u;
     }
-    r[len] = '\0';
-    return r;
+    vec->items[vec->len++] = def;
 }
 
-static MacroDef *macro_find(MacroVec *vec, const char *name) {
-    if (!name) {
-        return NULL;
-    }
-    char *upper = strdup_upper(name);
-    if (!upper) {
+static MacroDef *macro_find(MacroVec *vec, StrView name) {
+    if (!view_set(name) || vec->slot_count == 0) {
         return NULL;
     }
-    MacroDef *result = NULL;
-    for (size_t i = 0; i < vec->len; ++i) {
-        if (vec->items[i].name && strcasecmp(vec->items[i].name, upper) == 0) {
-            result = &vec->items[i];
-            break;
-        }
-    }
-    free(upper);
-    return result;
+    const uint32_t *slot = macro_slot(vec, name, name_hash(name));
+    return *slot ? &vec->items[*slot - 1] : NULL;
 }
 
-static bool parse_csv_line(const char *line, CsvRow *row) {
+/*
+ * Splits one line into up to five trimmed field views. Quoted fields keep
+ * their quotes, as the parsers downstream expect.
+ */
+static bool parse_csv_line(StrView line, CsvRow *row) {
     memset(row, 0, sizeof(*row));
-    if (!line) {
+    if (!line.ptr) {
         return false;
     }
-    const char *p = line;
+    const char *p = line.ptr;
+    const char *end = line.ptr + line.len;
     int col = 0;
-    while (*p && col < 5) {
-        while (*p == ' ' || *p == '\t' || *p == '\r') {
+    while (p < end && *p && col < 5) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
             p++;
         }
-        if (*p == '\0' || *p == '\n') {
+        if (p == end || *p == '\0' || *p == '\n') {
             break;
         }
         if (*p == ',') {
-            row->cols[col++] = xstrdup("");
+            row->cols[col++] = (StrView){p, 0};
             p++;
             continue;
         }
         const char *start = p;
         if (*p == '"') {
             p++;
-            while (*p) {
+            while (p < end && *p) {
                 if (*p == '"') {
-                    if (p[1] == '"') {
+                    if (p + 1 < end && p[1] == '"') {
                         p += 2;
                         continue;
                     } else {
@@ -377,21 +463,19 @@ static bool parse_csv_line(const char *line, CsvRow *row) {
                 p++;
             }
         } else {
-            while (*p && *p != ',' && *p != '\n' && *p != '\r') {
+            while (p < end && *p && *p != ',' && *p != '\n' && *p != '\r') {
                 p++;
             }
         }
-        size_t len = (size_t)(p - start);
-        char *field = collect_field(start, len);
-        row->cols[col++] = field;
-        while (*p == ' ' || *p == '\t') {
+        row->cols[col++] = view_trim((StrView){start, (size_t)(p - start)});
+        while (p < end && (*p == ' ' || *p == '\t')) {
             p++;
         }
-        if (*p == ',') {
+        if (p < end && *p == ',') {
             p++;
             continue;
         }
-        while (*p && *p != '\n') {
+        while (p < end && *p && *p != '\n') {
             if (*p == ',') {
                 p++;
                 break;
@@ -518,30 +602,116 @@ fail:
     return false;
 }
 
-static SampleData *sample_cache_get(const char *path) {
-    for (size_t i = 0; i < sample_cache_len; ++i) {
-        if (strcmp(sample_cache[i].path, path) == 0) {
-            return &sample_cache[i].data;
+/* Frames a sample spans at `rate` when played at its natural pitch. */
+static int sample_length_at_rate(const SampleData *sd, int rate) {
+    double seconds = (double)sd->length / (double)sd->sample_rate;
+    int n = (int)lrint(seconds * (double)rate);
+    return n < 1 ? 1 : n;
+}
+
+/* Converts every channel once with the sinc resampler so unity-pitch voices can copy. */
+static void sample_data_convert(SampleData *sd, int rate) {
+    sd->rate = rate;
+    if (sd->sample_rate <= 0 || sd->length <= 0) {
+        return;
+    }
+    if (sd->sample_rate == rate) {
+        sd->rate_length = sd->length;
+        sd->rate_chan[0] = sd->chan[0];
+        sd->rate_chan[1] = sd->chan[1];
+        return;
+    }
+    sd->rate_length = sample_length_at_rate(sd, rate);
+    const double step = (double)sd->sample_rate / (double)rate;
+    for (int c = 0; c < sd->channels; ++c) {
+        Resampler rs;
+        sd->rate_chan[c] = xmalloc((size_t)sd->rate_length * sizeof(float));
+        resampler_init(&rs, sd->chan[c], (size_t)sd->length, step, RESAMPLE_SINC);
+        resampler_process(&rs, sd->rate_chan[c], (size_t)sd->rate_length);
+    }
+}
+
+static uint32_t sample_key_hash(const char *path, int rate) {
+    uint32_t h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)path; *p; ++p) {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    return (h ^ (uint32_t)rate) * 16777619u;
+}
+
+static SampleCacheEntry *sample_cache_slot(const char *path, int rate, uint32_t hash) {
+    const size_t mask = sample_cache_cap - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        SampleCacheEntry *e = &sample_cache[i];
+        if (!e->path || (e->hash == hash && e->rate == rate && strcmp(e->path, path) == 0)) {
+            return e;
+        }
+    }
+}
+
+/* Takes ownership of `path`; the table stays at most half full. */
+static void sample_cache_insert(char *path, int rate, SampleData *data, bool owner) {
+    if ((sample_cache_len + 1) * 2 > sample_cache_cap) {
+        SampleCacheEntry *old = sample_cache;
+        const size_t old_cap = sample_cache_cap;
+        sample_cache_cap = old_cap ? old_cap * 2 : 16;
+        sample_cache = xcalloc(sample_cache_cap, sizeof(*sample_cache));
+        for (size_t i = 0; i < old_cap; ++i) {
+            if (old[i].path) {
+                *sample_cache_slot(old[i].path, old[i].rate, old[i].hash) = old[i];
+            }
+        }
+        free(old);
+    }
+    const uint32_t hash = sample_key_hash(path, rate);
+    SampleCacheEntry *e = sample_cache_slot(path, rate, hash);
+    e->path = path;
+    e->hash = hash;
+    e->rate = rate;
+    e->owner = owner;
+    e->data = data;
+    ++sample_cache_len;
+}
+
+static SampleData *sample_cache_get(const char *path, int rate) {
+    if (sample_cache_cap > 0) {
+        const SampleCacheEntry *hit = sample_cache_slot(path, rate, sample_key_hash(path, rate));
+        if (hit->path) {
+            return hit->data;
+        }
+    }
+    char *canon = realpath(path, NULL);
+    if (!canon) {
+        canon = xstrdup(path);
+    }
+    const bool alias = strcmp(canon, path) != 0;
+    if (alias && sample_cache_cap > 0) {
+        const SampleCacheEntry *hit = sample_cache_slot(canon, rate, sample_key_hash(canon, rate));
+        if (hit->path) {
+            SampleData *data = hit->data;
+            free(canon);
+            sample_cache_insert(xstrdup(path), rate, data, false);
+            return data;
         }
     }
-    SampleCacheEntry entry = {0};
-    entry.path = xstrdup(path);
-    if (!load_wav_file(path, &entry.data)) {
-        free(entry.path);
+    SampleData *data = xcalloc(1, sizeof(SampleData));
+    if (!load_wav_file(path, data)) {
+        free(data);
+        free(canon);
         return NULL;
     }
-    if (sample_cache_len == sample_cache_cap) {
-        size_t n = sample_cache_cap ? sample_cache_cap * 2 : 8;
-        sample_cache = xrealloc(sample_cache, n * sizeof(*sample_cache));
-        sample_cache_cap = n;
+    sample_data_convert(data, rate);
+    sample_cache_insert(canon, rate, data, true);
+    if (alias) {
+        sample_cache_insert(xstrdup(path), rate, data, false);
     }
-    sample_cache[sample_cache_len++] = entry;
-    return &sample_cache[sample_cache_len - 1].data;
+    return data;
 }
 
 static bool parse_float_or_note(const char *s, float *out);
 
-static bool parse_named_spec(const char *s, SeqSpec *sp) {
+static bool parse_named_spec(const char *s, int sr, SeqSpec *sp) {
     if (!s || !*s) {
         return false;
     }
@@ -577,7 +747,7 @@ static bool parse_named_spec(const char *s, SeqSpec *sp) {
             return false;
         }
         char *path = dup_trimmed(param);
-        SampleData *sd = sample_cache_get(path);
+        SampleData *sd = sample_cache_get(path, sr);
         free(path);
         if (!sd) {
             return false;
@@ -591,35 +761,39 @@ static bool parse_named_spec(const char *s, SeqSpec *sp) {
         const char *name;
         SeqSpecType type;
         float default_freq;
+        int patch;
     };
     static const struct NamedSpec table[] = {
-        {"KICK", SEQ_SPEC_KICK, 140.f},
-        {"BD", SEQ_SPEC_KICK, 140.f},
-        {"SNARE", SEQ_SPEC_SNARE, 200.f},
-        {"SD", SEQ_SPEC_SNARE, 200.f},
-        {"HAT", SEQ_SPEC_HIHAT, 8000.f},
-        {"HIHAT", SEQ_SPEC_HIHAT, 8000.f},
-        {"HH", SEQ_SPEC_HIHAT, 8000.f},
-        {"BASS", SEQ_SPEC_BASS, 55.f},
-        {"SUB", SEQ_SPEC_BASS, 55.f},
-        {"FLUTE", SEQ_SPEC_FLUTE, 523.25f},
-        {"PIANO", SEQ_SPEC_PIANO, 440.f},
-        {"GUITAR", SEQ_SPEC_GUITAR, 330.f},
-        {"GT", SEQ_SPEC_GUITAR, 330.f},
-        {"EGTR", SEQ_SPEC_EGTR, 196.f},
-        {"EGUITAR", SEQ_SPEC_EGTR, 196.f},
-        {"BIRDS", SEQ_SPEC_BIRDS, 6000.f},
-        {"STRPAD", SEQ_SPEC_STRPAD, 440.f},
-        {"PAD", SEQ_SPEC_STRPAD, 440.f},
-        {"BELL", SEQ_SPEC_BELL, 880.f},
-        {"BRASS", SEQ_SPEC_BRASS, 330.f},
-        {"KALIMBA", SEQ_SPEC_KALIMBA, 392.f},
-        {"KORA", SEQ_SPEC_KALIMBA, 392.f},
-        {"LASER", SEQ_SPEC_LASER, 1320.f},
-        {"CHOIR", SEQ_SPEC_CHOIR, 261.63f},
-        {"ANALOGLEAD", SEQ_SPEC_ANALOGLEAD, 440.f},
-        {"SIDBASS", SEQ_SPEC_SIDBASS, 55.f},
-        {"CHIPARP", SEQ_SPEC_CHIPARP, 523.25f},
+        {"KICK", SEQ_SPEC_KICK, 140.f, 0},
+        {"BD", SEQ_SPEC_KICK, 140.f, 0},
+        {"SNARE", SEQ_SPEC_SNARE, 200.f, 0},
+        {"SD", SEQ_SPEC_SNARE, 200.f, 0},
+        {"HAT", SEQ_SPEC_HIHAT, 8000.f, 0},
+        {"HIHAT", SEQ_SPEC_HIHAT, 8000.f, 0},
+        {"HH", SEQ_SPEC_HIHAT, 8000.f, 0},
+        {"BASS", SEQ_SPEC_BASS, 55.f, 0},
+        {"SUB", SEQ_SPEC_BASS, 55.f, 0},
+        {"FLUTE", SEQ_SPEC_FLUTE, 523.25f, 0},
+        {"PIANO", SEQ_SPEC_PIANO, 440.f, 0},
+        {"GUITAR", SEQ_SPEC_GUITAR, 330.f, 0},
+        {"GT", SEQ_SPEC_GUITAR, 330.f, 0},
+        {"EGTR", SEQ_SPEC_EGTR, 196.f, 0},
+        {"EGUITAR", SEQ_SPEC_EGTR, 196.f, 0},
+        {"BIRDS", SEQ_SPEC_BIRDS, 6000.f, 0},
+        {"STRPAD", SEQ_SPEC_STRPAD, 440.f, 0},
+        {"PAD", SEQ_SPEC_STRPAD, 440.f, 0},
+        {"BELL", SEQ_SPEC_BELL, 880.f, 0},
+        {"BRASS", SEQ_SPEC_BRASS, 330.f, 0},
+        {"KALIMBA", SEQ_SPEC_KALIMBA, 392.f, 0},
+        {"KORA", SEQ_SPEC_KALIMBA, 392.f, 0},
+        {"LASER", SEQ_SPEC_LASER, 1320.f, 0},
+        {"CHOIR", SEQ_SPEC_CHOIR, 261.63f, 0},
+        {"ANALOGLEAD", SEQ_SPEC_ANALOGLEAD, 440.f, 0},
+        {"SIDBASS", SEQ_SPEC_SIDBASS, 55.f, 0},
+        {"CHIPARP", SEQ_SPEC_CHIPARP, 523.25f, 0},
+        {"FM", SEQ_SPEC_FM, 440.f, FM_PATCH_EPIANO},
+        {"EPIANO", SEQ_SPEC_FM, 440.f, FM_PATCH_EPIANO},
+        {"FMBASS", SEQ_SPEC_FM, 55.f, FM_PATCH_BASS},
     };
     for (size_t i = 0; i < sizeof(table) / sizeof(table[0]); ++i) {
         if (strcasecmp(buf, table[i].name) == 0) {
@@ -671,6 +845,7 @@ static bool parse_named_spec(const char *s, SeqSpec *sp) {
             }
             sp->type = table[i].type;
             sp->f_const = freq;
+            sp->patch = table[i].patch;
             return true;
         }
     }
@@ -747,7 +922,7 @@ static void seqspec_free(SeqSpec *sp) {
     (void)sp;
 }
 
-static SeqSpec parse_spec(const char *s) {
+static SeqSpec parse_spec(const char *s, int sr) {
     SeqSpec sp = SeqSpec_make_silence();
     if (!s || !*s) {
         return sp;
@@ -755,8 +930,8 @@ static SeqSpec parse_spec(const char *s) {
     if ((s[0] == 'r' || s[0] == 'R') && (s[1] == '\0')) {
         return sp;
     }
-    SeqSpec named;
-    if (parse_named_spec(s, &named)) {
+    SeqSpec named = sp;
+    if (parse_named_spec(s, sr, &named)) {
         return named;
     }
     const char *tilde = strchr(s, '~');
@@ -819,8 +994,8 @@ static SeqSpec parse_spec(const char *s) {
     return sp;
 }
 
-static bool parse_token(const char *arg, int def_ms, Token *out) {
-    char *dup = xstrdup(arg);
+static bool parse_token(Arena *arena, const char *arg, int def_ms, int sr, Token *out) {
+    char *dup = arena_strdup(arena, arg);
     char *col = strrchr(dup, ':');
     int dur = def_ms;
     bool explicit_dur = false;
@@ -842,7 +1017,6 @@ static bool parse_token(const char *arg, int def_ms, Token *out) {
     if ((body[0] == 'r' || body[0] == 'R' || body[0] == '0') && body[1] == '\0') {
         t.left = SeqSpec_make_silence();
         t.right = t.left;
-        free(dup);
         *out = t;
         return true;
     }
@@ -859,11 +1033,11 @@ static bool parse_token(const char *arg, int def_ms, Token *out) {
         char *rs = comma + 1;
         trim_inplace(ls);
         trim_inplace(rs);
-        t.left = parse_spec(ls);
-        t.right = parse_spec(rs);
+        t.left = parse_spec(ls, sr);
+        t.right = parse_spec(rs, sr);
         t.stereo = true;
     } else {
-        t.left = parse_spec(body);
+        t.left = parse_spec(body, sr);
         t.right = t.left;
         t.stereo = false;
     }
@@ -881,7 +1055,6 @@ static bool parse_token(const char *arg, int def_ms, Token *out) {
     t.sample_override = (!explicit_dur) &&
                         ((t.left.type == SEQ_SPEC_SAMPLE && t.left.sample) ||
                          (t.right.type == SEQ_SPEC_SAMPLE && t.right.sample));
-    free(dup);
     *out = t;
     return true;
 }
@@ -910,12 +1083,7 @@ static int sample_default_length(const SeqSpec *sp, int sr) {
     if (!sp || sp->type != SEQ_SPEC_SAMPLE || !sp->sample || sp->sample->sample_rate <= 0) {
         return 0;
     }
-    double seconds = (double)sp->sample->length / (double)sp->sample->sample_rate;
-    int n = (int)lrint(seconds * (double)sr);
-    if (n < 1) {
-        n = 1;
-    }
-    return n;
+    return sample_length_at_rate(sp->sample, sr);
 }
 
 static int token_target_samples(const Token *tok, int sr) {
@@ -952,11 +1120,12 @@ static int parse_gap_ms(const char *s) {
     return 0;
 }
 
-static char *extract_mode_token(const char *mode_in, bool *is_bg, bool *adv) {
+/* Strips BG/ADV from a mode field; the rest is returned in the arena. */
+static char *extract_mode_token(Arena *arena, const char *mode_in, bool *is_bg, bool *adv) {
     if (!mode_in || !*mode_in) {
         return NULL;
     }
-    char *tmp = xstrdup(mode_in);
+    char *tmp = arena_strdup(arena, mode_in);
     char *save = NULL;
     char *part = strtok_r(tmp, "|", &save);
     char *result = NULL;
@@ -969,27 +1138,28 @@ static char *extract_mode_token(const char *mode_in, bool *is_bg, bool *adv) {
                 *adv = true;
             } else {
                 if (!result) {
-                    result = xstrdup(part);
+                    result = part;
                 } else {
                     size_t len = strlen(result);
                     size_t add = strlen(part);
-                    result = xrealloc(result, len + add + 2);
-                    result[len] = '|';
-                    memcpy(result + len + 1, part, add + 1);
+                    char *joined = arena_alloc(arena, len + add + 2);
+                    memcpy(joined, result, len);
+                    joined[len] = '|';
+                    memcpy(joined + len + 1, part, add + 1);
+                    result = joined;
                 }
             }
         }
         part = strtok_r(NULL, "|", &save);
     }
-    free(tmp);
     return result;
 }
 
-static void parse_flag_string(const char *flags, bool *is_bg, bool *adv) {
+static void parse_flag_string(Arena *arena, const char *flags, bool *is_bg, bool *adv) {
     if (!flags) {
         return;
     }
-    char *tmp = xstrdup(flags);
+    char *tmp = arena_strdup(arena, flags);
     char *save = NULL;
     char *part = strtok_r(tmp, ",|", &save);
     while (part) {
@@ -1003,7 +1173,6 @@ static void parse_flag_string(const char *flags, bool *is_bg, bool *adv) {
         }
         part = strtok_r(NULL, ",|", &save);
     }
-    free(tmp);
 }
 
 static void tone_vec_push(ToneVec *vec, const SeqToneEvent *ev) {
@@ -1118,11 +1287,15 @@ static void parse_say_options(const char *optstr, SeqSpeechEvent *ev) {
     free(tmp);
 }
 
+static bool token_is_say(const char *token) {
+    return token && strncasecmp(token, "SAY", 3) == 0;
+}
+
 static bool parse_say_event(const char *token,
                             size_t start_samples,
                             int sr,
                             SpeechVec *speech) {
-    if (!token || strncasecmp(token, "SAY", 3) != 0) {
+    if (!token_is_say(token)) {
         return false;
     }
     const char *p = token + 3;
@@ -1266,97 +1439,171 @@ static void apply_mode_to_token(Token *tok, const char *mode) {
     }
 }
 
-static bool load_sequence_rows(const char *path, CsvRowVec *rows, MacroVec *macros) {
-    FILE *fp = fopen(path, "r");
-    if (!fp) {
+/*
+ * Read-only view of a whole file; rows and macros point into it until it is
+ * closed. Regular files are mapped; pipes, terminals and files that cannot
+ * be mapped are read into a heap buffer instead.
+ */
+typedef struct {
+    const char *data;
+    size_t size;
+    bool heap;
+} MappedFile;
+
+static bool read_file_fd(int fd, const char *path, MappedFile *file) {
+    char *buf = NULL;
+    size_t cap = 0;
+    size_t len = 0;
+    for (;;) {
+        if (len == cap) {
+            cap = cap ? cap * 2u : READ_FILE_CHUNK;
+            buf = xrealloc(buf, cap);
+        }
+        const ssize_t got = read(fd, buf + len, cap - len);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "synthrave: cannot read %s: %s\n", path, strerror(errno));
+            free(buf);
+            return false;
+        }
+        if (got == 0) {
+            break;
+        }
+        len += (size_t)got;
+    }
+    file->data = buf;
+    file->size = len;
+    file->heap = true;
+    return true;
+}
+
+static bool mapped_file_open(const char *path, MappedFile *file) {
+    memset(file, 0, sizeof(*file));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
         fprintf(stderr, "synthrave: cannot open %s: %s\n", path, strerror(errno));
         return false;
     }
-    char *line = NULL;
-    size_t cap = 0;
-    while (getline(&line, &cap, fp) != -1) {
-        char *trim_line = dup_trimmed(line);
-        if (!trim_line) {
-            continue;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        fprintf(stderr, "synthrave: cannot stat %s: %s\n", path, strerror(errno));
+        close(fd);
+        return false;
+    }
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            file->data = map;
+            file->size = (size_t)st.st_size;
+            close(fd);
+            return true;
         }
-        if (trim_line[0] == '\0' || trim_line[0] == '#' ||
-            strncmp(trim_line, "//", 2) == 0 || strncmp(trim_line, "--", 2) == 0) {
-            free(trim_line);
+    }
+    const bool ok = read_file_fd(fd, path, file);
+    close(fd);
+    return ok;
+}
+
+static void mapped_file_close(MappedFile *file) {
+    if (file->heap) {
+        free((void *)file->data);
+    } else if (file->data) {
+        munmap((void *)file->data, file->size);
+    }
+    memset(file, 0, sizeof(*file));
+}
+
+/* Next line without its newline; false at the end of the text. */
+static bool next_line(const char **cursor, const char *end, StrView *line) {
+    if (*cursor >= end) {
+        return false;
+    }
+    const char *start = *cursor;
+    const char *nl = memchr(start, '\n', (size_t)(end - start));
+    const char *stop = nl ? nl : end;
+    *cursor = nl ? nl + 1 : end;
+    *line = (StrView){start, (size_t)(stop - start)};
+    return true;
+}
+
+static bool line_is_blank_or_comment(StrView trimmed) {
+    return trimmed.len == 0 || trimmed.ptr[0] == '#' || view_starts_with(trimmed, "//") ||
+           view_starts_with(trimmed, "--");
+}
+
+/* Tokenizes the mapped text into row views; no field is copied. */
+static bool load_sequence_rows(Arena *arena,
+                               const MappedFile *file,
+                               CsvRowVec *rows,
+                               MacroVec *macros) {
+    const char *cursor = file->data;
+    const char *end = file->data + file->size;
+    StrView line;
+    while (next_line(&cursor, end, &line)) {
+        const StrView trim_line = view_trim(line);
+        if (line_is_blank_or_comment(trim_line)) {
             continue;
         }
-        if (trim_line[0] == '@') {
-            char *brace = strchr(trim_line, '{');
+        if (trim_line.ptr[0] == '@') {
+            const char *brace = memchr(trim_line.ptr, '{', trim_line.len);
             if (brace) {
-                *brace = '\0';
-                char *name = trim_line + 1;
-                trim_inplace(name);
+                const StrView name =
+                    view_trim((StrView){trim_line.ptr + 1, (size_t)(brace - trim_line.ptr - 1)});
                 MacroDef def = {0};
-                def.name = strdup_upper(name);
+                def.name = name;
                 bool closed = false;
-                while (getline(&line, &cap, fp) != -1) {
-                    char *inner = dup_trimmed(line);
-                    if (!inner) {
+                while (next_line(&cursor, end, &line)) {
+                    const StrView inner = view_trim(line);
+                    if (line_is_blank_or_comment(inner)) {
                         continue;
                     }
-                    if (inner[0] == '\0' || inner[0] == '#' ||
-                        strncmp(inner, "//", 2) == 0 || strncmp(inner, "--", 2) == 0) {
-                        free(inner);
-                        continue;
-                    }
-                    if (inner[0] == '}') {
-                        free(inner);
+                    if (inner.ptr[0] == '}') {
                         closed = true;
                         break;
                     }
                     CsvRow row;
-                    if (parse_csv_line(line, &row)) {
-                        if (row.cols[0] && row.cols[0][0] != '\0') {
-                            csv_rowvec_push(&def.rows, row);
-                        } else {
-                            csv_row_free(&row);
-                        }
+                    if (parse_csv_line(line, &row) && view_set(row.cols[0])) {
+                        csv_rowvec_push(arena, &def.rows, row);
+                        ++load_stats.rows;
                     }
-                    free(inner);
                 }
                 if (!closed) {
-                    fprintf(stderr, "synthrave: macro %s missing closing brace\n", name);
-                    macro_def_free(&def);
+                    fprintf(stderr, "synthrave: macro %.*s missing closing brace\n",
+                            (int)name.len, name.ptr);
                 } else {
-                    macro_vec_push(macros, def);
+                    macro_vec_push(arena, macros, def);
                 }
-                free(trim_line);
                 continue;
             }
         }
-        free(trim_line);
         CsvRow row;
         if (!parse_csv_line(line, &row)) {
             continue;
         }
-        if (!row.cols[0] || row.cols[0][0] == '\0' || row.cols[0][0] == '#') {
-            csv_row_free(&row);
+        if (!view_set(row.cols[0]) || row.cols[0].ptr[0] == '#') {
             continue;
         }
-        csv_rowvec_push(rows, row);
+        csv_rowvec_push(arena, rows, row);
+        ++load_stats.rows;
     }
-    free(line);
-    fclose(fp);
     return true;
 }
 
 static bool row_is_repeat_marker(const CsvRow *row, int *span, int *reps) {
-    if (!row->cols[0] || row->cols[0][0] != '-') {
+    if (!view_set(row->cols[0]) || row->cols[0].ptr[0] != '-') {
         return false;
     }
     int val = 0;
-    if (!parse_int_strict(row->cols[0], &val) || val >= 0) {
+    if (!view_parse_int(row->cols[0], &val) || val >= 0) {
         return false;
     }
-    if (!row->cols[1]) {
+    if (!row->cols[1].ptr) {
         return false;
     }
     int rep = 0;
-    if (!parse_int_strict(row->cols[1], &rep) || rep <= 0) {
+    if (!view_parse_int(row->cols[1], &rep) || rep <= 0) {
         return false;
     }
     *span = -val;
@@ -1364,187 +1611,590 @@ static bool row_is_repeat_marker(const CsvRow *row, int *span, int *reps) {
     return true;
 }
 
-static bool expand_repeats(const CsvRowVec *src, CsvRowVec *dst);
-static bool expand_macro_rows(const MacroDef *macro, MacroVec *macros, CsvRowVec *dst, int depth);
+/* `@NAME` rows refer to a macro; returns the name after the '@'. */
+static bool row_macro_ref(const CsvRow *row, StrView *name) {
+    const StrView tok = row->cols[0];
+    if (tok.len < 2 || tok.ptr[0] != '@') {
+        return false;
+    }
+    *name = (StrView){tok.ptr + 1, tok.len - 1};
+    return true;
+}
+
+/* Arena buffer that holds NUL-terminated copies of the current row's fields. */
+typedef struct {
+    char *buf;
+    size_t cap;
+} RowScratch;
+
+static void row_fields_cstr(Arena *arena,
+                            const CsvRow *row,
+                            RowScratch *scratch,
+                            const char *cols[5]) {
+    size_t need = 0;
+    for (int c = 0; c < 5; ++c) {
+        need += row->cols[c].len + 1u;
+    }
+    if (need > scratch->cap) {
+        scratch->cap = need > 256u ? need : 256u;
+        scratch->buf = arena_alloc(arena, scratch->cap);
+    }
+    char *out = scratch->buf;
+    for (int c = 0; c < 5; ++c) {
+        if (!row->cols[c].ptr) {
+            cols[c] = NULL;
+            continue;
+        }
+        memcpy(out, row->cols[c].ptr, row->cols[c].len);
+        out[row->cols[c].len] = '\0';
+        cols[c] = out;
+        out += row->cols[c].len + 1u;
+    }
+}
 
-static bool expand_macros(const CsvRowVec *src, MacroVec *macros, CsvRowVec *dst) {
-    for (size_t i = 0; i < src->len; ++i) {
-        const CsvRow *row = &src->items[i];
-        const char *tok = row->cols[0];
-        if (tok && tok[0] == '@' && tok[1] != '\0') {
-            MacroDef *macro = macro_find(macros, tok + 1);
-            if (macro) {
-                if (!expand_macro_rows(macro, macros, dst, 1)) {
-                    return false;
-                }
-                continue;
+/* One source row parsed once; every position it is reached at replays it. */
+typedef enum {
+    STEP_SKIP = 0, /* empty token: no event and no time */
+    STEP_REST,
+    STEP_SAY,
+    STEP_TONE
+} TimelineStepKind;
+
+typedef struct {
+    TimelineStepKind kind;
+    size_t advance;    /* samples the timeline moves on after the row */
+    const char *say;   /* STEP_SAY: token, turned into a speech event per occurrence */
+    SeqToneEvent tone; /* STEP_TONE: start_sample is set per occurrence */
+} TimelineStep;
+
+/*
+ * Parses a row into `step`. Fields and temporaries go to `scratch`; the
+ * mode, flags and SAY strings the step keeps are copied to `keep`.
+ */
+static bool compile_step(Arena *scratch,
+                         Arena *keep,
+                         const CsvRow *row,
+                         RowScratch *fields,
+                         const SequenceOptions *opts,
+                         TimelineStep *step) {
+    const int sr = opts->sample_rate;
+    const char *cols[5];
+    row_fields_cstr(scratch, row, fields, cols);
+    memset(step, 0, sizeof(*step));
+    const char *tok = cols[0] ? cols[0] : "";
+    if (!*tok) {
+        return true;
+    }
+    bool is_bg = false;
+    bool adv = false;
+    const char *mode_clean = extract_mode_token(scratch, cols[3], &is_bg, &adv);
+    parse_flag_string(scratch, cols[4], &is_bg, &adv);
+    int dur_ms = opts->default_duration_ms;
+    if (cols[1] && *cols[1]) {
+        if (!parse_int_strict(cols[1], &dur_ms) || dur_ms <= 0) {
+            dur_ms = opts->default_duration_ms;
+        }
+    }
+    const int gap_ms = parse_gap_ms(cols[2]);
+    const size_t gap_samples = (size_t)ms_to_samples_allow_zero(gap_ms, sr);
+    const bool advance = !is_bg || adv;
+    if (token_is_say(tok)) {
+        step->kind = STEP_SAY;
+        step->say = arena_strdup(keep, tok);
+        if (advance) {
+            const int say_ms = dur_ms > 0 ? dur_ms : opts->default_duration_ms;
+            step->advance = (size_t)ms_to_samples_allow_zero(say_ms, sr) + gap_samples;
+        }
+        return true;
+    }
+    const int effective_ms = (dur_ms > 0) ? dur_ms : opts->default_duration_ms;
+    Token parsed;
+    if (!parse_token(scratch, tok, effective_ms, sr, &parsed)) {
+        fprintf(stderr, "synthrave: token parse error: %s\n", tok);
+        return false;
+    }
+    const int tone_ms = parsed.duration_ms > 0 ? parsed.duration_ms : effective_ms;
+    apply_mode_to_token(&parsed, mode_clean);
+    if (parsed.left.type == SEQ_SPEC_SILENCE && parsed.right.type == SEQ_SPEC_SILENCE) {
+        step->kind = STEP_REST;
+        if (advance) {
+            step->advance = (size_t)ms_to_samples_allow_zero(tone_ms, sr) + gap_samples;
+        }
+        return true;
+    }
+    SeqToneEvent *ev = &step->tone;
+    ev->left = spec_clone(&parsed.left);
+    ev->right = spec_clone(&parsed.right);
+    ev->stereo = parsed.stereo;
+    ev->gain = 1.0f;
+    ev->duration_ms = tone_ms;
+    ev->gap_ms = gap_ms;
+    ev->explicit_duration = parsed.explicit_dur;
+    ev->sample_override = parsed.sample_override;
+    ev->sample_count = (size_t)token_target_samples(&parsed, sr);
+    ev->is_bg = is_bg;
+    ev->adv = adv;
+    ev->mode_raw = mode_clean ? arena_strdup(keep, mode_clean) : NULL;
+    ev->flags_raw = cols[4] ? arena_strdup(keep, cols[4]) : NULL;
+    step->kind = STEP_TONE;
+    if (advance) {
+        step->advance = ev->sample_count + gap_samples;
+    }
+    return true;
+}
+
+/* Flat tone and speech lists for rows without macros or loops (command-line tokens). */
+static bool build_sequence_events(Arena *arena,
+                                  const CsvRowVec *rows,
+                                  const SequenceOptions *opts,
+                                  ToneVec *tones,
+                                  SpeechVec *speech,
+                                  size_t *total_samples) {
+    size_t timeline_samples = 0;
+    size_t max_end = 0;
+    RowScratch fields = {0};
+    for (size_t i = 0; i < rows->len; ++i) {
+        TimelineStep step;
+        if (!compile_step(arena, arena, &rows->items[i], &fields, opts, &step)) {
+            return false;
+        }
+        if (step.kind == STEP_SAY) {
+            parse_say_event(step.say, timeline_samples, opts->sample_rate, speech);
+        } else if (step.kind == STEP_TONE) {
+            SeqToneEvent ev = step.tone;
+            ev.start_sample = timeline_samples;
+            ev.mode_raw = xstrdup(step.tone.mode_raw);
+            ev.flags_raw = xstrdup(step.tone.flags_raw);
+            tone_vec_push(tones, &ev);
+            if (ev.start_sample + ev.sample_count > max_end) {
+                max_end = ev.start_sample + ev.sample_count;
             }
         }
-        csv_rowvec_push(dst, csv_row_clone(row));
+        timeline_samples += step.advance;
     }
+    *total_samples = max_end > timeline_samples ? max_end : timeline_samples;
     return true;
 }
 
-static bool expand_macro_rows(const MacroDef *macro, MacroVec *macros, CsvRowVec *dst, int depth) {
-    if (depth > 16) {
-        fprintf(stderr, "synthrave: macro recursion too deep for %s\n", macro->name);
-        return false;
+/*
+ * Timeline IR for .aox files. Every source row becomes one step node, a
+ * macro becomes one sequence node shared by all its calls, and a -N,R
+ * marker becomes a repeat node over the (shared) nodes it covers, so the
+ * folded timeline grows with the file rather than with the unrolled song.
+ * A SequenceCursor unrolls it tone by tone while the scheduler mixes.
+ */
+typedef enum {
+    NODE_STEP = 0,
+    NODE_SEQ,
+    NODE_REPEAT
+} TimelineNodeKind;
+
+struct TimelineNode {
+    TimelineNodeKind kind;
+    bool marker;   /* holds -N,R rows not yet applied (load time only) */
+    bool compiled; /* step parsed and the totals below filled in */
+    bool speech;   /* holds SAY rows */
+    size_t rows;   /* source rows once unrolled; what marker spans count */
+    size_t tones;
+    size_t advance; /* samples one pass moves the timeline on */
+    size_t extent;  /* furthest tone end from the node's start */
+    const CsvRow *row;    /* NODE_STEP, load time only */
+    TimelineStep *step;   /* NODE_STEP */
+    TimelineNode **items; /* NODE_SEQ */
+    TimelineNode *body;   /* NODE_REPEAT */
+    size_t count;         /* NODE_SEQ items, NODE_REPEAT passes */
+};
+
+struct SequenceTimeline {
+    Arena arena; /* nodes, steps and their strings */
+    TimelineNode *root;
+};
+
+struct SequenceCursorFrame {
+    const TimelineNode *node;
+    size_t index; /* next item, or passes done */
+};
+
+typedef struct {
+    TimelineNode **items;
+    size_t len;
+    size_t cap;
+} NodeVec;
+
+/* Load state: `scratch` dies with the load, `keep` is the timeline's arena. */
+typedef struct {
+    Arena *scratch;
+    Arena *keep;
+    MacroVec *macros;
+    const SequenceOptions *opts;
+    RowScratch fields;
+    bool overflow; /* an unrolled count no longer fits a size_t */
+} TimelineBuild;
+
+static size_t size_add_sat(size_t a, size_t b, bool *overflow) {
+    if (b > SIZE_MAX - a) {
+        *overflow = true;
+        return SIZE_MAX;
+    }
+    return a + b;
+}
+
+static size_t size_mul_sat(size_t a, size_t b, bool *overflow) {
+    if (a != 0 && b > SIZE_MAX / a) {
+        *overflow = true;
+        return SIZE_MAX;
+    }
+    return a * b;
+}
+
+static void node_vec_push(Arena *arena, NodeVec *vec, TimelineNode *node) {
+    if (vec->len == vec->cap) {
+        size_t n = vec->cap ? vec->cap * 2 : 16;
+        vec->items = arena_grow(arena, vec->items, vec->len, n, sizeof(TimelineNode *));
+        vec->cap = n;
+    }
+    vec->items[vec->len++] = node;
+}
+
+static TimelineNode *node_new(TimelineBuild *b, TimelineNodeKind kind) {
+    TimelineNode *node = arena_alloc(b->keep, sizeof(*node));
+    memset(node, 0, sizeof(*node));
+    node->kind = kind;
+    return node;
+}
+
+static TimelineNode *node_step(TimelineBuild *b, const CsvRow *row) {
+    TimelineNode *node = node_new(b, NODE_STEP);
+    int span = 0, reps = 0;
+    node->row = row;
+    node->rows = 1;
+    node->marker = row_is_repeat_marker(row, &span, &reps);
+    return node;
+}
+
+static TimelineNode *node_seq(TimelineBuild *b, const NodeVec *parts) {
+    TimelineNode *node = node_new(b, NODE_SEQ);
+    if (parts->len > 0) {
+        node->items = arena_alloc(b->keep, parts->len * sizeof(TimelineNode *));
+        memcpy(node->items, parts->items, parts->len * sizeof(TimelineNode *));
+    }
+    node->count = parts->len;
+    for (size_t i = 0; i < parts->len; ++i) {
+        node->rows = size_add_sat(node->rows, parts->items[i]->rows, &b->overflow);
+        node->marker = node->marker || parts->items[i]->marker;
+    }
+    return node;
+}
+
+/* As node_seq, but a single part stands for itself. */
+static TimelineNode *node_join(TimelineBuild *b, const NodeVec *parts) {
+    return parts->len == 1 ? parts->items[0] : node_seq(b, parts);
+}
+
+static TimelineNode *node_repeat(TimelineBuild *b, TimelineNode *body, size_t times) {
+    if (times == 1) {
+        return body;
+    }
+    TimelineNode *node = node_new(b, NODE_REPEAT);
+    node->body = body;
+    node->count = times;
+    node->rows = size_mul_sat(body->rows, times, &b->overflow);
+    return node;
+}
+
+/* Rows [from, from + count) of a node without markers; whole subtrees are shared. */
+static TimelineNode *node_slice(TimelineBuild *b, TimelineNode *node, size_t from, size_t count) {
+    if (from == 0 && count == node->rows) {
+        return node;
+    }
+    NodeVec parts = {0};
+    if (node->kind == NODE_SEQ) {
+        for (size_t i = 0; i < node->count && count > 0; ++i) {
+            TimelineNode *child = node->items[i];
+            if (from >= child->rows) {
+                from -= child->rows;
+                continue;
+            }
+            const size_t take = child->rows - from < count ? child->rows - from : count;
+            node_vec_push(b->scratch, &parts, node_slice(b, child, from, take));
+            from = 0;
+            count -= take;
+        }
+    } else if (node->kind == NODE_REPEAT) {
+        TimelineNode *body = node->body;
+        const size_t offset = from % body->rows;
+        if (offset > 0) {
+            const size_t take = body->rows - offset < count ? body->rows - offset : count;
+            node_vec_push(b->scratch, &parts, node_slice(b, body, offset, take));
+            count -= take;
+        }
+        const size_t whole = count / body->rows;
+        if (whole > 0) {
+            node_vec_push(b->scratch, &parts, node_repeat(b, body, whole));
+            count -= whole * body->rows;
+        }
+        if (count > 0) {
+            node_vec_push(b->scratch, &parts, node_slice(b, body, 0, count));
+        }
+    }
+    return node_join(b, &parts);
+}
+
+#define MACRO_MAX_DEPTH 16
+
+/*
+ * The node for a macro called at nesting `depth`. Built once and shared by
+ * every call that stays within MACRO_MAX_DEPTH; a call that would exceed it
+ * is rebuilt so the error names the same macro as a flat expansion would.
+ */
+static TimelineNode *macro_node(TimelineBuild *b, MacroDef *macro, int depth) {
+    if (depth > MACRO_MAX_DEPTH) {
+        fprintf(stderr, "synthrave: macro recursion too deep for %.*s\n", (int)macro->name.len,
+                macro->name.ptr);
+        return NULL;
+    }
+    if (macro->node && depth + macro->height - 1 <= MACRO_MAX_DEPTH) {
+        return macro->node;
     }
+    NodeVec body = {0};
+    int height = 1;
     for (size_t i = 0; i < macro->rows.len; ++i) {
         const CsvRow *row = &macro->rows.items[i];
-        const char *tok = row->cols[0];
-        if (tok && tok[0] == '@' && tok[1] != '\0') {
-            MacroDef *inner = macro_find(macros, tok + 1);
+        StrView ref;
+        if (row_macro_ref(row, &ref)) {
+            MacroDef *inner = macro_find(b->macros, ref);
             if (!inner) {
-                fprintf(stderr, "synthrave: unknown macro %s inside %s\n", tok, macro->name);
-                return false;
+                fprintf(stderr, "synthrave: unknown macro @%.*s inside %.*s\n", (int)ref.len,
+                        ref.ptr, (int)macro->name.len, macro->name.ptr);
+                return NULL;
             }
-            if (!expand_macro_rows(inner, macros, dst, depth + 1)) {
-                return false;
+            TimelineNode *child = macro_node(b, inner, depth + 1);
+            if (!child) {
+                return NULL;
+            }
+            if (inner->height + 1 > height) {
+                height = inner->height + 1;
             }
+            node_vec_push(b->scratch, &body, child);
+            continue;
+        }
+        node_vec_push(b->scratch, &body, node_step(b, row));
+    }
+    macro->node = node_join(b, &body);
+    macro->height = height;
+    return macro->node;
+}
+
+/* Top-level rows with known `@NAME` calls replaced by the macro's node. */
+static bool fold_macros(TimelineBuild *b, const CsvRowVec *rows, NodeVec *out) {
+    for (size_t i = 0; i < rows->len; ++i) {
+        const CsvRow *row = &rows->items[i];
+        StrView ref;
+        MacroDef *macro = NULL;
+        if (row_macro_ref(row, &ref)) {
+            macro = macro_find(b->macros, ref);
+        }
+        if (!macro) {
+            node_vec_push(b->scratch, out, node_step(b, row));
             continue;
         }
-        csv_rowvec_push(dst, csv_row_clone(row));
+        TimelineNode *node = macro_node(b, macro, 1);
+        if (!node) {
+            return false;
+        }
+        node_vec_push(b->scratch, out, node);
     }
     return true;
 }
 
-static bool expand_repeats(const CsvRowVec *src, CsvRowVec *dst) {
+/* Lays sequences holding markers open, so each marker sits in `out` itself. */
+static void open_markers(TimelineBuild *b, TimelineNode *node, NodeVec *out) {
+    if (node->kind == NODE_SEQ && node->marker) {
+        for (size_t i = 0; i < node->count; ++i) {
+            open_markers(b, node->items[i], out);
+        }
+        return;
+    }
+    node_vec_push(b->scratch, out, node);
+}
+
+/* The last `span` rows of `vec` as one node. */
+static TimelineNode *node_vec_tail(TimelineBuild *b, const NodeVec *vec, size_t span) {
+    size_t k = vec->len;
+    while (k > 0 && vec->items[k - 1]->rows < span) {
+        span -= vec->items[--k]->rows;
+    }
+    NodeVec parts = {0};
+    if (k > 0 && span > 0) {
+        TimelineNode *node = vec->items[k - 1];
+        node_vec_push(b->scratch, &parts, node_slice(b, node, node->rows - span, span));
+    }
+    for (; k < vec->len; ++k) {
+        node_vec_push(b->scratch, &parts, vec->items[k]);
+    }
+    return node_join(b, &parts);
+}
+
+/*
+ * Applies -N,R markers with the rules of the flat expansion: a marker
+ * followed by at least N rows plays those rows R times, otherwise the last
+ * N rows produced so far are played R more times. Spans count unrolled rows,
+ * so they may cut into macros; the cut pieces are slices of shared nodes.
+ */
+static void expand_repeat_nodes(TimelineBuild *b, const NodeVec *src, NodeVec *dst) {
+    NodeVec in = {0};
+    size_t remaining = 0;
+    for (size_t i = 0; i < src->len; ++i) {
+        open_markers(b, src->items[i], &in);
+        remaining = size_add_sat(remaining, src->items[i]->rows, &b->overflow);
+    }
+    size_t produced = 0;
     size_t i = 0;
-    while (i < src->len) {
+    size_t offset = 0; /* rows of in.items[i] already taken by a block */
+    while (i < in.len) {
+        TimelineNode *node = in.items[i];
         int span = 0, reps = 0;
-        const CsvRow *row = &src->items[i];
-        if (row_is_repeat_marker(row, &span, &reps)) {
-            if (span <= 0 || reps <= 0) {
-                i++;
-                continue;
-            }
-            size_t start = i + 1;
-            size_t remaining = (start < src->len) ? (src->len - start) : 0;
+        if (node->kind == NODE_STEP && node->marker &&
+            row_is_repeat_marker(node->row, &span, &reps)) {
+            ++i;
+            --remaining;
+            TimelineNode *repeated = NULL;
             if (remaining >= (size_t)span) {
-                CsvRowVec block = {0}, block_expanded = {0};
-                for (size_t k = 0; k < (size_t)span; ++k) {
-                    csv_rowvec_push(&block, csv_row_clone(&src->items[start + k]));
-                }
-                expand_repeats(&block, &block_expanded);
-                for (int r = 0; r < reps; ++r) {
-                    for (size_t k = 0; k < block_expanded.len; ++k) {
-                        csv_rowvec_push(dst, csv_row_clone(&block_expanded.items[k]));
-                    }
-                }
-                csv_rowvec_free(&block_expanded);
-                csv_rowvec_free(&block);
-                i = start + (size_t)span;
-                continue;
-            } else if (dst->len > 0) {
-                if ((size_t)span > dst->len) {
-                    span = (int)dst->len;
-                }
-                size_t base = dst->len - (size_t)span;
-                for (int r = 0; r < reps; ++r) {
-                    for (size_t k = 0; k < (size_t)span; ++k) {
-                        csv_rowvec_push(dst, csv_row_clone(&dst->items[base + k]));
+                NodeVec block = {0}, block_expanded = {0};
+                for (size_t need = (size_t)span; need > 0;) {
+                    TimelineNode *next = in.items[i];
+                    const size_t avail = next->rows - offset;
+                    const size_t take = avail < need ? avail : need;
+                    node_vec_push(b->scratch, &block, node_slice(b, next, offset, take));
+                    need -= take;
+                    offset += take;
+                    if (offset == next->rows) {
+                        ++i;
+                        offset = 0;
                     }
                 }
+                remaining -= (size_t)span;
+                expand_repeat_nodes(b, &block, &block_expanded);
+                repeated = node_repeat(b, node_seq(b, &block_expanded), (size_t)reps);
+            } else if (produced > 0) {
+                const size_t tail = (size_t)span < produced ? (size_t)span : produced;
+                repeated = node_repeat(b, node_vec_tail(b, dst, tail), (size_t)reps);
+            }
+            if (repeated && repeated->rows > 0) {
+                node_vec_push(b->scratch, dst, repeated);
+                produced = size_add_sat(produced, repeated->rows, &b->overflow);
             }
-            i++;
             continue;
         }
-        csv_rowvec_push(dst, csv_row_clone(row));
-        i++;
+        TimelineNode *rest = node_slice(b, node, offset, node->rows - offset);
+        node_vec_push(b->scratch, dst, rest);
+        produced = size_add_sat(produced, rest->rows, &b->overflow);
+        remaining -= rest->rows;
+        ++i;
+        offset = 0;
     }
-    return true;
 }
 
-static bool build_sequence_events(const CsvRowVec *rows,
-                                  const SequenceOptions *opts,
-                                  ToneVec *tones,
-                                  SpeechVec *speech,
-                                  size_t *total_samples) {
-    int sr = opts->sample_rate;
-    size_t timeline_samples = 0;
-    size_t max_end = 0;
-    for (size_t i = 0; i < rows->len; ++i) {
-        const CsvRow *row = &rows->items[i];
-        const char *tok = row->cols[0] ? row->cols[0] : "";
-        if (!tok || !*tok) {
-            continue;
-        }
-        bool is_bg = false;
-        bool adv = false;
-        char *mode_clean = extract_mode_token(row->cols[3], &is_bg, &adv);
-        parse_flag_string(row->cols[4], &is_bg, &adv);
-        int dur_ms = opts->default_duration_ms;
-        if (row->cols[1] && *row->cols[1]) {
-            if (!parse_int_strict(row->cols[1], &dur_ms) || dur_ms <= 0) {
-                dur_ms = opts->default_duration_ms;
+/* Parses each step once and sums tones, advance and extent bottom-up. */
+static bool timeline_compile(TimelineBuild *b, TimelineNode *node) {
+    if (node->compiled) {
+        return true;
+    }
+    switch (node->kind) {
+        case NODE_STEP: {
+            TimelineStep *step = arena_alloc(b->keep, sizeof(*step));
+            if (!compile_step(b->scratch, b->keep, node->row, &b->fields, b->opts, step)) {
+                return false;
             }
-        }
-        int gap_ms = parse_gap_ms(row->cols[2]);
-        int gap_samples = ms_to_samples_allow_zero(gap_ms, sr);
-        size_t event_start = timeline_samples;
-        if (parse_say_event(tok, timeline_samples, sr, speech)) {
-            bool advance = (!is_bg || adv);
-            if (advance) {
-                int say_samples = ms_to_samples_allow_zero((dur_ms > 0) ? dur_ms : opts->default_duration_ms, sr);
-                timeline_samples += (size_t)say_samples;
-                timeline_samples += (size_t)gap_samples;
+            node->step = step;
+            node->row = NULL;
+            node->advance = step->advance;
+            node->speech = step->kind == STEP_SAY;
+            if (step->kind == STEP_TONE) {
+                node->tones = 1;
+                node->extent = step->tone.sample_count;
             }
-            free(mode_clean);
-            continue;
-        }
-        int effective_ms = (dur_ms > 0) ? dur_ms : opts->default_duration_ms;
-        Token parsed;
-        if (!parse_token(tok, effective_ms, &parsed)) {
-            fprintf(stderr, "synthrave: token parse error: %s\n", tok);
-            free(mode_clean);
-            return false;
+            break;
         }
-        int tone_ms = parsed.duration_ms > 0 ? parsed.duration_ms : effective_ms;
-        apply_mode_to_token(&parsed, mode_clean);
-        int tone_samples = token_target_samples(&parsed, sr);
-        bool advance = (!is_bg || adv);
-        if (parsed.left.type == SEQ_SPEC_SILENCE && parsed.right.type == SEQ_SPEC_SILENCE) {
-            if (advance) {
-                int rest_samples = ms_to_samples_allow_zero(tone_ms, sr);
-                timeline_samples += (size_t)rest_samples;
-                timeline_samples += (size_t)gap_samples;
+        case NODE_SEQ:
+            for (size_t i = 0; i < node->count; ++i) {
+                TimelineNode *child = node->items[i];
+                if (!timeline_compile(b, child)) {
+                    return false;
+                }
+                if (child->tones > 0) {
+                    const size_t end = size_add_sat(node->advance, child->extent, &b->overflow);
+                    if (end > node->extent) {
+                        node->extent = end;
+                    }
+                }
+                node->advance = size_add_sat(node->advance, child->advance, &b->overflow);
+                node->tones = size_add_sat(node->tones, child->tones, &b->overflow);
+                node->speech = node->speech || child->speech;
             }
-            free(mode_clean);
-            continue;
-        }
-        SeqToneEvent ev = {0};
-        ev.left = spec_clone(&parsed.left);
-        ev.right = spec_clone(&parsed.right);
-        ev.stereo = parsed.stereo;
-        ev.duration_ms = tone_ms;
-        ev.gap_ms = gap_ms;
-        ev.explicit_duration = parsed.explicit_dur;
-        ev.sample_override = parsed.sample_override;
-        ev.start_sample = event_start;
-        ev.sample_count = (size_t)tone_samples;
-        ev.is_bg = is_bg;
-        ev.adv = adv;
-        ev.mode_raw = mode_clean ? xstrdup(mode_clean) : NULL;
-        ev.flags_raw = row->cols[4] ? xstrdup(row->cols[4]) : NULL;
-        tone_vec_push(tones, &ev);
-        size_t end = ev.start_sample + ev.sample_count;
-        if (end > max_end) {
-            max_end = end;
-        }
-        if (advance) {
-            timeline_samples += ev.sample_count;
-            timeline_samples += (size_t)gap_samples;
+            break;
+        case NODE_REPEAT: {
+            const TimelineNode *body = node->body;
+            if (!timeline_compile(b, node->body)) {
+                return false;
+            }
+            node->advance = size_mul_sat(body->advance, node->count, &b->overflow);
+            node->tones = size_mul_sat(body->tones, node->count, &b->overflow);
+            if (body->tones > 0) {
+                const size_t last = size_mul_sat(body->advance, node->count - 1, &b->overflow);
+                node->extent = size_add_sat(last, body->extent, &b->overflow);
+            }
+            node->speech = body->speech;
+            break;
         }
-        free(mode_clean);
     }
-    if (max_end < timeline_samples) {
-        max_end = timeline_samples;
-    }
-    *total_samples = max_end;
+    node->compiled = true;
     return true;
 }
 
+/* SAY rows become speech events at every position the timeline reaches them. */
+static void timeline_collect_speech(const TimelineNode *node,
+                                    size_t start,
+                                    int sr,
+                                    SpeechVec *speech) {
+    if (!node->speech) {
+        return;
+    }
+    switch (node->kind) {
+        case NODE_STEP:
+            parse_say_event(node->step->say, start, sr, speech);
+            break;
+        case NODE_SEQ:
+            for (size_t i = 0; i < node->count; ++i) {
+                timeline_collect_speech(node->items[i], start, sr, speech);
+                start += node->items[i]->advance;
+            }
+            break;
+        case NODE_REPEAT:
+            for (size_t r = 0; r < node->count; ++r) {
+                timeline_collect_speech(node->body, start, sr, speech);
+                start += node->body->advance;
+            }
+            break;
+    }
+}
+
+static void timeline_free(SequenceTimeline *timeline) {
+    if (timeline) {
+        arena_free(&timeline->arena);
+        free(timeline);
+    }
+}
+
+/* First timeline chunk from the source length, so short files do not hold a full chunk. */
+static size_t timeline_arena_chunk(size_t source_bytes) {
+    const size_t guess = source_bytes * TIMELINE_BYTES_PER_SOURCE;
+    if (guess < TIMELINE_CHUNK_MIN) {
+        return TIMELINE_CHUNK_MIN;
+    }
+    return guess > LOAD_ARENA_CHUNK ? LOAD_ARENA_CHUNK : guess;
+}
+
 bool sequence_load_file(const char *path,
                         const SequenceOptions *opts,
                         SequenceDocument *doc) {
@@ -1552,46 +2202,68 @@ bool sequence_load_file(const char *path,
         return false;
     }
     memset(doc, 0, sizeof(*doc));
-    CsvRowVec raw = {0}, macro_applied = {0}, expanded = {0};
+    memset(&load_stats, 0, sizeof(load_stats));
+    struct timespec t0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    /* rows, macros and scratch live in the arena; only the document outlives the load */
+    Arena arena;
+    arena_init(&arena, LOAD_ARENA_CHUNK);
+    SequenceTimeline *timeline = xcalloc(1, sizeof(*timeline));
+    MappedFile file = {0};
+    CsvRowVec raw = {0};
     MacroVec macros = {0};
-    ToneVec tones = {0};
+    NodeVec folded = {0}, expanded = {0};
     SpeechVec speech = {0};
+    TimelineBuild build = {&arena, &timeline->arena, &macros, opts, {0}, false};
     bool ok = false;
-    if (!load_sequence_rows(path, &raw, &macros)) {
+    if (!mapped_file_open(path, &file)) {
         goto cleanup;
     }
-    if (!expand_macros(&raw, &macros, &macro_applied)) {
+    load_stats.bytes = file.size;
+    arena_init(&timeline->arena, timeline_arena_chunk(file.size));
+    if (!load_sequence_rows(&arena, &file, &raw, &macros)) {
         goto cleanup;
     }
-    if (!expand_repeats(&macro_applied, &expanded)) {
+    if (raw.len == 0) {
+        fprintf(stderr, "synthrave: %s contains no rows\n", path);
         goto cleanup;
     }
-    size_t total_samples = 0;
-    if (!build_sequence_events(&expanded, opts, &tones, &speech, &total_samples)) {
+    if (!fold_macros(&build, &raw, &folded)) {
         goto cleanup;
     }
-    doc->tones = tones.items;
-    doc->tone_count = tones.len;
+    expand_repeat_nodes(&build, &folded, &expanded);
+    TimelineNode *root = node_seq(&build, &expanded);
+    if (!timeline_compile(&build, root)) {
+        goto cleanup;
+    }
+    if (build.overflow) {
+        fprintf(stderr, "synthrave: %s unrolls to more than fits in memory addresses\n", path);
+        goto cleanup;
+    }
+    timeline_collect_speech(root, 0, opts->sample_rate, &speech);
+    timeline->root = root;
+    doc->timeline = timeline;
+    doc->tone_count = root->tones;
     doc->speech = speech.items;
     doc->speech_count = speech.len;
-    doc->total_samples = total_samples;
-    tones.items = NULL;
+    doc->total_samples = root->extent > root->advance ? root->extent : root->advance;
+    load_stats.timeline_bytes = arena_bytes(&timeline->arena);
+    load_stats.allocations += timeline->arena.chunk_count;
+    timeline = NULL;
     speech.items = NULL;
     ok = true;
 
 cleanup:
-    csv_rowvec_free(&raw);
-    csv_rowvec_free(&macro_applied);
-    csv_rowvec_free(&expanded);
-    macro_vec_free(&macros);
+    load_stats.allocations += arena.chunk_count;
+    load_stats.arena_bytes = arena_bytes(&arena);
+    arena_free(&arena);
+    timeline_free(timeline);
+    mapped_file_close(&file);
+    struct timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    load_stats.load_ms =
+        (double)(t1.tv_sec - t0.tv_sec) * 1e3 + (double)(t1.tv_nsec - t0.tv_nsec) * 1e-6;
     if (!ok) {
-        for (size_t i = 0; i < tones.len; ++i) {
-            seqspec_free(&tones.items[i].left);
-            seqspec_free(&tones.items[i].right);
-            free(tones.items[i].mode_raw);
-            free(tones.items[i].flags_raw);
-        }
-        free(tones.items);
         for (size_t i = 0; i < speech.len; ++i) {
             speech_event_clear(&speech.items[i]);
         }
@@ -1600,11 +2272,94 @@ cleanup:
     return ok;
 }
 
+void sequence_load_stats(SequenceLoadStats *out) {
+    if (out) {
+        *out = load_stats;
+    }
+}
+
+static void cursor_push(SequenceCursor *cur, const TimelineNode *node) {
+    if (cur->depth == cur->cap) {
+        cur->cap = cur->cap ? cur->cap * 2 : 16;
+        cur->stack = xrealloc(cur->stack, cur->cap * sizeof(*cur->stack));
+    }
+    cur->stack[cur->depth].node = node;
+    cur->stack[cur->depth].index = 0;
+    ++cur->depth;
+}
+
+void sequence_cursor_init(SequenceCursor *cur, const SequenceDocument *doc) {
+    if (!cur) {
+        return;
+    }
+    memset(cur, 0, sizeof(*cur));
+    cur->doc = doc;
+    if (!doc) {
+        return;
+    }
+    if (doc->timeline) {
+        cursor_push(cur, doc->timeline->root);
+        cur->ordered = true;
+        return;
+    }
+    cur->ordered = true;
+    for (size_t i = 1; i < doc->tone_count; ++i) {
+        if (doc->tones[i].start_sample < doc->tones[i - 1].start_sample) {
+            cur->ordered = false;
+            break;
+        }
+    }
+}
+
+bool sequence_cursor_next(SequenceCursor *cur, SeqToneEvent *out) {
+    if (!cur || !cur->doc || !out) {
+        return false;
+    }
+    if (!cur->doc->timeline) {
+        if (!cur->doc->tones || cur->next >= cur->doc->tone_count) {
+            return false;
+        }
+        *out = cur->doc->tones[cur->next++];
+        return true;
+    }
+    while (cur->depth > 0) {
+        SequenceCursorFrame *top = &cur->stack[cur->depth - 1];
+        const TimelineNode *node = top->node;
+        if (top->index >= node->count) {
+            --cur->depth;
+            continue;
+        }
+        const TimelineNode *child =
+            node->kind == NODE_SEQ ? node->items[top->index] : node->body;
+        ++top->index;
+        if (child->tones == 0) {
+            cur->position += child->advance;
+            continue;
+        }
+        if (child->kind == NODE_STEP) {
+            *out = child->step->tone;
+            out->start_sample = cur->position;
+            cur->position += child->advance;
+            return true;
+        }
+        cursor_push(cur, child);
+    }
+    return false;
+}
+
+void sequence_cursor_free(SequenceCursor *cur) {
+    if (cur) {
+        free(cur->stack);
+        cur->stack = NULL;
+        cur->depth = cur->cap = 0;
+    }
+}
+
 void sequence_document_free(SequenceDocument *doc) {
     if (!doc) {
         return;
     }
-    for (size_t i = 0; i < doc->tone_count; ++i) {
+    for (size_t i = 0; doc->tones && i < doc->tone_count; ++i) {
         seqspec_free(&doc->tones[i].left);
         seqspec_free(&doc->tones[i].right);
         free(doc->tones[i].mode_raw);
@@ -1613,6 +2368,8 @@ void sequence_document_free(SequenceDocument *doc) {
     free(doc->tones);
     doc->tones = NULL;
     doc->tone_count = 0;
+    timeline_free(doc->timeline);
+    doc->timeline = NULL;
     for (size_t i = 0; i < doc->speech_count; ++i) {
         speech_event_clear(&doc->speech[i]);
     }
@@ -1630,6 +2387,8 @@ bool sequence_build_from_tokens(const char *const *tokens,
         return false;
     }
     memset(doc, 0, sizeof(*doc));
+    Arena arena;
+    arena_init(&arena, 0);
     CsvRowVec rows = {0};
     ToneVec tones = {0};
     SpeechVec speech = {0};
@@ -1641,21 +2400,20 @@ bool sequence_build_from_tokens(const char *const *tokens,
             continue;
         }
         CsvRow row;
-        if (!parse_csv_line(raw, &row)) {
+        if (!parse_csv_line((StrView){raw, strlen(raw)}, &row)) {
             fprintf(stderr, "synthrave: token parse error: %s\n", raw);
             goto cleanup;
         }
-        if (!row.cols[0] || row.cols[0][0] == '\0') {
-            csv_row_free(&row);
+        if (!view_set(row.cols[0])) {
             continue;
         }
         normalize_inline_row(&row);
-        csv_rowvec_push(&rows, row);
+        csv_rowvec_push(&arena, &rows, row);
     }
     if (rows.len == 0) {
         goto cleanup;
     }
-    if (!build_sequence_events(&rows, opts, &tones, &speech, &total_samples)) {
+    if (!build_sequence_events(&arena, &rows, opts, &tones, &speech, &total_samples)) {
         goto cleanup;
     }
     doc->tones = tones.items;
@@ -1668,7 +2426,7 @@ bool sequence_build_from_tokens(const char *const *tokens,
     ok = true;
 
 cleanup:
-    csv_rowvec_free(&rows);
+    arena_free(&arena);
     if (!ok) {
         for (size_t i = 0; i < tones.len; ++i) {
             seqspec_free(&tones.items[i].left);
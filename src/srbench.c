@@ -0,0 +1,1254 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bake.h"
+#include "cpu_dispatch.h"
+#include "denormal.h"
+#include "filter.h"
+#include "instruments_ext.h"
+#include "midi_loader.h"
+#include "resampler.h"
+#include "scheduler.h"
+#include "sequence.h"
+#include "synth.h"
+#include "thread_pool.h"
+
+/*
+ * Offline render benchmark: loads a sequence once, renders it repeatedly
+ * without touching the audio device and reports time per render together
+ * with the realtime factor. Several control block sizes can be compared in
+ * one run, e.g. `srbench -cr 1,8,32,128 -f examples/minute_showcase.aox`.
+ */
+
+#define BENCH_MAX_SETTINGS 16
+/* Kernel benchmarks call their voices this many frames at a time. */
+#define BENCH_BLOCK 64u
+#define DENORMAL_BLOCK 512u
+#define DENORMAL_WARMUP_S 120.0f
+#define DENORMAL_MEASURE 16384u
+#define DENORMAL_PEAK 1e-36f
+#define RESAMPLE_SOURCE_S 24
+#define RESAMPLE_OUTPUT_S 5
+#define RESAMPLE_BLOCK 512u
+#define BAKE_REPORT_S 3
+#define FM_BENCH_VOICES 16u
+#define FM_BENCH_S 5
+#define FILTER_BENCH_VOICES 16u
+#define FILTER_BENCH_S 5
+#define FILTER_BENCH_RAMP 512u
+#define KERNEL_BENCH_S 20
+#define TRACK_BENCH_MAX 32u
+#define TRACK_BENCH_NOTES 160u
+#define TRACK_BENCH_S 10
+#define LOAD_BENCH_LINES 100000u
+#define LOOKUP_BENCH_MACROS 10000u
+#define LOOKUP_BENCH_SAMPLES 1000u
+#define LOOKUP_BENCH_REFS 50000u
+#define LOOKUP_BENCH_SAMPLE_FRAMES 64u
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static bool parse_int(const char *s, int *out) {
+    if (!s) {
+        return false;
+    }
+    char *end = NULL;
+    long v = strtol(s, &end, 10);
+    if (end == s || *end != '\0') {
+        return false;
+    }
+    *out = (int)v;
+    return true;
+}
+
+static int parse_int_list(const char *s, int *out, int max) {
+    char buf[256];
+    strncpy(buf, s, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    int count = 0;
+    for (char *tok = strtok(buf, ","); tok && count < max; tok = strtok(NULL, ",")) {
+        int v = 0;
+        if (!parse_int(tok, &v) || v <= 0) {
+            return -1;
+        }
+        out[count++] = v;
+    }
+    return count;
+}
+
+/*
+ * Denormal stall benchmark: each kernel renders a note until its output has
+ * decayed to just above the subnormal range, then the next DENORMAL_MEASURE
+ * samples, where the tail drifts through subnormals, are timed. Runs without
+ * protection have FTZ/DAZ off and software flushing disabled.
+ */
+typedef union {
+    HatState hat;
+    SnareState snare;
+    EgtrState egtr;
+    BirdsState birds;
+    PianoState piano;
+    KarplusStrongState ks;
+} DenormalBenchState;
+
+typedef enum {
+    DENORMAL_HAT,
+    DENORMAL_SNARE,
+    DENORMAL_EGTR,
+    DENORMAL_BIRDS,
+    DENORMAL_PIANO,
+    DENORMAL_GUITAR,
+    DENORMAL_KERNEL_COUNT
+} DenormalKernel;
+
+static const char *const denormal_kernel_names[DENORMAL_KERNEL_COUNT] = {
+    "hat", "snare", "egtr", "birds", "piano", "guitar",
+};
+
+static void denormal_kernel_init(DenormalKernel kernel,
+                                 DenormalBenchState *st,
+                                 float *line,
+                                 size_t line_length,
+                                 float sr) {
+    switch (kernel) {
+        case DENORMAL_HAT:
+            hat_state_init(&st->hat, sr);
+            break;
+        case DENORMAL_SNARE:
+            snare_state_init(&st->snare, sr, 180.0f, 0.5f);
+            break;
+        case DENORMAL_EGTR:
+            egtr_state_init(&st->egtr, sr, 110.0f, 3.0f);
+            break;
+        case DENORMAL_BIRDS:
+            birds_state_init(&st->birds, sr);
+            break;
+        case DENORMAL_PIANO:
+            piano_state_init(&st->piano, sr, 220.0f);
+            break;
+        default:
+            ks_state_init(&st->ks, line, line_length, sr, 220.0f, 0.995f, 1u);
+            break;
+    }
+}
+
+static void denormal_kernel_process(DenormalKernel kernel,
+                                    DenormalBenchState *st,
+                                    const SynthBlockConfig *cfg,
+                                    float *out,
+                                    size_t frames) {
+    switch (kernel) {
+        case DENORMAL_HAT:
+            hat_process(&st->hat, cfg, out, frames);
+            break;
+        case DENORMAL_SNARE:
+            snare_process(&st->snare, cfg, out, frames);
+            break;
+        case DENORMAL_EGTR:
+            egtr_process(&st->egtr, cfg, out, frames);
+            break;
+        case DENORMAL_BIRDS:
+            birds_process(&st->birds, cfg, out, frames);
+            break;
+        case DENORMAL_PIANO:
+            piano_process(&st->piano, cfg, out, frames);
+            break;
+        default:
+            ks_process(&st->ks, cfg, 0.0f, out, frames);
+            break;
+    }
+}
+
+/** Returns ns/sample over the timed tail, or a negative value on failure. */
+static double denormal_kernel_time(DenormalKernel kernel, int sample_rate, bool protect) {
+    const float sr = (float)sample_rate;
+    const SynthBlockConfig cfg = {
+        .sample_rate = sr,
+        .block_duration = (float)DENORMAL_BLOCK / sr,
+        .control_block = 0,
+    };
+    const size_t line_length = ks_delay_length(sr, 220.0f);
+    float *line = calloc(line_length, sizeof(float));
+    if (!line) {
+        return -1.0;
+    }
+    DenormalMode mode;
+    if (protect) {
+        denormal_protect_begin(&mode);
+    }
+    denormal_flush_enabled = protect;
+
+    DenormalBenchState st;
+    memset(&st, 0, sizeof(st));
+    denormal_kernel_init(kernel, &st, line, line_length, sr);
+    float out[DENORMAL_BLOCK];
+    const size_t warmup = (size_t)(DENORMAL_WARMUP_S * sr);
+    for (size_t done = 0; done < warmup; done += DENORMAL_BLOCK) {
+        denormal_kernel_process(kernel, &st, &cfg, out, DENORMAL_BLOCK);
+        float peak = 0.0f;
+        for (size_t i = 0; i < DENORMAL_BLOCK; ++i) {
+            const float a = out[i] < 0.0f ? -out[i] : out[i];
+            peak = a > peak ? a : peak;
+        }
+        if (peak < DENORMAL_PEAK) {
+            break;
+        }
+    }
+    const double t0 = now_seconds();
+    for (size_t done = 0; done < DENORMAL_MEASURE; done += DENORMAL_BLOCK) {
+        denormal_kernel_process(kernel, &st, &cfg, out, DENORMAL_BLOCK);
+    }
+    const double elapsed = now_seconds() - t0;
+
+    denormal_flush_enabled = true;
+    if (protect) {
+        denormal_protect_end(&mode);
+    }
+    free(line);
+    return elapsed * 1e9 / (double)DENORMAL_MEASURE;
+}
+
+static int run_denormal_bench(int sample_rate, int iterations) {
+    printf("denormal tails at %d Hz, best of %d, ns/sample\n", sample_rate, iterations);
+    printf("%-8s %12s %12s %8s\n", "kernel", "unprotected", "protected", "ratio");
+    for (int k = 0; k < DENORMAL_KERNEL_COUNT; ++k) {
+        double best[2] = {0.0, 0.0};
+        for (int p = 0; p < 2; ++p) {
+            for (int it = 0; it < iterations; ++it) {
+                const double ns = denormal_kernel_time((DenormalKernel)k, sample_rate, p == 1);
+                if (ns < 0.0) {
+                    fprintf(stderr, "srbench: out of memory\n");
+                    return 1;
+                }
+                if (it == 0 || ns < best[p]) {
+                    best[p] = ns;
+                }
+            }
+        }
+        printf("%-8s %12.2f %12.2f %7.1fx\n", denormal_kernel_names[k], best[0], best[1],
+               best[1] > 0.0 ? best[0] / best[1] : 0.0);
+    }
+    return 0;
+}
+
+/*
+ * Resampler throughput: one voice reads a noisy multi-sine source at several
+ * ratios; output seconds rendered per wall-clock second is the number of
+ * such voices one core sustains in realtime.
+ */
+static int run_resampler_bench(int sample_rate, int iterations) {
+    static const double ratios[] = {0.5, 1.0, 48000.0 / 44100.0, 1.5, 2.0, 4.0};
+    const size_t source_len = (size_t)RESAMPLE_SOURCE_S * (size_t)sample_rate;
+    const size_t frames = (size_t)RESAMPLE_OUTPUT_S * (size_t)sample_rate;
+    float *source = malloc(source_len * sizeof(float));
+    if (!source) {
+        fprintf(stderr, "srbench: out of memory\n");
+        return 1;
+    }
+    for (size_t i = 0; i < source_len; ++i) {
+        const double t = (double)i / (double)sample_rate;
+        source[i] = (float)(0.4 * sin(2.0 * 3.14159265358979 * 440.0 * t) +
+                            0.2 * sin(2.0 * 3.14159265358979 * 5100.0 * t)) +
+                    0.05f * ((float)rand() / (float)RAND_MAX - 0.5f);
+    }
+    printf("resampler at %d Hz, best of %d, voices per core\n", sample_rate, iterations);
+    printf("%-8s %10s %10s\n", "ratio", "linear", "sinc");
+    for (size_t r = 0; r < sizeof(ratios) / sizeof(ratios[0]); ++r) {
+        double voices[2] = {0.0, 0.0};
+        for (int q = 0; q < 2; ++q) {
+            const ResampleQuality quality = q == 0 ? RESAMPLE_LINEAR : RESAMPLE_SINC;
+            for (int it = 0; it < iterations; ++it) {
+                Resampler rs;
+                float out[RESAMPLE_BLOCK];
+                resampler_init(&rs, source, source_len, ratios[r], quality);
+                const double t0 = now_seconds();
+                for (size_t done = 0; done < frames; done += RESAMPLE_BLOCK) {
+                    resampler_process(&rs, out, RESAMPLE_BLOCK);
+                }
+                const double elapsed = now_seconds() - t0;
+                const double v = elapsed > 0.0 ? (double)RESAMPLE_OUTPUT_S / elapsed : 0.0;
+                voices[q] = v > voices[q] ? v : voices[q];
+            }
+        }
+        printf("%-8.4f %10.0f %10.0f\n", ratios[r], voices[0], voices[1]);
+    }
+    free(source);
+    return 0;
+}
+
+/*
+ * Baked tables against the live kernels: each bakeable instrument renders
+ * on-grid and between-semitone pitches both ways through the mix API. SNR
+ * treats the live render as reference; EGTR adds noise, so it never matches
+ * closely. Table builds happen before timing.
+ */
+typedef union {
+    ChoirSynthState choir;
+    StrPadState strpad;
+    BellState bell;
+    EgtrState egtr;
+} BakeLiveState;
+
+static void bake_live_render(SeqSpecType type, float frequency, float sr, float *out,
+                             size_t frames) {
+    BakeLiveState st;
+    const SynthBlockConfig cfg = {
+        .sample_rate = sr,
+        .block_duration = (float)BENCH_BLOCK / sr,
+        .control_block = 0,
+    };
+    switch (type) {
+        case SEQ_SPEC_CHOIR:
+            choir_synth_init(&st.choir, sr, frequency, 0.4f);
+            break;
+        case SEQ_SPEC_STRPAD:
+            strpad_state_init(&st.strpad, sr, frequency);
+            break;
+        case SEQ_SPEC_BELL:
+            bell_state_init(&st.bell, sr, frequency);
+            break;
+        default:
+            egtr_state_init(&st.egtr, sr, frequency, 3.0f);
+            break;
+    }
+    for (size_t i = 0; i < frames; i += BENCH_BLOCK) {
+        const MixTarget mix = mix_target_mono(out + i, 1.0f);
+        switch (type) {
+            case SEQ_SPEC_CHOIR:
+                choir_synth_process_mix(&st.choir, &cfg, &mix, BENCH_BLOCK);
+                break;
+            case SEQ_SPEC_STRPAD:
+                strpad_process_mix(&st.strpad, &cfg, &mix, BENCH_BLOCK);
+                break;
+            case SEQ_SPEC_BELL:
+                bell_process_mix(&st.bell, &cfg, &mix, BENCH_BLOCK);
+                break;
+            default:
+                egtr_process_mix(&st.egtr, &cfg, &mix, BENCH_BLOCK);
+                break;
+        }
+    }
+}
+
+static void bake_table_render(SeqSpecType type, float frequency, int sample_rate, float *out,
+                              size_t frames) {
+    BakedVoice voice;
+    if (!baked_voice_init(&voice, type, frequency, sample_rate)) {
+        return;
+    }
+    for (size_t i = 0; i < frames; i += BENCH_BLOCK) {
+        const MixTarget mix = mix_target_mono(out + i, 1.0f);
+        baked_voice_process_mix(&voice, &mix, BENCH_BLOCK);
+    }
+}
+
+/*
+ * Pads play their settle section once and then wrap; the report renders at
+ * least two loop passes past the settle time and measures SNR only from the
+ * first wrap on, where the crossfade and the replayed section are heard.
+ */
+static size_t bake_report_frames(const BakedTable *table, int sample_rate, size_t *from) {
+    size_t frames = (size_t)BAKE_REPORT_S * (size_t)sample_rate;
+    *from = 0u;
+    if (table->loop_end != 0u) {
+        const size_t span = table->loop_end + (table->loop_end - table->loop_start);
+        frames = span > frames ? span : frames;
+        *from = table->loop_end;
+    }
+    return (frames + BENCH_BLOCK - 1u) & ~(size_t)(BENCH_BLOCK - 1u);
+}
+
+static int run_bake_report(int sample_rate, int iterations) {
+    static const SeqSpecType types[] = {SEQ_SPEC_CHOIR, SEQ_SPEC_STRPAD, SEQ_SPEC_BELL,
+                                        SEQ_SPEC_EGTR};
+    static const char *const names[] = {"choir", "strpad", "bell", "egtr"};
+    /* A2, C4 and A6 on the grid, then 30 and 50 cents off it */
+    static const float pitches[] = {110.0f, 261.63f, 1760.0f, 452.89f, 226.45f};
+    float *live = NULL;
+    float *baked = NULL;
+    size_t capacity = 0;
+    int status = 0;
+    DenormalMode mode;
+    denormal_protect_begin(&mode);
+    printf("baked vs live at %d Hz, at least %d s per note, best of %d\n", sample_rate,
+           BAKE_REPORT_S, iterations);
+    printf("%-8s %9s %7s %12s %12s %8s %9s\n", "inst", "Hz", "s", "live ns/s", "baked ns/s",
+           "speedup", "SNR dB");
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]) && status == 0; ++t) {
+        for (size_t p = 0; p < sizeof(pitches) / sizeof(pitches[0]); ++p) {
+            const float f = pitches[p];
+            const BakedTable *table = bake_table_get(types[t], f, sample_rate);
+            if (table == NULL) {
+                fprintf(stderr, "srbench: no %s table for %.2f Hz\n", names[t], f);
+                status = 1;
+                break;
+            }
+            size_t from = 0;
+            const size_t frames = bake_report_frames(table, sample_rate, &from);
+            if (from >= frames) {
+                fprintf(stderr, "srbench: %s at %.2f Hz has no frames past the loop\n",
+                        names[t], f);
+                status = 1;
+                break;
+            }
+            if (frames > capacity) {
+                float *grown_live = realloc(live, frames * sizeof(float));
+                live = grown_live ? grown_live : live;
+                float *grown_baked = realloc(baked, frames * sizeof(float));
+                baked = grown_baked ? grown_baked : baked;
+                if (!grown_live || !grown_baked) {
+                    fprintf(stderr, "srbench: out of memory\n");
+                    status = 1;
+                    break;
+                }
+                capacity = frames;
+            }
+            double best[2] = {0.0, 0.0};
+            for (int it = 0; it < iterations; ++it) {
+                for (int b = 0; b < 2; ++b) {
+                    float *out = b ? baked : live;
+                    memset(out, 0, frames * sizeof(float));
+                    const double t0 = now_seconds();
+                    if (b) {
+                        bake_table_render(types[t], f, sample_rate, out, frames);
+                    } else {
+                        bake_live_render(types[t], f, (float)sample_rate, out, frames);
+                    }
+                    const double ns = (now_seconds() - t0) * 1e9 / (double)frames;
+                    if (it == 0 || ns < best[b]) {
+                        best[b] = ns;
+                    }
+                }
+            }
+            double signal = 0.0;
+            double noise = 0.0;
+            for (size_t i = from; i < frames; ++i) {
+                const double d = (double)live[i] - (double)baked[i];
+                signal += (double)live[i] * (double)live[i];
+                noise += d * d;
+            }
+            const double snr = noise > 0.0 ? 10.0 * log10(signal / noise) : 999.0;
+            printf("%-8s %9.2f %7.2f %12.2f %12.2f %7.1fx %9.1f\n", names[t], f,
+                   (double)frames / (double)sample_rate, best[0], best[1],
+                   best[1] > 0.0 ? best[0] / best[1] : 0.0, snr);
+        }
+    }
+    denormal_protect_end(&mode);
+    free(live);
+    free(baked);
+    bake_tables_clear();
+    return status;
+}
+
+/*
+ * FM against layered sines: FM_BENCH_VOICES e-piano notes rendered by the
+ * scalar FM kernel, by the FM lane bank, and as the additive patch one would
+ * layer from CHORD/BELL tokens instead: body harmonics 1-4 and the tine
+ * sidebands 12-16, each with its own decay, through the packed partial bank.
+ * The additive patch cannot move energy between partials the way a decaying
+ * modulation index does, so it only matches the FM spectrum at one instant.
+ */
+static int run_fm_bench(int sample_rate, int iterations) {
+    static const float layer_ratio[] = {1.0f, 2.0f, 3.0f, 4.0f, 12.0f, 13.0f, 14.0f, 15.0f,
+                                        16.0f};
+    static const float layer_amp[] = {0.5f, 0.18f, 0.06f, 0.02f, 0.02f, 0.08f, 0.12f, 0.08f,
+                                      0.02f};
+    static const float layer_decay_s[] = {1.6f, 0.5f, 0.3f, 0.2f, 0.06f, 0.06f, 0.9f, 0.06f,
+                                          0.06f};
+    static const char *const methods[] = {"fm scalar", "fm bank", "layered sines"};
+    const float sr = (float)sample_rate;
+    const size_t frames = ((size_t)FM_BENCH_S * (size_t)sample_rate) &
+                          ~(size_t)(BENCH_BLOCK - 1u);
+    const SynthBlockConfig cfg = {
+        .sample_rate = sr,
+        .block_duration = (float)BENCH_BLOCK / sr,
+        .control_block = 0,
+    };
+    float *bus = calloc(2u * frames, sizeof(float));
+    FmState *fm = malloc(FM_BENCH_VOICES * sizeof(FmState));
+    PartialBank *layers = malloc(FM_BENCH_VOICES * sizeof(PartialBank));
+    if (!bus || !fm || !layers) {
+        fprintf(stderr, "srbench: out of memory\n");
+        free(bus);
+        free(fm);
+        free(layers);
+        return 1;
+    }
+    DenormalMode mode;
+    denormal_protect_begin(&mode);
+    printf("%u e-piano voices, %d s at %d Hz, best of %d\n", FM_BENCH_VOICES, FM_BENCH_S,
+           sample_rate, iterations);
+    printf("%-14s %14s %14s\n", "method", "ns/voice/smp", "voices/core");
+    for (size_t m = 0; m < sizeof(methods) / sizeof(methods[0]); ++m) {
+        double best = 0.0;
+        for (int it = 0; it < iterations; ++it) {
+            FmState *fm_ptrs[FM_BENCH_VOICES];
+            PartialBank *layer_ptrs[FM_BENCH_VOICES];
+            MixTarget mixes[FM_BENCH_VOICES];
+            const float gains[2] = {0.5f, 0.5f};
+            for (size_t v = 0; v < FM_BENCH_VOICES; ++v) {
+                const float f = 110.0f * powf(2.0f, (float)v / 12.0f);
+                fm_state_init(&fm[v], sr, f, FM_PATCH_EPIANO);
+                partial_bank_init(&layers[v]);
+                for (size_t h = 0; h < sizeof(layer_ratio) / sizeof(layer_ratio[0]); ++h) {
+                    partial_bank_add(&layers[v], f * layer_ratio[h], sr, layer_amp[h],
+                                     expf(-1.0f / (sr * layer_decay_s[h])));
+                }
+                fm_ptrs[v] = &fm[v];
+                layer_ptrs[v] = &layers[v];
+            }
+            const double t0 = now_seconds();
+            for (size_t i = 0; i < frames; i += BENCH_BLOCK) {
+                for (size_t v = 0; v < FM_BENCH_VOICES; ++v) {
+                    mixes[v] = mix_target_stereo(bus + i, bus + frames + i, gains);
+                }
+                if (m == 0) {
+                    for (size_t v = 0; v < FM_BENCH_VOICES; ++v) {
+                        fm_process_mix(&fm[v], &cfg, &mixes[v], BENCH_BLOCK);
+                    }
+                } else if (m == 1) {
+                    fm_bank_process_mix(fm_ptrs, FM_BENCH_VOICES, &cfg, mixes, BENCH_BLOCK);
+                } else {
+                    partial_bank_process_multi_mix(layer_ptrs, FM_BENCH_VOICES, mixes,
+                                                   BENCH_BLOCK);
+                }
+            }
+            const double ns = (now_seconds() - t0) * 1e9 / ((double)frames * FM_BENCH_VOICES);
+            if (it == 0 || ns < best) {
+                best = ns;
+            }
+        }
+        printf("%-14s %14.2f %14.0f\n", methods[m], best,
+               best > 0.0 ? 1e9 / (best * (double)sample_rate) : 0.0);
+    }
+    denormal_protect_end(&mode);
+    free(bus);
+    free(fm);
+    free(layers);
+    return 0;
+}
+
+/*
+ * Filter throughput: FILTER_BENCH_VOICES resonant low-passes over noise,
+ * each sweeping between two cutoffs with a coefficient ramp every
+ * FILTER_BENCH_RAMP frames, filtered one voice at a time through the scalar
+ * tick and FILTER_LANES voices at a time through the lane bank.
+ */
+static int run_filter_bench(int sample_rate, int iterations) {
+    static const char *const methods[] = {"biquad scalar", "biquad lanes", "svf scalar",
+                                          "svf lanes"};
+    const float sr = (float)sample_rate;
+    const size_t frames = ((size_t)FILTER_BENCH_S * (size_t)sample_rate) &
+                          ~(size_t)(FILTER_BENCH_RAMP - 1u);
+    float *data = malloc(FILTER_BENCH_VOICES * frames * sizeof(float));
+    if (!data) {
+        fprintf(stderr, "srbench: out of memory\n");
+        return 1;
+    }
+    uint32_t seed = 22222u;
+    for (size_t i = 0; i < FILTER_BENCH_VOICES * frames; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        data[i] = (float)(seed >> 8) / 8388608.0f - 1.0f;
+    }
+    BiquadCoeffs bq[FILTER_BENCH_VOICES][2];
+    SvfCoeffs sv[FILTER_BENCH_VOICES][2];
+    for (size_t v = 0; v < FILTER_BENCH_VOICES; ++v) {
+        const float lo = 200.0f + 50.0f * (float)v;
+        bq[v][0] = biquad_design(FILTER_LOWPASS, lo, 2.0f, sr);
+        bq[v][1] = biquad_design(FILTER_LOWPASS, lo * 8.0f, 2.0f, sr);
+        sv[v][0] = svf_design(FILTER_LOWPASS, lo, 2.0f, sr);
+        sv[v][1] = svf_design(FILTER_LOWPASS, lo * 8.0f, 2.0f, sr);
+    }
+    DenormalMode mode;
+    denormal_protect_begin(&mode);
+    printf("%u swept low-passes, %d s at %d Hz, cpu %s, best of %d\n", FILTER_BENCH_VOICES,
+           FILTER_BENCH_S, sample_rate, cpu_level_name(cpu_dispatch_level()), iterations);
+    printf("%-14s %14s %14s\n", "method", "ns/voice/smp", "voices/core");
+    for (size_t m = 0; m < sizeof(methods) / sizeof(methods[0]); ++m) {
+        double best = 0.0;
+        for (int it = 0; it < iterations; ++it) {
+            Biquad biquads[FILTER_BENCH_VOICES];
+            Svf svfs[FILTER_BENCH_VOICES];
+            Biquad *bq_ptrs[FILTER_BENCH_VOICES];
+            Svf *sv_ptrs[FILTER_BENCH_VOICES];
+            float *bufs[FILTER_BENCH_VOICES];
+            for (size_t v = 0; v < FILTER_BENCH_VOICES; ++v) {
+                biquad_init(&biquads[v], bq[v][0]);
+                svf_init(&svfs[v], sv[v][0]);
+                bq_ptrs[v] = &biquads[v];
+                sv_ptrs[v] = &svfs[v];
+            }
+            const double t0 = now_seconds();
+            for (size_t i = 0; i < frames; i += FILTER_BENCH_RAMP) {
+                const size_t target = (i / FILTER_BENCH_RAMP + 1u) & 1u;
+                for (size_t v = 0; v < FILTER_BENCH_VOICES; ++v) {
+                    bufs[v] = data + v * frames + i;
+                    if (m < 2) {
+                        biquad_ramp_to(&biquads[v], bq[v][target], FILTER_BENCH_RAMP);
+                    } else {
+                        svf_ramp_to(&svfs[v], sv[v][target], FILTER_BENCH_RAMP);
+                    }
+                }
+                switch (m) {
+                    case 0:
+                        for (size_t v = 0; v < FILTER_BENCH_VOICES; ++v) {
+                            biquad_process(&biquads[v], bufs[v], FILTER_BENCH_RAMP);
+                        }
+                        break;
+                    case 1:
+                        biquad_bank_process(bq_ptrs, bufs, FILTER_BENCH_VOICES,
+                                            FILTER_BENCH_RAMP);
+                        break;
+                    case 2:
+                        for (size_t v = 0; v < FILTER_BENCH_VOICES; ++v) {
+                            svf_process(&svfs[v], bufs[v], FILTER_BENCH_RAMP);
+                        }
+                        break;
+                    default:
+                        svf_bank_process(sv_ptrs, bufs, FILTER_BENCH_VOICES, FILTER_BENCH_RAMP);
+                        break;
+                }
+            }
+            const double ns =
+                (now_seconds() - t0) * 1e9 / ((double)frames * FILTER_BENCH_VOICES);
+            if (it == 0 || ns < best) {
+                best = ns;
+            }
+        }
+        printf("%-14s %14.2f %14.0f\n", methods[m], best,
+               best > 0.0 ? 1e9 / (best * (double)sample_rate) : 0.0);
+    }
+    denormal_protect_end(&mode);
+    free(data);
+    return 0;
+}
+
+/*
+ * Single-voice kernel cost per call length. 512 is the scheduler's mix block;
+ * 64 and 63 show what a fixed sub-block grid and its ragged edges would cost.
+ */
+static int run_kernel_bench(const SequenceOptions *opts, int iterations) {
+    static const char *const kernels[] = {"analog lead", "bass", "flute"};
+    static const size_t lengths[] = {63u, 64u, 512u};
+    const float sr = (float)opts->sample_rate;
+    const size_t frames = (size_t)KERNEL_BENCH_S * (size_t)opts->sample_rate;
+    float *bus = calloc(2u * 512u, sizeof(float));
+    if (!bus) {
+        fprintf(stderr, "srbench: out of memory\n");
+        return 1;
+    }
+    const SynthBlockConfig cfg = {
+        .sample_rate = sr,
+        .control_block = (size_t)opts->control_block,
+    };
+    const float gains[2] = {0.5f, 0.5f};
+    const MixTarget mix = mix_target_stereo(bus, bus + 512u, gains);
+    printf("single voices, %d s at %d Hz, cpu %s, best of %d\n", KERNEL_BENCH_S,
+           opts->sample_rate, cpu_level_name(cpu_dispatch_level()), iterations);
+    printf("%-12s %10s %10s %10s   ns/sample per call length\n", "kernel", "63", "64", "512");
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); ++k) {
+        printf("%-12s", kernels[k]);
+        for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); ++l) {
+            const size_t n = lengths[l];
+            double best = 0.0;
+            for (int it = 0; it < iterations; ++it) {
+                AnalogLeadState lead;
+                BassState bass;
+                FluteState flute;
+                analog_lead_init(&lead, sr, 220.0f, 0.001f);
+                analog_lead_set_target(&lead, 440.0f);
+                bass_state_init(&bass, sr, 55.0f);
+                flute_state_init(&flute, sr, 523.25f);
+                const double t0 = now_seconds();
+                for (size_t i = 0; i + n <= frames; i += n) {
+                    switch (k) {
+                        case 0:
+                            analog_lead_process_mix(&lead, &cfg, &mix, n);
+                            break;
+                        case 1:
+                            bass_process_mix(&bass, &cfg, &mix, n);
+                            break;
+                        default:
+                            flute_process_mix(&flute, &cfg, &mix, n);
+                            break;
+                    }
+                }
+                const double ns = (now_seconds() - t0) * 1e9 / (double)(frames / n * n);
+                if (it == 0 || ns < best) {
+                    best = ns;
+                }
+            }
+            printf(" %10.2f", best);
+        }
+        printf("\n");
+    }
+    free(bus);
+    return 0;
+}
+
+/*
+ * SynthEngine track scaling: songs of 1..TRACK_BENCH_MAX tracks with the
+ * same note density per track, rendered on one thread and with one thread
+ * per CPU, so the table shows how the parallel track stage scales with the
+ * track count (it cannot beat one thread on a single-CPU host).
+ */
+static int run_track_bench(int sample_rate, int iterations) {
+    static const SynthInstrument instruments[] = {
+        {SYNTH_INSTRUMENT_SINE, 0.01f, 0.1f, 0.8f, 0.3f},
+        {SYNTH_INSTRUMENT_SAW, 0.02f, 0.1f, 0.6f, 0.2f},
+        {SYNTH_INSTRUMENT_SQUARE, 0.01f, 0.2f, 0.5f, 0.1f},
+        {SYNTH_INSTRUMENT_TRIANGLE, 0.05f, 0.1f, 0.7f, 0.4f},
+    };
+    const unsigned int cpus = thread_pool_cpu_count();
+    SynthNoteEvent *events = malloc(TRACK_BENCH_MAX * TRACK_BENCH_NOTES * sizeof(SynthNoteEvent));
+    SynthTrack *tracks = malloc(TRACK_BENCH_MAX * sizeof(SynthTrack));
+    float *buffer = malloc((size_t)TRACK_BENCH_S * (size_t)sample_rate * 2u * sizeof(float));
+    if (!events || !tracks || !buffer) {
+        fprintf(stderr, "srbench: out of memory\n");
+        free(events);
+        free(tracks);
+        free(buffer);
+        return 1;
+    }
+    uint32_t seed = 4242u;
+    for (size_t t = 0; t < TRACK_BENCH_MAX; ++t) {
+        SynthNoteEvent *notes = events + t * TRACK_BENCH_NOTES;
+        for (size_t e = 0; e < TRACK_BENCH_NOTES; ++e) {
+            seed = seed * 1664525u + 1013904223u;
+            notes[e].start_time = (float)e * ((float)TRACK_BENCH_S - 1.0f) / TRACK_BENCH_NOTES;
+            notes[e].duration = 0.1f + (float)(seed >> 24) / 512.0f;
+            notes[e].frequency = 110.0f * powf(2.0f, (float)((seed >> 8) % 36u) / 12.0f);
+            notes[e].velocity = 0.6f;
+        }
+        tracks[t].instrument = &instruments[t % (sizeof(instruments) / sizeof(instruments[0]))];
+        tracks[t].events = notes;
+        tracks[t].event_count = TRACK_BENCH_NOTES;
+        tracks[t].gain = 0.2f;
+        tracks[t].pan = (float)(t % 5u) * 0.5f - 1.0f;
+    }
+    const size_t frames = (size_t)TRACK_BENCH_S * (size_t)sample_rate;
+    printf("%u notes per track, %d s at %d Hz, %u cpus, best of %d\n", TRACK_BENCH_NOTES,
+           TRACK_BENCH_S, sample_rate, cpus, iterations);
+    printf("%-8s %12s %12s %10s\n", "tracks", "1 thread", "threads", "speedup");
+    for (size_t count = 1; count <= TRACK_BENCH_MAX; count *= 2u) {
+        const SynthSong song = {tracks, count, (float)TRACK_BENCH_S};
+        double best[2] = {0.0, 0.0};
+        for (int mode = 0; mode < 2; ++mode) {
+            const SynthEngine engine = {(unsigned int)sample_rate, 2u, mode == 0 ? 1u : cpus};
+            for (int it = 0; it < iterations; ++it) {
+                const double t0 = now_seconds();
+                synth_engine_render(&engine, &song, buffer, frames);
+                const double ms = (now_seconds() - t0) * 1e3;
+                if (it == 0 || ms < best[mode]) {
+                    best[mode] = ms;
+                }
+            }
+        }
+        printf("%-8zu %9.1f ms %9.1f ms %9.2fx\n", count, best[0], best[1],
+               best[1] > 0.0 ? best[0] / best[1] : 0.0);
+    }
+    free(events);
+    free(tracks);
+    free(buffer);
+    return 0;
+}
+
+/*
+ * Generated .aox in the shape of tool output: notes with varying lengths
+ * and gaps, a macro call every 500 lines and a repeat marker every 1000.
+ */
+static bool write_load_bench_file(char *path) {
+    static const char *const tokens[] = {"C4", "E4", "G4", "A4", "KICK", "HAT",
+                                         "SNARE", "440", "220+330", "BASS@55"};
+    const int fd = mkstemp(path);
+    if (fd < 0) {
+        return false;
+    }
+    FILE *f = fdopen(fd, "w");
+    if (!f) {
+        close(fd);
+        return false;
+    }
+    fprintf(f, "@RIFF {\n  C4 , 60 , 0\n  E4 , 60 , 0 , BG\n  G4 , 60\n}\n");
+    uint32_t seed = 777u;
+    for (unsigned int i = 0; i < LOAD_BENCH_LINES; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        if (i % 1000u == 999u) {
+            fprintf(f, "-4 , 2\n");
+        } else if (i % 500u == 0u) {
+            fprintf(f, "@RIFF\n");
+        } else {
+            fprintf(f, "%s , %u , %u\n", tokens[(seed >> 8) % 10u], 20u + (seed >> 16) % 180u,
+                    (seed >> 24) % 10u);
+        }
+    }
+    return fclose(f) == 0;
+}
+
+/* Pipes and devices can be read only once, so repeated loads use a spooled copy. */
+static bool spool_load_bench_file(const char *src, char *path) {
+    FILE *in = fopen(src, "rb");
+    if (!in) {
+        return false;
+    }
+    const int fd = mkstemp(path);
+    FILE *out = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (!out) {
+        if (fd >= 0) {
+            close(fd);
+            unlink(path);
+        }
+        fclose(in);
+        return false;
+    }
+    char buf[4096];
+    size_t got;
+    bool ok = true;
+    while ((got = fread(buf, 1, sizeof(buf), in)) > 0) {
+        ok = ok && fwrite(buf, 1, got, out) == got;
+    }
+    ok = !ferror(in) && ok;
+    fclose(in);
+    ok = fclose(out) == 0 && ok;
+    if (!ok) {
+        unlink(path);
+    }
+    return ok;
+}
+
+/* .aox load cost: wall time, rows and heap allocations per load (see SequenceLoadStats). */
+static int run_load_bench(const char *seq_file, const SequenceOptions *opts, int iterations) {
+    char generated[] = "/tmp/srbench-load-XXXXXX";
+    const char *path = seq_file;
+    struct stat st;
+    bool temporary = false;
+    if (!path) {
+        if (!write_load_bench_file(generated)) {
+            fprintf(stderr, "srbench: cannot write %s\n", generated);
+            return 1;
+        }
+        path = generated;
+        temporary = true;
+    } else if (stat(path, &st) == 0 && !S_ISREG(st.st_mode)) {
+        if (!spool_load_bench_file(path, generated)) {
+            fprintf(stderr, "srbench: cannot copy %s to %s\n", path, generated);
+            return 1;
+        }
+        path = generated;
+        temporary = true;
+    }
+    SequenceLoadStats best = {0};
+    size_t tones = 0;
+    int rc = 0;
+    for (int it = 0; it < iterations; ++it) {
+        SequenceDocument doc = {0};
+        if (!sequence_load_file(path, opts, &doc)) {
+            fprintf(stderr, "srbench: failed to load %s\n", path);
+            rc = 1;
+            break;
+        }
+        SequenceLoadStats stats;
+        sequence_load_stats(&stats);
+        if (it == 0 || stats.load_ms < best.load_ms) {
+            best = stats;
+        }
+        tones = doc.tone_count;
+        sequence_document_free(&doc);
+    }
+    if (rc == 0) {
+        printf("%s: %zu bytes, %zu rows -> %zu tones\n", seq_file ? seq_file : "generated",
+               best.bytes, best.rows, tones);
+        printf("load best of %d: %.2f ms (%.0f rows/ms), %zu allocations (%.2f per tone)\n",
+               iterations, best.load_ms, best.load_ms > 0.0 ? (double)best.rows / best.load_ms : 0.0,
+               best.allocations, tones ? (double)best.allocations / (double)tones : 0.0);
+        printf("timeline kept %.1f KiB (%.1f bytes per tone), load scratch %.1f KiB\n",
+               (double)best.timeline_bytes / 1024.0,
+               tones ? (double)best.timeline_bytes / (double)tones : 0.0,
+               (double)best.arena_bytes / 1024.0);
+    }
+    if (temporary) {
+        unlink(generated);
+    }
+    sample_cache_clear();
+    return rc;
+}
+
+/* A library of LOOKUP_BENCH_MACROS two-row macros called in mixed case. */
+static bool write_macro_bench_file(char *path) {
+    const int fd = mkstemp(path);
+    if (fd < 0) {
+        return false;
+    }
+    FILE *f = fdopen(fd, "w");
+    if (!f) {
+        close(fd);
+        return false;
+    }
+    for (unsigned int m = 0; m < LOOKUP_BENCH_MACROS; ++m) {
+        fprintf(f, "@Pat%05u {\n  C4 , 10 , 0\n  E4 , 10\n}\n", m);
+    }
+    uint32_t seed = 99u;
+    for (unsigned int i = 0; i < LOOKUP_BENCH_REFS; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        fprintf(f, (seed & 1u) ? "@PAT%05u\n" : "@pat%05u\n", (seed >> 8) % LOOKUP_BENCH_MACROS);
+    }
+    return fclose(f) == 0;
+}
+
+static void put_le(unsigned char *p, uint32_t v, int bytes) {
+    for (int b = 0; b < bytes; ++b) {
+        p[b] = (unsigned char)(v >> (8 * b));
+    }
+}
+
+/* Short mono 16-bit WAV; the sample rate matches the render so no resampling runs. */
+static bool write_bench_wav(const char *path, int sample_rate, unsigned int index) {
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        return false;
+    }
+    const uint32_t data_bytes = LOOKUP_BENCH_SAMPLE_FRAMES * 2u;
+    unsigned char header[44];
+    memcpy(header, "RIFF", 4);
+    put_le(header + 4, 36u + data_bytes, 4);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put_le(header + 16, 16u, 4);
+    put_le(header + 20, 1u, 2); /* PCM */
+    put_le(header + 22, 1u, 2); /* mono */
+    put_le(header + 24, (uint32_t)sample_rate, 4);
+    put_le(header + 28, (uint32_t)sample_rate * 2u, 4);
+    put_le(header + 32, 2u, 2);
+    put_le(header + 34, 16u, 2);
+    memcpy(header + 36, "data", 4);
+    put_le(header + 40, data_bytes, 4);
+    bool ok = fwrite(header, 1, sizeof(header), f) == sizeof(header);
+    for (unsigned int n = 0; ok && n < LOOKUP_BENCH_SAMPLE_FRAMES; ++n) {
+        unsigned char le[2];
+        put_le(le, (n * 977u + index * 131u) % 20000u, 2);
+        ok = fwrite(le, 1, 2, f) == 2;
+    }
+    return fclose(f) == 0 && ok;
+}
+
+/* A kit of LOOKUP_BENCH_SAMPLES WAV files in `dir`, hit in random order. */
+static bool write_sample_bench_files(const char *dir, int sample_rate, char *seq_path) {
+    char wav[512];
+    for (unsigned int s = 0; s < LOOKUP_BENCH_SAMPLES; ++s) {
+        snprintf(wav, sizeof(wav), "%s/s%04u.wav", dir, s);
+        if (!write_bench_wav(wav, sample_rate, s)) {
+            return false;
+        }
+    }
+    snprintf(seq_path, 512, "%s/kit.aox", dir);
+    FILE *f = fopen(seq_path, "w");
+    if (!f) {
+        return false;
+    }
+    uint32_t seed = 123u;
+    for (unsigned int i = 0; i < LOOKUP_BENCH_REFS; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        fprintf(f, "WAV@%s/s%04u.wav , 10\n", dir, (seed >> 8) % LOOKUP_BENCH_SAMPLES);
+    }
+    return fclose(f) == 0;
+}
+
+static bool time_lookup_load(const char *label, const char *path, const SequenceOptions *opts,
+                             int iterations) {
+    double first = 0.0, best = 0.0;
+    size_t tones = 0;
+    for (int it = 0; it < iterations; ++it) {
+        SequenceDocument doc = {0};
+        if (!sequence_load_file(path, opts, &doc)) {
+            fprintf(stderr, "srbench: failed to load %s\n", path);
+            return false;
+        }
+        SequenceLoadStats stats;
+        sequence_load_stats(&stats);
+        if (it == 0) {
+            first = best = stats.load_ms;
+        } else if (stats.load_ms < best) {
+            best = stats.load_ms;
+        }
+        tones = doc.tone_count;
+        sequence_document_free(&doc);
+    }
+    printf("%-8s %8u refs -> %6zu tones  first %8.2f ms  best %8.2f ms  (%.0f ns/ref)\n", label,
+           LOOKUP_BENCH_REFS, tones, first, best, best * 1e6 / LOOKUP_BENCH_REFS);
+    return true;
+}
+
+/*
+ * Name lookups during load: LOOKUP_BENCH_MACROS macros and a kit of
+ * LOOKUP_BENCH_SAMPLES WAV files, each referenced LOOKUP_BENCH_REFS times.
+ * "first" includes reading the WAVs; later loads hit the sample cache.
+ */
+static int run_lookup_bench(const SequenceOptions *opts, int iterations) {
+    char macro_path[] = "/tmp/srbench-macros-XXXXXX";
+    char kit_dir[] = "/tmp/srbench-kit-XXXXXX";
+    char kit_path[512];
+    int rc = 0;
+    if (!write_macro_bench_file(macro_path)) {
+        fprintf(stderr, "srbench: cannot write %s\n", macro_path);
+        return 1;
+    }
+    if (!mkdtemp(kit_dir)) {
+        fprintf(stderr, "srbench: cannot create %s\n", kit_dir);
+        unlink(macro_path);
+        return 1;
+    }
+    sample_cache_clear();
+    if (!write_sample_bench_files(kit_dir, opts->sample_rate, kit_path)) {
+        fprintf(stderr, "srbench: cannot write sample kit in %s\n", kit_dir);
+        rc = 1;
+    }
+    printf("%u macros, %u samples, best of %d\n", LOOKUP_BENCH_MACROS, LOOKUP_BENCH_SAMPLES,
+           iterations);
+    if (rc == 0 && (!time_lookup_load("macros", macro_path, opts, iterations) ||
+                    !time_lookup_load("samples", kit_path, opts, iterations))) {
+        rc = 1;
+    }
+    sample_cache_clear();
+    unlink(macro_path);
+    char wav[512];
+    for (unsigned int s = 0; s < LOOKUP_BENCH_SAMPLES; ++s) {
+        snprintf(wav, sizeof(wav), "%s/s%04u.wav", kit_dir, s);
+        unlink(wav);
+    }
+    unlink(kit_path);
+    rmdir(kit_dir);
+    return rc;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage:\n"
+            "  %s [options] token [token...]\n"
+            "  %s [options] -f file.aox | -m file.mid\n"
+            "  %s [options] -denormals | -resampler | -bakereport | -fm | -filters | -kernels\n"
+            "  %s [options] -tracks | -load [-f file.aox] | -lookups\n"
+            "Options:\n"
+            "  -sr <rate>       Sample rate (default 44100)\n"
+            "  -n <count>       Renders per setting (default 5)\n"
+            "  -cr <a,b,...>    Control block sizes to compare (default 32)\n"
+            "  -denormals       Time decaying kernels with and without FTZ/DAZ\n"
+            "  -resampler       Sample-voice resampler throughput per quality\n"
+            "  -bake <list>     Render baked instruments from tables (as synthrave -bake)\n"
+            "  -bakereport      Baked tables vs live kernels: cost and SNR per note\n"
+            "  -fm              FM voices (scalar, lane bank) vs a layered-sines patch\n"
+            "  -filters         Swept biquad/SVF filters, scalar vs lane bank\n"
+            "  -kernels         Single-voice kernels at 63, 64 and 512 frames per call\n"
+            "  -tracks          SynthEngine render time vs track count, 1 vs all threads\n"
+            "  -load            .aox load time and allocations (generated file without -f)\n"
+            "  -lookups         Load time with 10k macros and a 1k-sample WAV kit\n",
+            prog, prog, prog, prog);
+}
+
+int main(int argc, char **argv) {
+    SequenceOptions opts = {
+        .sample_rate = 44100,
+        .default_duration_ms = 120,
+        .fade_ms = 8,
+        .control_block = 32,
+    };
+    int iterations = 5;
+    int control_blocks[BENCH_MAX_SETTINGS] = {32};
+    int control_count = 1;
+    const char *seq_file = NULL;
+    const char *mid_file = NULL;
+    bool denormals = false;
+    bool resampler = false;
+    bool bake_report = false;
+    bool fm = false;
+    bool filters = false;
+    bool kernels = false;
+    bool track_scaling = false;
+    bool load = false;
+    bool lookups = false;
+
+    int idx = 1;
+    while (idx < argc) {
+        if (strcmp(argv[idx], "-sr") == 0 && idx + 1 < argc) {
+            if (!parse_int(argv[idx + 1], &opts.sample_rate) || opts.sample_rate <= 0) {
+                fprintf(stderr, "invalid samplerate: %s\n", argv[idx + 1]);
+                return 1;
+            }
+            idx += 2;
+            continue;
+        }
+        if (strcmp(argv[idx], "-n") == 0 && idx + 1 < argc) {
+            if (!parse_int(argv[idx + 1], &iterations) || iterations <= 0) {
+                fprintf(stderr, "invalid count: %s\n", argv[idx + 1]);
+                return 1;
+            }
+            idx += 2;
+            continue;
+        }
+        if (strcmp(argv[idx], "-cr") == 0 && idx + 1 < argc) {
+            control_count = parse_int_list(argv[idx + 1], control_blocks, BENCH_MAX_SETTINGS);
+            if (control_count <= 0) {
+                fprintf(stderr, "invalid control blocks: %s\n", argv[idx + 1]);
+                return 1;
+            }
+            idx += 2;
+            continue;
+        }
+        if (strcmp(argv[idx], "-f") == 0 && idx + 1 < argc) {
+            seq_file = argv[idx + 1];
+            idx += 2;
+            continue;
+        }
+        if (strcmp(argv[idx], "-m") == 0 && idx + 1 < argc) {
+            mid_file = argv[idx + 1];
+            idx += 2;
+            continue;
+        }
+        if (strcmp(argv[idx], "-resampler") == 0) {
+            resampler = true;
+            ++idx;
+            continue;
+        }
+        if (strcmp(argv[idx], "-bake") == 0 && idx + 1 < argc) {
+            if (!bake_parse_list(argv[idx + 1], &opts.bake_mask)) {
+                fprintf(stderr, "invalid bake list: %s\n", argv[idx + 1]);
+                return 1;
+            }
+            idx += 2;
+            continue;
+        }
+        if (strcmp(argv[idx], "-bakereport") == 0) {
+            bake_report = true;
+            ++idx;
+            continue;
+        }
+        if (strcmp(argv[idx], "-fm") == 0) {
+            fm = true;
+            ++idx;
+            continue;
+        }
+        if (strcmp(argv[idx], "-filters") == 0) {
+            filters = true;
+            ++idx;
+            continue;
+        }
+        if (strcmp(argv[idx], "-kernels") == 0) {
+            kernels = true;
+            ++idx;
+            continue;
+        }
+        if (strcmp(argv[idx], "-tracks") == 0) {
+            track_scaling = true;
+            ++idx;
+            continue;
+        }
+        if (strcmp(argv[idx], "-load") == 0) {
+            load = true;
+            ++idx;
+            continue;
+        }
+        if (strcmp(argv[idx], "-lookups") == 0) {
+            lookups = true;
+            ++idx;
+            continue;
+        }
+        if (strcmp(argv[idx], "-denormals") == 0) {
+            denormals = true;
+            ++idx;
+            continue;
+        }
+        if (argv[idx][0] == '-') {
+            usage(argv[0]);
+            return 1;
+        }
+        break;
+    }
+
+    if (denormals) {
+        return run_denormal_bench(opts.sample_rate, iterations);
+    }
+    if (resampler) {
+        return run_resampler_bench(opts.sample_rate, iterations);
+    }
+    if (bake_report) {
+        return run_bake_report(opts.sample_rate, iterations);
+    }
+    if (fm) {
+        return run_fm_bench(opts.sample_rate, iterations);
+    }
+    if (filters) {
+        return run_filter_bench(opts.sample_rate, iterations);
+    }
+    if (kernels) {
+        return run_kernel_bench(&opts, iterations);
+    }
+    if (track_scaling) {
+        return run_track_bench(opts.sample_rate, iterations);
+    }
+    if (load) {
+        return run_load_bench(seq_file, &opts, iterations);
+    }
+    if (lookups) {
+        return run_lookup_bench(&opts, iterations);
+    }
+
+    SequenceDocument doc = {0};
+    bool ok = false;
+    if (mid_file) {
+        ok = sequence_load_midi(mid_file, &opts, &doc);
+    } else if (seq_file) {
+        ok = sequence_load_file(seq_file, &opts, &doc);
+    } else if (idx < argc) {
+        ok = sequence_build_from_tokens((const char *const *)(argv + idx),
+                                        argc - idx, &opts, &doc);
+    } else {
+        usage(argv[0]);
+        return 1;
+    }
+    if (!ok || doc.total_samples == 0) {
+        fprintf(stderr, "srbench: failed to parse sequence\n");
+        sequence_document_free(&doc);
+        return 1;
+    }
+
+    const double audio_s = (double)doc.total_samples / (double)opts.sample_rate;
+    printf("%zu tones, %.2f s audio at %d Hz, %d renders per setting, cpu %s\n",
+           doc.tone_count, audio_s, opts.sample_rate, iterations,
+           cpu_level_name(cpu_dispatch_level()));
+    for (int c = 0; c < control_count; ++c) {
+        opts.control_block = control_blocks[c];
+        double best = 0.0;
+        double sum = 0.0;
+        for (int it = 0; it < iterations; ++it) {
+            float *left = NULL;
+            float *right = NULL;
+            const double t0 = now_seconds();
+            scheduler_render_document(&doc, &opts, &left, &right);
+            const double elapsed = now_seconds() - t0;
+            free(left);
+            free(right);
+            sum += elapsed;
+            if (it == 0 || elapsed < best) {
+                best = elapsed;
+            }
+        }
+        printf("cr %4d: best %8.2f ms  mean %8.2f ms  %7.1fx realtime\n",
+               control_blocks[c], best * 1e3, sum / iterations * 1e3,
+               best > 0.0 ? audio_s / best : 0.0);
+    }
+
+    sequence_document_free(&doc);
+    sample_cache_clear();
+    bake_tables_clear();
+    return 0;
+}
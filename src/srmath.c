@@ -0,0 +1,519 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fast_math.h"
+#include "fixed_point.h"
+#include "midi_loader.h"
+#include "mix_kernels.h"
+#include "scheduler.h"
+#include "sequence.h"
+#include "synth.h"
+
+/*
+ * Accuracy harness for fast_math.h. It sweeps every approximation against
+ * double-precision libm and reports max error and throughput, then renders
+ * the instruments that use them (plus any -f/-m files) and either saves the
+ * result (-save dir) or reports SNR against a saved render (-ref dir).
+ * `make mathcheck` saves from a FAST_MATH=0 build and compares the default
+ * build against it. -fixed instead renders SynthEngine songs, and the s16
+ * playback of the tokens and files, through the float and the fixed-point
+ * path and fails if they drift apart by more than FIXED_MIN_SNR_DB or
+ * FIXED_MAX_LSB (`make fixedcheck`).
+ */
+
+#define SWEEP_POINTS (1u << 20)
+#define TIMING_BATCH 4096u
+#define TIMING_ROUNDS 256u
+#define MATH_MAX_ITEMS 64
+#define FIXED_MIN_SNR_DB 60.0
+#define FIXED_MAX_LSB 32
+
+typedef float (*UnaryFn)(float);
+typedef double (*RefFn)(double);
+typedef void (*BatchFn)(const float *restrict, float *restrict, size_t);
+
+typedef struct {
+    const char *name;
+    UnaryFn fast;
+    UnaryFn libm;
+    BatchFn fast_batch;
+    BatchFn libm_batch;
+    RefFn ref;
+    float lo;
+    float hi;
+    bool relative;
+} SweepCase;
+
+/* Batch loops let the timings see the inlined form; n is a multiple of 16 so they vectorize. */
+#define DEFINE_MATH_FN(name, expr)                                                      \
+    static float name##_fn(float x) { return expr; }                                    \
+    static void name##_batch(const float *restrict in, float *restrict out, size_t n) { \
+        n &= ~(size_t)15u;                                                              \
+        for (size_t i = 0; i < n; ++i) {                                                \
+            const float x = in[i];                                                      \
+            out[i] = expr;                                                              \
+        }                                                                               \
+    }
+
+DEFINE_MATH_FN(fast_sin, fast_sinf(x))
+DEFINE_MATH_FN(fast_exp2, fast_exp2f(x))
+DEFINE_MATH_FN(fast_log2, fast_log2f(x))
+DEFINE_MATH_FN(fast_tanh, fast_tanhf(x))
+DEFINE_MATH_FN(fast_pow, fast_powf(0.99f, x))
+DEFINE_MATH_FN(libm_sin, sinf(x))
+DEFINE_MATH_FN(libm_exp2, exp2f(x))
+DEFINE_MATH_FN(libm_log2, log2f(x))
+DEFINE_MATH_FN(libm_tanh, tanhf(x))
+DEFINE_MATH_FN(libm_pow, powf(0.99f, x))
+
+static double ref_pow(double x) { return pow((double)0.99f, x); }
+
+#define SWEEP_CASE(name, ref, lo, hi, relative) \
+    {#name, fast_##name##_fn, libm_##name##_fn, fast_##name##_batch, libm_##name##_batch, ref, lo, hi, relative}
+
+static const SweepCase sweep_cases[] = {
+    SWEEP_CASE(sin, sin, -1000.0f, 1000.0f, false),
+    SWEEP_CASE(exp2, exp2, -40.0f, 40.0f, true),
+    SWEEP_CASE(log2, log2, 1e-6f, 1e6f, false),
+    SWEEP_CASE(tanh, tanh, -12.0f, 12.0f, false),
+    SWEEP_CASE(pow, ref_pow, 0.0f, 4096.0f, true),
+};
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static double time_fn(BatchFn fn, const float *in, float *out) {
+    const double t0 = now_seconds();
+    for (unsigned r = 0; r < TIMING_ROUNDS; ++r) {
+        fn(in, out, TIMING_BATCH);
+    }
+    return (now_seconds() - t0) * 1e9 / (double)(TIMING_ROUNDS * TIMING_BATCH);
+}
+
+static void run_sweeps(void) {
+    static float in[TIMING_BATCH];
+    static float out[TIMING_BATCH];
+    printf("%-6s %12s %12s %12s %10s %10s\n", "func", "fast err", "libm err", "at x",
+           "fast ns", "libm ns");
+    for (size_t c = 0; c < sizeof(sweep_cases) / sizeof(sweep_cases[0]); ++c) {
+        const SweepCase *sc = &sweep_cases[c];
+        double worst_fast = 0.0;
+        double worst_libm = 0.0;
+        float worst_x = sc->lo;
+        for (uint32_t i = 0; i <= SWEEP_POINTS; ++i) {
+            const float x = sc->lo + (sc->hi - sc->lo) * ((float)i / (float)SWEEP_POINTS);
+            const double ref = sc->ref((double)x);
+            const double scale = sc->relative && ref != 0.0 ? fabs(ref) : 1.0;
+            const double ef = fabs((double)sc->fast(x) - ref) / scale;
+            const double el = fabs((double)sc->libm(x) - ref) / scale;
+            if (ef > worst_fast) {
+                worst_fast = ef;
+                worst_x = x;
+            }
+            worst_libm = el > worst_libm ? el : worst_libm;
+        }
+        for (size_t i = 0; i < TIMING_BATCH; ++i) {
+            in[i] = sc->lo + (sc->hi - sc->lo) * ((float)i / (float)TIMING_BATCH);
+        }
+        const double ns_fast = time_fn(sc->fast_batch, in, out);
+        const double ns_libm = time_fn(sc->libm_batch, in, out);
+        printf("%-6s %12.3e %12.3e %12.4g %10.2f %10.2f  (%s)\n", sc->name, worst_fast,
+               worst_libm, worst_x, ns_fast, ns_libm, sc->relative ? "relative" : "absolute");
+    }
+}
+
+/* Tokens covering every instrument whose per-sample path calls a dsp_* function. */
+static const char *const math_tokens[] = {
+    "EGTR", "BRASS", "ANALOGLEAD@C4", "ANALOGLEAD@A5",
+};
+
+/* Oscillator voices that -fixed also checks; the scheduler mixes them in integers. */
+static const char *const fixed_tokens[] = {
+    "440:500", "220~880:500", "261.6+329.6+392:500", "300,500:500",
+};
+
+typedef struct {
+    char name[128];
+    float *samples; /* interleaved stereo */
+    size_t frames;
+} MathRender;
+
+static bool render_document(const SequenceDocument *doc,
+                            const SequenceOptions *opts,
+                            MathRender *r) {
+    float *left = NULL;
+    float *right = NULL;
+    const size_t frames = scheduler_render_document(doc, opts, &left, &right);
+    if (frames == 0 || !left || !right) {
+        free(left);
+        free(right);
+        return false;
+    }
+    r->samples = malloc(frames * 2u * sizeof(float));
+    if (!r->samples) {
+        free(left);
+        free(right);
+        return false;
+    }
+    for (size_t i = 0; i < frames; ++i) {
+        r->samples[2u * i] = left[i];
+        r->samples[2u * i + 1u] = right[i];
+    }
+    r->frames = frames;
+    free(left);
+    free(right);
+    return true;
+}
+
+/* Legacy SynthEngine song: overlapping sine and square notes drive the soft clipper. */
+static bool render_engine_song(int sample_rate, MathRender *r) {
+    static const SynthInstrument sine = {SYNTH_INSTRUMENT_SINE, 0.01f, 0.1f, 0.8f, 0.3f};
+    static const SynthInstrument square = {SYNTH_INSTRUMENT_SQUARE, 0.01f, 0.1f, 0.6f, 0.3f};
+    static const SynthNoteEvent notes[] = {
+        {0.0f, 1.0f, 220.0f, 1.0f}, {0.25f, 1.0f, 277.2f, 1.0f},
+        {0.5f, 1.0f, 329.6f, 1.0f}, {1.0f, 1.5f, 440.0f, 1.0f},
+    };
+    const SynthTrack tracks[2] = {
+        {&sine, notes, 4, 1.0f, -0.5f},
+        {&square, notes, 4, 0.8f, 0.5f},
+    };
+    const SynthSong song = {tracks, 2, 0.0f};
+    const SynthEngine engine = {(unsigned int)sample_rate, 2u, 1u};
+    const size_t frames = synth_engine_frames_for_song(&engine, &song);
+    r->samples = calloc(frames * 2u, sizeof(float));
+    if (!r->samples) {
+        return false;
+    }
+    synth_engine_render(&engine, &song, r->samples, frames);
+    r->frames = frames;
+    return true;
+}
+
+/* Dense four-waveform song: up to 12 voices per track, short stages, hard pans. */
+static void fill_dense_notes(SynthNoteEvent *notes, size_t count, float base) {
+    for (size_t i = 0; i < count; ++i) {
+        notes[i].start_time = 0.05f * (float)i;
+        notes[i].duration = 0.3f + 0.01f * (float)(i % 7u);
+        notes[i].frequency = base * powf(2.0f, (float)(i % 24u) / 12.0f);
+        notes[i].velocity = 0.4f + 0.6f * (float)(i % 5u) / 4.0f;
+    }
+}
+
+static bool fixed_report(const char *name, size_t frames, double max_lsb, double signal,
+                         double noise) {
+    const double snr = noise > 0.0 ? 10.0 * log10(signal / noise) : INFINITY;
+    const bool ok = snr >= FIXED_MIN_SNR_DB && max_lsb <= (double)FIXED_MAX_LSB;
+    printf("%-32s %10zu frames  max diff %8.1f LSB  SNR %7.1f dB  %s\n", name, frames, max_lsb,
+           snr, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+static bool fixed_compare_song(const char *name, const SynthSong *song, int sample_rate) {
+    const SynthEngine engine = {(unsigned int)sample_rate, 2u, 1u};
+    const size_t frames = synth_engine_frames_for_song(&engine, song);
+    float *ref = calloc(frames * 2u, sizeof(float));
+    int16_t *fixed = calloc(frames * 2u, sizeof(int16_t));
+    if (!ref || !fixed) {
+        free(ref);
+        free(fixed);
+        return false;
+    }
+    SynthRenderState state;
+    synth_render_state_init(&state, song, 0.0f);
+    synth_engine_render_next(&engine, &state, ref, frames);
+    synth_render_state_free(&state);
+    synth_render_state_init(&state, song, 0.0f);
+    synth_engine_render_fixed(&engine, &state, fixed, frames);
+    synth_render_state_free(&state);
+
+    double signal = 0.0;
+    double noise = 0.0;
+    double max_lsb = 0.0;
+    for (size_t i = 0; i < frames * 2u; ++i) {
+        const double want = (double)ref[i] * 32767.0;
+        const double d = (double)fixed[i] - want;
+        signal += want * want;
+        noise += d * d;
+        max_lsb = fabs(d) > max_lsb ? fabs(d) : max_lsb;
+    }
+    free(ref);
+    free(fixed);
+    return fixed_report(name, frames, max_lsb, signal, noise);
+}
+
+/* Scheduler playback: the Q20 integer mix and its Q15 interleave against the float mix. */
+static bool fixed_compare_document(const char *name, const SequenceDocument *doc,
+                                   const SequenceOptions *opts) {
+    float *left = NULL;
+    float *right = NULL;
+    int32_t *qleft = NULL;
+    int32_t *qright = NULL;
+    /* both renders draw the same rand() noise */
+    srand(1);
+    const size_t frames = scheduler_render_document(doc, opts, &left, &right);
+    srand(1);
+    const size_t qframes = scheduler_render_document_q(doc, opts, &qleft, &qright);
+    int16_t *ref = frames ? malloc(frames * 2u * sizeof(int16_t)) : NULL;
+    int16_t *fixed = frames ? malloc(frames * 2u * sizeof(int16_t)) : NULL;
+    if (!ref || !fixed || qframes != frames) {
+        fprintf(stderr, "srmath: failed to render %s\n", name);
+        free(left);
+        free(right);
+        free(qleft);
+        free(qright);
+        free(ref);
+        free(fixed);
+        return false;
+    }
+    mix_interleave_s16(ref, left, right, frames, 1.0f);
+    scheduler_interleave_q15(fixed, qleft, qright, frames, 1.0f);
+    double signal = 0.0;
+    double noise = 0.0;
+    double max_lsb = 0.0;
+    for (size_t i = 0; i < frames * 2u; ++i) {
+        const double d = (double)fixed[i] - (double)ref[i];
+        signal += (double)ref[i] * (double)ref[i];
+        noise += d * d;
+        max_lsb = fabs(d) > max_lsb ? fabs(d) : max_lsb;
+    }
+    free(left);
+    free(right);
+    free(qleft);
+    free(qright);
+    free(ref);
+    free(fixed);
+    return fixed_report(name, frames, max_lsb, signal, noise);
+}
+
+static int run_fixed_check(const SequenceOptions *opts,
+                           const char *const *files,
+                           const bool *file_is_midi,
+                           size_t file_count) {
+    const int sample_rate = opts->sample_rate;
+    static const SynthInstrument sine = {SYNTH_INSTRUMENT_SINE, 0.01f, 0.1f, 0.8f, 0.3f};
+    static const SynthInstrument square = {SYNTH_INSTRUMENT_SQUARE, 0.01f, 0.1f, 0.6f, 0.3f};
+    static const SynthInstrument saw = {SYNTH_INSTRUMENT_SAW, 0.002f, 0.05f, 0.5f, 0.1f};
+    static const SynthInstrument triangle = {SYNTH_INSTRUMENT_TRIANGLE, 0.0f, 0.2f, 0.7f, 0.5f};
+    static const SynthNoteEvent notes[] = {
+        {0.0f, 1.0f, 220.0f, 1.0f}, {0.25f, 1.0f, 277.2f, 1.0f},
+        {0.5f, 1.0f, 329.6f, 1.0f}, {1.0f, 1.5f, 440.0f, 1.0f},
+    };
+    SynthNoteEvent dense[4][64];
+    for (size_t t = 0; t < 4u; ++t) {
+        fill_dense_notes(dense[t], 64u, 55.0f * (float)(t + 1u));
+    }
+
+    printf("fixed point %s for synth_engine_render_s16 and playback in this build\n",
+           SYNTHRAVE_FIXED_POINT ? "enabled" : "disabled");
+    printf("tolerance: SNR >= %.0f dB, max diff <= %d LSB of s16 against the float path\n",
+           FIXED_MIN_SNR_DB, FIXED_MAX_LSB);
+    const SynthTrack engine_tracks[2] = {
+        {&sine, notes, 4, 1.0f, -0.5f},
+        {&square, notes, 4, 0.8f, 0.5f},
+    };
+    const SynthTrack dense_tracks[4] = {
+        {&sine, dense[0], 64, 0.6f, -1.0f},
+        {&square, dense[1], 64, 0.3f, 1.0f},
+        {&saw, dense[2], 64, 0.4f, -0.3f},
+        {&triangle, dense[3], 64, 0.7f, 0.3f},
+    };
+    const SynthSong engine_song = {engine_tracks, 2, 0.0f};
+    const SynthSong dense_song = {dense_tracks, 4, 0.0f};
+    bool ok = fixed_compare_song("synth engine song", &engine_song, sample_rate);
+    ok = fixed_compare_song("dense four-waveform song", &dense_song, sample_rate) && ok;
+    for (size_t t = 0; t < sizeof(math_tokens) / sizeof(math_tokens[0]); ++t) {
+        SequenceDocument doc = {0};
+        const char *token = math_tokens[t];
+        ok = sequence_build_from_tokens(&token, 1, opts, &doc) &&
+             fixed_compare_document(token, &doc, opts) && ok;
+        sequence_document_free(&doc);
+    }
+    for (size_t t = 0; t < sizeof(fixed_tokens) / sizeof(fixed_tokens[0]); ++t) {
+        SequenceDocument doc = {0};
+        const char *token = fixed_tokens[t];
+        ok = sequence_build_from_tokens(&token, 1, opts, &doc) &&
+             fixed_compare_document(token, &doc, opts) && ok;
+        sequence_document_free(&doc);
+    }
+    {
+        /* the integer bus filters, with a high-pass pole close to 1 */
+        SequenceOptions filtered = *opts;
+        filtered.bus_highpass_hz = 40.0f;
+        filtered.bus_lowpass_hz = 8000.0f;
+        SequenceDocument doc = {0};
+        const char *token = fixed_tokens[2];
+        ok = sequence_build_from_tokens(&token, 1, &filtered, &doc) &&
+             fixed_compare_document("chord -hpf 40 -lpf 8000", &doc, &filtered) && ok;
+        sequence_document_free(&doc);
+    }
+    for (size_t fi = 0; fi < file_count; ++fi) {
+        SequenceDocument doc = {0};
+        const char *slash = strrchr(files[fi], '/');
+        const bool loaded = file_is_midi[fi] ? sequence_load_midi(files[fi], opts, &doc)
+                                             : sequence_load_file(files[fi], opts, &doc);
+        ok = loaded && fixed_compare_document(slash ? slash + 1 : files[fi], &doc, opts) && ok;
+        sequence_document_free(&doc);
+    }
+    sample_cache_clear();
+    return ok ? 0 : 1;
+}
+
+static bool save_render(const char *dir, size_t index, const MathRender *r) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/item%02zu.f32", dir, index);
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "srmath: cannot write %s\n", path);
+        return false;
+    }
+    const size_t n = r->frames * 2u;
+    const bool ok = fwrite(r->samples, sizeof(float), n, f) == n;
+    fclose(f);
+    return ok;
+}
+
+static void compare_render(const char *dir, size_t index, const MathRender *r) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/item%02zu.f32", dir, index);
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        printf("%-32s no reference\n", r->name);
+        return;
+    }
+    double signal = 0.0;
+    double noise = 0.0;
+    double max_diff = 0.0;
+    size_t compared = 0;
+    float ref;
+    while (compared < r->frames * 2u && fread(&ref, sizeof(float), 1, f) == 1) {
+        const double d = (double)r->samples[compared] - (double)ref;
+        signal += (double)ref * (double)ref;
+        noise += d * d;
+        max_diff = fabs(d) > max_diff ? fabs(d) : max_diff;
+        ++compared;
+    }
+    fclose(f);
+    const double snr = noise > 0.0 ? 10.0 * log10(signal / noise) : INFINITY;
+    printf("%-32s %10zu frames  max diff %10.3e  SNR %7.1f dB%s\n", r->name, r->frames,
+           max_diff, snr, compared == r->frames * 2u ? "" : "  (length differs)");
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage:\n"
+            "  %s [options] [-save dir | -ref dir] [-f file.aox]... [-m file.mid]...\n"
+            "  %s [-sr rate] -fixed [-f file.aox]... [-m file.mid]...\n"
+            "Options:\n"
+            "  -sr <rate>       Sample rate (default 44100)\n"
+            "  -save <dir>      Write renders to dir (run from a FAST_MATH=0 build)\n"
+            "  -ref <dir>       Report SNR of renders against dir\n"
+            "  -fixed           Check the fixed-point SynthEngine and playback paths\n"
+            "                   against float\n",
+            prog, prog);
+}
+
+int main(int argc, char **argv) {
+    SequenceOptions opts = {
+        .sample_rate = 44100,
+        .default_duration_ms = 120,
+        .fade_ms = 8,
+        .control_block = 32,
+    };
+    const char *save_dir = NULL;
+    const char *ref_dir = NULL;
+    const char *files[MATH_MAX_ITEMS];
+    bool file_is_midi[MATH_MAX_ITEMS];
+    size_t file_count = 0;
+    bool fixed_check = false;
+
+    for (int idx = 1; idx < argc; idx += 2) {
+        if (strcmp(argv[idx], "-fixed") == 0) {
+            fixed_check = true;
+            --idx;
+            continue;
+        }
+        if (idx + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+        const char *arg = argv[idx + 1];
+        if (strcmp(argv[idx], "-sr") == 0) {
+            opts.sample_rate = atoi(arg);
+            if (opts.sample_rate <= 0) {
+                fprintf(stderr, "invalid samplerate: %s\n", arg);
+                return 1;
+            }
+        } else if (strcmp(argv[idx], "-save") == 0) {
+            save_dir = arg;
+        } else if (strcmp(argv[idx], "-ref") == 0) {
+            ref_dir = arg;
+        } else if ((strcmp(argv[idx], "-f") == 0 || strcmp(argv[idx], "-m") == 0) &&
+                   file_count < MATH_MAX_ITEMS) {
+            file_is_midi[file_count] = argv[idx][1] == 'm';
+            files[file_count++] = arg;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (fixed_check) {
+        return run_fixed_check(&opts, files, file_is_midi, file_count);
+    }
+
+    printf("fast math %s in this build\n", SYNTHRAVE_FAST_MATH ? "enabled" : "disabled");
+    run_sweeps();
+    if (!save_dir && !ref_dir) {
+        return 0;
+    }
+
+    const size_t token_count = sizeof(math_tokens) / sizeof(math_tokens[0]);
+    size_t index = 0;
+    int rc = 0;
+    for (size_t item = 0; item < token_count + 1u + file_count; ++item) {
+        MathRender r = {0};
+        bool ok = false;
+        if (item < token_count) {
+            SequenceDocument doc = {0};
+            const char *token = math_tokens[item];
+            snprintf(r.name, sizeof(r.name), "%s", token);
+            ok = sequence_build_from_tokens(&token, 1, &opts, &doc) && render_document(&doc, &opts, &r);
+            sequence_document_free(&doc);
+        } else if (item == token_count) {
+            snprintf(r.name, sizeof(r.name), "synth engine song");
+            ok = render_engine_song(opts.sample_rate, &r);
+        } else {
+            const size_t fi = item - token_count - 1u;
+            SequenceDocument doc = {0};
+            const char *slash = strrchr(files[fi], '/');
+            snprintf(r.name, sizeof(r.name), "%s", slash ? slash + 1 : files[fi]);
+            ok = file_is_midi[fi] ? sequence_load_midi(files[fi], &opts, &doc)
+                                  : sequence_load_file(files[fi], &opts, &doc);
+            ok = ok && render_document(&doc, &opts, &r);
+            sequence_document_free(&doc);
+        }
+        if (!ok) {
+            fprintf(stderr, "srmath: failed to render %s\n", r.name);
+            rc = 1;
+        } else if (save_dir) {
+            if (!save_render(save_dir, index, &r)) {
+                rc = 1;
+            }
+        } else {
+            compare_render(ref_dir, index, &r);
+        }
+        free(r.samples);
+        ++index;
+    }
+    sample_cache_clear();
+    return rc;
+}
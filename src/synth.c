@@ -1,7 +1,14 @@
 #include "synth.h"
 
+#include "fast_math.h"
+#include "fixed_point.h"
+#include "mix_kernels.h"
+#include "oscillator.h"
+
 #include <math.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #ifndef M_PI
@@ -18,31 +25,23 @@ static float clampf(float value, float min, float max) {
     return value;
 }
 
-static float soft_clip(float x) {
-    return tanhf(x);
-}
-
-static float render_event_sample(const SynthTrack *track,
-                                  const SynthNoteEvent *event,
-                                  float relative_time) {
-    if (track == NULL || track->instrument == NULL || event == NULL) {
-        return 0.0f;
+static void *xcalloc(size_t n, size_t sz) {
+    void *ptr = calloc(n, sz);
+    if (!ptr) {
+        fprintf(stderr, "synthrave: out of memory\n");
+        exit(EXIT_FAILURE);
     }
+    return ptr;
+}
 
-    if (relative_time < 0.0f) {
-        return 0.0f;
-    }
+static float soft_clip(float x) {
+    return dsp_tanhf(x);
+}
 
-    const float max_time = event->duration + track->instrument->release + 0.01f;
-    if (relative_time > max_time) {
-        return 0.0f;
+static void soft_clip_block(float *buf, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        buf[i] = soft_clip(buf[i]);
     }
-
-    const float sample = synth_instrument_sample(track->instrument,
-                                                 event->frequency,
-                                                 relative_time,
-                                                 event->duration);
-    return sample * clampf(event->velocity, 0.0f, 1.0f);
 }
 
 float synth_song_estimate_length(const SynthSong *song) {
@@ -78,64 +77,314 @@ size_t synth_engine_frames_for_song(const SynthEngine *engine, const SynthSong *
     return (size_t)(length * (float)sample_rate);
 }
 
-void synth_engine_render_block(const SynthEngine *engine,
-                               const SynthSong *song,
-                               float start_time,
-                               float *buffer,
-                               size_t frame_count) {
-    if (engine == NULL || buffer == NULL || frame_count == 0) {
+static int compare_event_keys(const void *a, const void *b) {
+    const SynthEventKey *ka = a;
+    const SynthEventKey *kb = b;
+    if (ka->start_time != kb->start_time) {
+        return ka->start_time < kb->start_time ? -1 : 1;
+    }
+    return ka->index < kb->index ? -1 : (ka->index > kb->index ? 1 : 0);
+}
+
+void synth_render_state_init(SynthRenderState *state, const SynthSong *song, float start_time) {
+    if (state == NULL) {
+        return;
+    }
+    memset(state, 0, sizeof(*state));
+    state->song = song;
+    state->start_time = start_time;
+    if (song == NULL || song->tracks == NULL || song->track_count == 0) {
+        return;
+    }
+    /* voices start on worker threads, so the shared tables must exist first */
+    osc_tables_init();
+    fixed_tables_init();
+    state->tracks = xcalloc(song->track_count, sizeof(SynthTrackCursor));
+    state->track_count = song->track_count;
+    state->track_blocks = xcalloc(song->track_count * SYNTH_ENGINE_SPAN, sizeof(float));
+    for (size_t ti = 0; ti < song->track_count; ++ti) {
+        const SynthTrack *track = &song->tracks[ti];
+        SynthTrackCursor *cursor = &state->tracks[ti];
+        if (track->events == NULL || track->event_count == 0) {
+            continue;
+        }
+        cursor->order = xcalloc(track->event_count, sizeof(SynthEventKey));
+        cursor->active = xcalloc(track->event_count, sizeof(SynthActiveNote));
+        for (size_t ei = 0; ei < track->event_count; ++ei) {
+            cursor->order[ei].start_time = track->events[ei].start_time;
+            cursor->order[ei].index = ei;
+        }
+        qsort(cursor->order, track->event_count, sizeof(SynthEventKey), compare_event_keys);
+    }
+}
+
+void synth_render_state_free(SynthRenderState *state) {
+    if (state == NULL) {
+        return;
+    }
+    for (size_t ti = 0; ti < state->track_count; ++ti) {
+        free(state->tracks[ti].order);
+        free(state->tracks[ti].active);
+    }
+    free(state->tracks);
+    free(state->track_blocks);
+    free(state->track_blocks_q);
+    thread_pool_destroy(state->pool);
+    memset(state, 0, sizeof(*state));
+}
+
+static float frame_time(const SynthRenderState *state, size_t frame, unsigned int sample_rate) {
+    return state->start_time + ((float)(state->frame + frame) / (float)sample_rate);
+}
+
+/*
+ * Starts a voice for every event that begins within the next `frames`
+ * frames, at the first frame whose time has reached its start.
+ */
+static void cursor_activate(SynthRenderState *state,
+                            SynthTrackCursor *cursor,
+                            const SynthTrack *track,
+                            size_t frames,
+                            unsigned int sample_rate) {
+    const float last = frame_time(state, frames - 1u, sample_rate);
+    size_t skip = 0;
+    while (cursor->next < track->event_count && last >= cursor->order[cursor->next].start_time) {
+        const size_t index = cursor->order[cursor->next++].index;
+        const SynthNoteEvent *event = &track->events[index];
+        while (frame_time(state, skip, sample_rate) < event->start_time) {
+            ++skip;
+        }
+        size_t pos = cursor->active_count++;
+        while (pos > 0 && cursor->active[pos - 1].index > index) {
+            cursor->active[pos] = cursor->active[pos - 1];
+            --pos;
+        }
+        SynthActiveNote *note = &cursor->active[pos];
+        note->index = index;
+        note->skip = skip;
+        synth_voice_init(&note->voice, track->instrument, event->frequency, event->duration,
+                         event->velocity,
+                         frame_time(state, skip, sample_rate) - event->start_time,
+                         (float)sample_rate);
+    }
+}
+
+/*
+ * Adds the sounding voices into `out` (float) or `out_q` (Q20) and drops the
+ * ones that have released.
+ */
+static void cursor_render(SynthTrackCursor *cursor, float *out, int32_t *out_q, size_t frames) {
+    size_t kept = 0;
+    for (size_t a = 0; a < cursor->active_count; ++a) {
+        SynthActiveNote *note = &cursor->active[a];
+        const size_t skip = note->skip;
+        note->skip = 0;
+        const bool sounding =
+            out_q != NULL ? synth_voice_render_q(&note->voice, out_q + skip, frames - skip)
+                          : synth_voice_render(&note->voice, out + skip, frames - skip);
+        if (!sounding) {
+            continue;
+        }
+        if (kept != a) {
+            cursor->active[kept] = *note;
+        }
+        ++kept;
+    }
+    cursor->active_count = kept;
+}
+
+typedef struct {
+    SynthRenderState *state;
+    size_t frames;
+    unsigned int sample_rate;
+    bool fixed; /* render into track_blocks_q */
+} SynthSpanJob;
+
+/* Thread pool task: renders track `ti` of the current span into its block. */
+static void render_track_span(void *ctx, size_t ti) {
+    const SynthSpanJob *job = ctx;
+    SynthRenderState *state = job->state;
+    const SynthTrack *track = &state->song->tracks[ti];
+    float *out = NULL;
+    int32_t *out_q = NULL;
+    if (job->fixed) {
+        out_q = state->track_blocks_q + ti * SYNTH_ENGINE_SPAN;
+        memset(out_q, 0, job->frames * sizeof(int32_t));
+    } else {
+        out = state->track_blocks + ti * SYNTH_ENGINE_SPAN;
+        memset(out, 0, job->frames * sizeof(float));
+    }
+    if (track->events == NULL || track->event_count == 0) {
+        return;
+    }
+    SynthTrackCursor *cursor = &state->tracks[ti];
+    cursor_activate(state, cursor, track, job->frames, job->sample_rate);
+    if (cursor->active_count > 0) {
+        cursor_render(cursor, out, out_q, job->frames);
+    }
+}
+
+static void ensure_pool(const SynthEngine *engine, SynthRenderState *state) {
+    if (state->pool == NULL && engine->threads > 1u && state->track_count > 1u) {
+        const size_t threads =
+            engine->threads < state->track_count ? engine->threads : state->track_count;
+        state->pool = thread_pool_create((unsigned int)threads);
+    }
+}
+
+void synth_engine_render_next(const SynthEngine *engine,
+                              SynthRenderState *state,
+                              float *buffer,
+                              size_t frame_count) {
+    if (engine == NULL || state == NULL || buffer == NULL || frame_count == 0) {
         return;
     }
 
     const unsigned int sample_rate = engine->sample_rate ? engine->sample_rate : 44100u;
     const unsigned int channels = engine->channels == 1 ? 1u : 2u;
+    const SynthSong *song = state->song;
 
     memset(buffer, 0, sizeof(float) * frame_count * channels);
-    if (song == NULL) {
+    if (song == NULL || state->track_count == 0) {
         return;
     }
+    ensure_pool(engine, state);
 
-    for (size_t frame = 0; frame < frame_count; ++frame) {
-        const float t = start_time + ((float)frame / (float)sample_rate);
-        float mix_l = 0.0f;
-        float mix_r = 0.0f;
+    for (size_t start = 0; start < frame_count; start += SYNTH_ENGINE_SPAN) {
+        const size_t frames =
+            frame_count - start < SYNTH_ENGINE_SPAN ? frame_count - start : SYNTH_ENGINE_SPAN;
+        SynthSpanJob job = {state, frames, sample_rate, false};
+        thread_pool_run(state->pool, state->track_count, render_track_span, &job);
 
-        for (size_t ti = 0; ti < song->track_count; ++ti) {
+        float mix_l[SYNTH_ENGINE_SPAN] = {0.0f};
+        float mix_r[SYNTH_ENGINE_SPAN] = {0.0f};
+        for (size_t ti = 0; ti < state->track_count; ++ti) {
             const SynthTrack *track = &song->tracks[ti];
             if (track->events == NULL || track->event_count == 0) {
                 continue;
             }
+            const float gain = clampf(track->gain, 0.0f, 2.0f);
+            const float pan = clampf(track->pan, -1.0f, 1.0f);
+            mix_accumulate_pan(mix_l, mix_r, state->track_blocks + ti * SYNTH_ENGINE_SPAN,
+                               0.5f * (2.0f - (pan + 1.0f)) * gain, 0.5f * (pan + 1.0f) * gain,
+                               frames);
+        }
+        soft_clip_block(mix_l, frames);
+        soft_clip_block(mix_r, frames);
 
-            float track_sample = 0.0f;
-            for (size_t ei = 0; ei < track->event_count; ++ei) {
-                const SynthNoteEvent *event = &track->events[ei];
-                const float relative_time = t - event->start_time;
-                if (relative_time < 0.0f) {
-                    continue;
-                }
-                track_sample += render_event_sample(track, event, relative_time);
+        float *out = buffer + start * channels;
+        if (channels == 2u) {
+            for (size_t i = 0; i < frames; ++i) {
+                out[2u * i] = mix_l[i];
+                out[2u * i + 1u] = mix_r[i];
             }
+        } else {
+            memcpy(out, mix_l, frames * sizeof(float));
+        }
+        state->frame += frames;
+    }
+}
 
-            float gain = clampf(track->gain, 0.0f, 2.0f);
-            track_sample *= gain;
+void synth_engine_render_fixed(const SynthEngine *engine,
+                               SynthRenderState *state,
+                               int16_t *buffer,
+                               size_t frame_count) {
+    if (engine == NULL || state == NULL || buffer == NULL || frame_count == 0) {
+        return;
+    }
 
-            const float pan = clampf(track->pan, -1.0f, 1.0f);
-            const float left_scale = 0.5f * (2.0f - (pan + 1.0f));
-            const float right_scale = 0.5f * (pan + 1.0f);
+    const unsigned int sample_rate = engine->sample_rate ? engine->sample_rate : 44100u;
+    const unsigned int channels = engine->channels == 1 ? 1u : 2u;
+    const SynthSong *song = state->song;
 
-            mix_l += track_sample * left_scale;
-            mix_r += track_sample * right_scale;
-        }
+    memset(buffer, 0, sizeof(int16_t) * frame_count * channels);
+    if (song == NULL || state->track_count == 0) {
+        return;
+    }
+    if (state->track_blocks_q == NULL) {
+        state->track_blocks_q = xcalloc(state->track_count * SYNTH_ENGINE_SPAN, sizeof(int32_t));
+    }
+    ensure_pool(engine, state);
+
+    for (size_t start = 0; start < frame_count; start += SYNTH_ENGINE_SPAN) {
+        const size_t frames =
+            frame_count - start < SYNTH_ENGINE_SPAN ? frame_count - start : SYNTH_ENGINE_SPAN;
+        SynthSpanJob job = {state, frames, sample_rate, true};
+        thread_pool_run(state->pool, state->track_count, render_track_span, &job);
 
-        mix_l = soft_clip(mix_l);
-        mix_r = soft_clip(mix_r);
+        int32_t mix_l[SYNTH_ENGINE_SPAN] = {0};
+        int32_t mix_r[SYNTH_ENGINE_SPAN] = {0};
+        for (size_t ti = 0; ti < state->track_count; ++ti) {
+            const SynthTrack *track = &song->tracks[ti];
+            if (track->events == NULL || track->event_count == 0) {
+                continue;
+            }
+            /* pan and gain are per track, so the float-to-Q15 step stays out of the loop */
+            const float gain = clampf(track->gain, 0.0f, 2.0f);
+            const float pan = clampf(track->pan, -1.0f, 1.0f);
+            const int32_t gain_l = q_from_float(0.5f * (2.0f - (pan + 1.0f)) * gain, 15);
+            const int32_t gain_r = q_from_float(0.5f * (pan + 1.0f) * gain, 15);
+            const int32_t *src = state->track_blocks_q + ti * SYNTH_ENGINE_SPAN;
+            for (size_t i = 0; i < frames; ++i) {
+                mix_l[i] += q_mul(src[i], gain_l, 15);
+                mix_r[i] += q_mul(src[i], gain_r, 15);
+            }
+        }
+        for (size_t i = 0; i < frames; ++i) {
+            mix_l[i] = q_soft_clip(mix_l[i]);
+            mix_r[i] = q_soft_clip(mix_r[i]);
+        }
 
-        const size_t base_index = frame * channels;
-        buffer[base_index] = mix_l;
+        int16_t *out = buffer + start * channels;
         if (channels == 2u) {
-            buffer[base_index + 1u] = mix_r;
+            mix_interleave_q15(out, mix_l, mix_r, frames, 32768);
+        } else {
+            for (size_t i = 0; i < frames; ++i) {
+                out[i] = q15_saturate(mix_l[i]);
+            }
         }
+        state->frame += frames;
+    }
+}
+
+void synth_engine_render_s16(const SynthEngine *engine,
+                             SynthRenderState *state,
+                             int16_t *buffer,
+                             size_t frame_count) {
+#if SYNTHRAVE_FIXED_POINT
+    synth_engine_render_fixed(engine, state, buffer, frame_count);
+#else
+    if (engine == NULL || state == NULL || buffer == NULL || frame_count == 0) {
+        return;
+    }
+    const unsigned int channels = engine->channels == 1 ? 1u : 2u;
+    float span[SYNTH_ENGINE_SPAN * 2u];
+    for (size_t start = 0; start < frame_count; start += SYNTH_ENGINE_SPAN) {
+        const size_t frames =
+            frame_count - start < SYNTH_ENGINE_SPAN ? frame_count - start : SYNTH_ENGINE_SPAN;
+        synth_engine_render_next(engine, state, span, frames);
+        int16_t *out = buffer + start * channels;
+        for (size_t i = 0; i < frames * channels; ++i) {
+            const float v = clampf(span[i], -1.0f, 1.0f) * 32767.0f;
+            out[i] = (int16_t)lrintf(v);
+        }
+    }
+#endif
+}
+
+/* One-shot block: builds a throwaway render state, so prefer render_next for streams. */
+void synth_engine_render_block(const SynthEngine *engine,
+                               const SynthSong *song,
+                               float start_time,
+                               float *buffer,
+                               size_t frame_count) {
+    if (engine == NULL || buffer == NULL || frame_count == 0) {
+        return;
     }
+    SynthRenderState state;
+    synth_render_state_init(&state, song, start_time);
+    synth_engine_render_next(engine, &state, buffer, frame_count);
+    synth_render_state_free(&state);
 }
 
 void synth_engine_render(const SynthEngine *engine,
@@ -0,0 +1,123 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "thread_pool.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+struct ThreadPool {
+    pthread_t *workers;
+    unsigned int worker_count;
+    pthread_mutex_t lock;
+    pthread_cond_t work;  /* new tasks or shutdown */
+    pthread_cond_t done;  /* pending reached zero */
+    ThreadPoolTask task;
+    void *ctx;
+    size_t count;
+    size_t next;
+    size_t pending;
+    bool stop;
+};
+
+/* Claims and runs tasks until none are left; called and returns with the lock held. */
+static void pool_drain(ThreadPool *pool) {
+    while (pool->next < pool->count) {
+        const size_t index = pool->next++;
+        ThreadPoolTask task = pool->task;
+        void *ctx = pool->ctx;
+        pthread_mutex_unlock(&pool->lock);
+        task(ctx, index);
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+}
+
+static void *pool_worker(void *arg) {
+    ThreadPool *pool = arg;
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->stop) {
+        if (pool->next >= pool->count) {
+            pthread_cond_wait(&pool->work, &pool->lock);
+            continue;
+        }
+        pool_drain(pool);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+ThreadPool *thread_pool_create(unsigned int threads) {
+    ThreadPool *pool = calloc(1, sizeof(*pool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    const unsigned int workers = threads > 1u ? threads - 1u : 0u;
+    if (workers > 0u) {
+        pool->workers = calloc(workers, sizeof(pthread_t));
+        if (pool->workers == NULL) {
+            thread_pool_destroy(pool);
+            return NULL;
+        }
+    }
+    for (unsigned int i = 0; i < workers; ++i) {
+        if (pthread_create(&pool->workers[i], NULL, pool_worker, pool) != 0) {
+            break;
+        }
+        ++pool->worker_count;
+    }
+    return pool;
+}
+
+void thread_pool_destroy(ThreadPool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    for (unsigned int i = 0; i < pool->worker_count; ++i) {
+        pthread_join(pool->workers[i], NULL);
+    }
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
+
+void thread_pool_run(ThreadPool *pool, size_t count, ThreadPoolTask task, void *ctx) {
+    if (task == NULL || count == 0) {
+        return;
+    }
+    if (pool == NULL || pool->worker_count == 0u || count == 1u) {
+        for (size_t i = 0; i < count; ++i) {
+            task(ctx, i);
+        }
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->ctx = ctx;
+    pool->count = count;
+    pool->next = 0;
+    pool->pending = count;
+    pthread_cond_broadcast(&pool->work);
+    pool_drain(pool);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+unsigned int thread_pool_cpu_count(void) {
+    const long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 1 ? (unsigned int)n : 1u;
+}